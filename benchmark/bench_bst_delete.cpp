@@ -55,6 +55,31 @@ BENCHMARK_DEFINE_F(DeleteYggZBSTFixture, BM_BST_Deletion)(benchmark::State & sta
 }
 REGISTER(DeleteYggZBSTFixture, BM_BST_Deletion);
 
+/*
+ * Ygg's B-Tree
+ */
+using DeleteYggBBSTFixture =
+	BSTFixture<YggBTreeInterface<BasicTreeOptions>, DeleteExperiment, false, false, true, false>;
+BENCHMARK_DEFINE_F(DeleteYggBBSTFixture, BM_BST_Deletion)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto n : this->experiment_node_pointers) {
+			this->t.remove(*n);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (auto n : this->experiment_node_pointers) {
+			this->t.insert(*n);
+		}
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(DeleteYggBBSTFixture, BM_BST_Deletion);
+
 /*
  * Boost::Intrusive::Set
  */
@@ -31,6 +31,80 @@ REGISTER(InsertYggRBBSTFixture, BM_BST_Insertion)
 
 
 
+/*
+ * Ygg's Red-Black Tree, sorted batches
+ */
+using SortedInsertYggRBBSTFixture =
+    BSTFixture<YggRBTreeInterface<BasicTreeOptions>, SortedInsertExperiment, true, false, false, false>;
+BENCHMARK_DEFINE_F(SortedInsertYggRBBSTFixture, BM_BST_Insertion)(benchmark::State & state)
+{
+	std::sort(this->experiment_nodes.begin(), this->experiment_nodes.end());
+
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto & n : this->experiment_nodes) {
+			this->t.insert(n);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (auto & n : this->experiment_nodes) {
+			this->t.remove(n);
+		}
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(SortedInsertYggRBBSTFixture, BM_BST_Insertion)
+
+using BatchInsertYggRBBSTFixture =
+    BSTFixture<YggRBTreeInterface<BasicTreeOptions>, BatchInsertExperiment, true, false, false, false>;
+BENCHMARK_DEFINE_F(BatchInsertYggRBBSTFixture, BM_BST_Insertion)(benchmark::State & state)
+{
+	std::sort(this->experiment_nodes.begin(), this->experiment_nodes.end());
+
+	for (auto _ : state) {
+		this->papi.start();
+		this->t.insert_batch(this->experiment_nodes.begin(),
+		                     this->experiment_nodes.end());
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (auto & n : this->experiment_nodes) {
+			this->t.remove(n);
+		}
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(BatchInsertYggRBBSTFixture, BM_BST_Insertion)
+
+// Large batches are merged into the tree by splits and joins
+using MergeBatchInsertYggRBBSTFixture =
+    BSTFixture<YggRBTreeInterface<SizedTreeOptions>, MergeBatchInsertExperiment, true, false, false, false>;
+BENCHMARK_DEFINE_F(MergeBatchInsertYggRBBSTFixture, BM_BST_Insertion)(benchmark::State & state)
+{
+	std::sort(this->experiment_nodes.begin(), this->experiment_nodes.end());
+
+	for (auto _ : state) {
+		this->papi.start();
+		this->t.insert_batch(this->experiment_nodes.begin(),
+		                     this->experiment_nodes.end());
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (auto & n : this->experiment_nodes) {
+			this->t.remove(n);
+		}
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(MergeBatchInsertYggRBBSTFixture, BM_BST_Insertion)
+
 /*
  * Ygg's Zip Tree
  */
@@ -56,6 +130,30 @@ BENCHMARK_DEFINE_F(InsertYggZBSTFixture, BM_BST_Insertion)(benchmark::State & st
 }
 REGISTER(InsertYggZBSTFixture, BM_BST_Insertion);
 
+/*
+ * Ygg's B-Tree
+ */
+using InsertYggBBSTFixture =
+    BSTFixture<YggBTreeInterface<BasicTreeOptions>, InsertExperiment, true, false, false, false>;
+BENCHMARK_DEFINE_F(InsertYggBBSTFixture, BM_BST_Insertion)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto & n : this->experiment_nodes) {
+			this->t.insert(n);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (auto & n : this->experiment_nodes) {
+			this->t.remove(n);
+		}
+		state.ResumeTiming();
+	}
+	this->papi.report_and_reset(state);
+}
+REGISTER(InsertYggBBSTFixture, BM_BST_Insertion);
+
 /*
  * Boost::Intrusive::Set
  */
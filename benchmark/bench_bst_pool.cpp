@@ -0,0 +1,254 @@
+#ifndef BENCH_BST_POOL_HPP
+#define BENCH_BST_POOL_HPP
+
+#include <memory>
+
+#include "common_bst.hpp"
+
+/*
+ * Compares nodes that are allocated individually on the heap with nodes that
+ * are allocated from a ygg::NodePool. To simulate a long-running program, the
+ * heap is fragmented by short-lived allocations between the node allocations.
+ * Use the PAPI counters (e.g. --papi PAPI_L1_DCM,PAPI_L2_DCM) to see the
+ * effect on cache misses.
+ */
+template <class Interface, typename Experiment, bool use_pool>
+class NodeStorageFixture : public benchmark::Fixture {
+public:
+	using Node = typename Interface::Node;
+
+	static std::string
+	get_name()
+	{
+		auto experiment_c = Experiment{};
+		std::string name = std::string("BST :: ") +
+		                   boost::hana::to<char const *>(experiment_c) +
+		                   std::string(" :: ") + Interface::get_name();
+		return name;
+	}
+
+	void
+	set_name(std::string name)
+	{
+		this->SetName(name.c_str());
+	}
+
+	NodeStorageFixture() : rng(std::random_device{}()) {}
+
+	Node *
+	allocate(int val)
+	{
+		// TODO constexpr - if
+		if (use_pool) {
+			return this->pool.construct(val);
+		} else {
+			return new Node(val);
+		}
+	}
+
+	void
+	free(Node * n)
+	{
+		// TODO constexpr - if
+		if (use_pool) {
+			this->pool.destroy(n);
+		} else {
+			delete n;
+		}
+	}
+
+	void
+	SetUp(const ::benchmark::State & state)
+	{
+		this->papi.initialize();
+
+		size_t fixed_count = state.range(0);
+		size_t experiment_count = state.range(1);
+
+		std::uniform_int_distribution<> distr(std::numeric_limits<int>::min(),
+		                                      std::numeric_limits<int>::max());
+
+		std::uniform_int_distribution<size_t> noise_distr(8, 256);
+
+		for (size_t i = 0; i < fixed_count; ++i) {
+			// Fragment the heap
+			this->noise.emplace_back(new char[noise_distr(this->rng)]);
+
+			int val = distr(this->rng);
+			Node * n = this->allocate(val);
+			Interface::insert(this->t, *n);
+			this->fixed_nodes.push_back(n);
+			this->search_values.push_back(val);
+		}
+		std::shuffle(this->search_values.begin(), this->search_values.end(),
+		             this->rng);
+
+		for (size_t i = 0; i < experiment_count; ++i) {
+			this->experiment_values.push_back(distr(this->rng));
+		}
+
+		// Only every other noise allocation survives
+		for (size_t i = 0; i < this->noise.size(); i += 2) {
+			this->noise[i].reset();
+		}
+	}
+
+	void
+	TearDown(const ::benchmark::State & state)
+	{
+		Interface::clear(this->t);
+		for (Node * n : this->fixed_nodes) {
+			this->free(n);
+		}
+		this->fixed_nodes.clear();
+		this->search_values.clear();
+		this->experiment_values.clear();
+		this->noise.clear();
+	}
+
+	std::vector<Node *> fixed_nodes;
+	std::vector<Node *> experiment_nodes;
+	std::vector<int> search_values;
+	std::vector<int> experiment_values;
+
+	std::vector<std::unique_ptr<char[]>> noise;
+	ygg::NodePool<Node> pool;
+
+	std::mt19937 rng;
+
+	typename Interface::Tree t;
+
+	PapiMeasurements papi;
+};
+
+/*
+ * Ygg's Red-Black Tree, nodes on the heap
+ */
+using HeapNodesYggRBBSTFixture =
+    NodeStorageFixture<YggRBTreeInterface<BasicTreeOptions>, HeapNodesExperiment, false>;
+BENCHMARK_DEFINE_F(HeapNodesYggRBBSTFixture, BM_BST_NodeStorage)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			Node * n = this->allocate(val);
+			this->t.insert(*n);
+			this->experiment_nodes.push_back(n);
+		}
+		for (auto val : this->search_values) {
+			auto node = this->t.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (Node * n : this->experiment_nodes) {
+			this->t.remove(*n);
+			this->free(n);
+		}
+		this->experiment_nodes.clear();
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(HeapNodesYggRBBSTFixture, BM_BST_NodeStorage);
+
+/*
+ * Ygg's Red-Black Tree, nodes from a NodePool
+ */
+using PooledNodesYggRBBSTFixture =
+    NodeStorageFixture<YggRBTreeInterface<BasicTreeOptions>, PooledNodesExperiment, true>;
+BENCHMARK_DEFINE_F(PooledNodesYggRBBSTFixture, BM_BST_NodeStorage)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			this->experiment_nodes.push_back(this->pool.emplace_insert(this->t, val));
+		}
+		for (auto val : this->search_values) {
+			auto node = this->t.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (Node * n : this->experiment_nodes) {
+			this->pool.erase_and_free(this->t, *n);
+		}
+		this->experiment_nodes.clear();
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(PooledNodesYggRBBSTFixture, BM_BST_NodeStorage);
+
+/*
+ * Ygg's Zip Tree, nodes on the heap
+ */
+using HeapNodesYggZBSTFixture =
+    NodeStorageFixture<YggZTreeInterface<BasicTreeOptions>, HeapNodesExperiment, false>;
+BENCHMARK_DEFINE_F(HeapNodesYggZBSTFixture, BM_BST_NodeStorage)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			Node * n = this->allocate(val);
+			this->t.insert(*n);
+			this->experiment_nodes.push_back(n);
+		}
+		for (auto val : this->search_values) {
+			auto node = this->t.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (Node * n : this->experiment_nodes) {
+			this->t.remove(*n);
+			this->free(n);
+		}
+		this->experiment_nodes.clear();
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(HeapNodesYggZBSTFixture, BM_BST_NodeStorage);
+
+/*
+ * Ygg's Zip Tree, nodes from a NodePool
+ */
+using PooledNodesYggZBSTFixture =
+    NodeStorageFixture<YggZTreeInterface<BasicTreeOptions>, PooledNodesExperiment, true>;
+BENCHMARK_DEFINE_F(PooledNodesYggZBSTFixture, BM_BST_NodeStorage)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			this->experiment_nodes.push_back(this->pool.emplace_insert(this->t, val));
+		}
+		for (auto val : this->search_values) {
+			auto node = this->t.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+
+		state.PauseTiming();
+		for (Node * n : this->experiment_nodes) {
+			this->pool.erase_and_free(this->t, *n);
+		}
+		this->experiment_nodes.clear();
+		state.ResumeTiming();
+	}
+
+	this->papi.report_and_reset(state);
+}
+REGISTER(PooledNodesYggZBSTFixture, BM_BST_NodeStorage);
+
+#ifndef NOMAIN
+#include "main.hpp"
+#endif
+
+#endif
@@ -45,6 +45,75 @@ BENCHMARK_DEFINE_F(SearchYggZBSTFixture, BM_BST_Search)(benchmark::State & state
 }
 REGISTER(SearchYggZBSTFixture, BM_BST_Search);
 
+/*
+ * Ygg's Red-Black Tree, frozen into a SearchSnapshot
+ */
+class SnapshotKeyOf {
+public:
+	static int
+	get_key(const RBNode<BasicTreeOptions> & n)
+	{
+		return n.get_value();
+	}
+};
+
+using SnapshotSearchYggRBBSTFixture =
+	BSTFixture<YggRBTreeInterface<BasicTreeOptions>, SnapshotSearchExperiment, false, true, false, true>;
+BENCHMARK_DEFINE_F(SnapshotSearchYggRBBSTFixture, BM_BST_Search)(benchmark::State & state)
+{
+	ygg::SearchSnapshot<RBNode<BasicTreeOptions>, SnapshotKeyOf> snapshot(this->t);
+
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			auto node = snapshot.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+	}
+	this->papi.report_and_reset(state);
+}
+REGISTER(SnapshotSearchYggRBBSTFixture, BM_BST_Search);
+
+/*
+ * Ygg's Red-Black Tree, interleaved batched lookups
+ */
+using BatchSearchYggRBBSTFixture =
+	BSTFixture<YggRBTreeInterface<BasicTreeOptions>, BatchSearchExperiment, false, true, false, true>;
+BENCHMARK_DEFINE_F(BatchSearchYggRBBSTFixture, BM_BST_Search)(benchmark::State & state)
+{
+	std::vector<decltype(this->t.end())> results(this->experiment_values.size());
+
+	for (auto _ : state) {
+		this->papi.start();
+		this->t.find_batch(this->experiment_values.begin(),
+		                   this->experiment_values.end(), results.begin());
+		benchmark::DoNotOptimize(results.data());
+		this->papi.stop();
+	}
+	this->papi.report_and_reset(state);
+}
+REGISTER(BatchSearchYggRBBSTFixture, BM_BST_Search);
+
+/*
+ * Ygg's B-Tree
+ */
+using SearchYggBBSTFixture =
+	BSTFixture<YggBTreeInterface<BasicTreeOptions>, SearchExperiment, false, true, false, true>;
+BENCHMARK_DEFINE_F(SearchYggBBSTFixture, BM_BST_Search)(benchmark::State & state)
+{
+	for (auto _ : state) {
+		this->papi.start();
+		for (auto val : this->experiment_values) {
+			auto node = this->t.find(val);
+			benchmark::DoNotOptimize(node);
+		}
+		this->papi.stop();
+	}
+	this->papi.report_and_reset(state);
+}
+REGISTER(SearchYggBBSTFixture, BM_BST_Search);
+
 /*
  * Boost::Intrusive::Set
  */
@@ -0,0 +1,73 @@
+#ifndef BENCH_ITREE_DELETE_HPP
+#define BENCH_ITREE_DELETE_HPP
+
+#include "common_itree.hpp"
+
+template <class Fixture>
+void
+itree_delete(Fixture & f, benchmark::State & state)
+{
+	using Interface = typename Fixture::InterfaceType;
+
+	for (auto _ : state) {
+		f.papi.start();
+		for (auto n : f.experiment_node_pointers) {
+			Interface::remove(f.t, *n);
+		}
+		f.papi.stop();
+
+		state.PauseTiming();
+		for (auto n : f.experiment_node_pointers) {
+			Interface::insert(f.t, *n);
+		}
+		state.ResumeTiming();
+	}
+
+	f.papi.report_and_reset(state);
+}
+
+#define ITREE_DELETE_BENCHMARK(Name, Interface, Distribution)                  \
+	using Name = ITreeFixture<Interface, DeleteExperiment, Distribution, false,  \
+	                          false, true>;                                      \
+	BENCHMARK_DEFINE_F(Name, BM_ITree_Deletion)(benchmark::State & state)        \
+	{                                                                            \
+		itree_delete(*this, state);                                                \
+	}                                                                            \
+	REGISTER(Name, BM_ITree_Deletion)
+
+/*
+ * Ygg's Interval Tree
+ */
+ITREE_DELETE_BENCHMARK(DeleteYggITreeUniformFixture,
+                       YggITreeInterface<BasicITreeOptions>, UniformIntervals);
+ITREE_DELETE_BENCHMARK(DeleteYggITreeClusteredFixture,
+                       YggITreeInterface<BasicITreeOptions>,
+                       ClusteredIntervals);
+ITREE_DELETE_BENCHMARK(DeleteYggITreeNestedFixture,
+                       YggITreeInterface<BasicITreeOptions>, NestedIntervals);
+
+/*
+ * Boost::Intrusive::Multiset
+ */
+ITREE_DELETE_BENCHMARK(DeleteBISetUniformFixture, BoostITreeInterface,
+                       UniformIntervals);
+ITREE_DELETE_BENCHMARK(DeleteBISetClusteredFixture, BoostITreeInterface,
+                       ClusteredIntervals);
+ITREE_DELETE_BENCHMARK(DeleteBISetNestedFixture, BoostITreeInterface,
+                       NestedIntervals);
+
+/*
+ * std::multimap
+ */
+ITREE_DELETE_BENCHMARK(DeleteStdMultimapUniformFixture,
+                       StdMultimapITreeInterface, UniformIntervals);
+ITREE_DELETE_BENCHMARK(DeleteStdMultimapClusteredFixture,
+                       StdMultimapITreeInterface, ClusteredIntervals);
+ITREE_DELETE_BENCHMARK(DeleteStdMultimapNestedFixture,
+                       StdMultimapITreeInterface, NestedIntervals);
+
+#ifndef NOMAIN
+#include "main.hpp"
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BENCH_ITREE_INSERT_HPP
+#define BENCH_ITREE_INSERT_HPP
+
+#include "common_itree.hpp"
+
+template <class Fixture>
+void
+itree_insert(Fixture & f, benchmark::State & state)
+{
+	using Interface = typename Fixture::InterfaceType;
+
+	for (auto _ : state) {
+		f.papi.start();
+		for (auto & n : f.experiment_nodes) {
+			Interface::insert(f.t, n);
+		}
+		f.papi.stop();
+
+		state.PauseTiming();
+		for (auto & n : f.experiment_nodes) {
+			Interface::remove(f.t, n);
+		}
+		state.ResumeTiming();
+	}
+
+	f.papi.report_and_reset(state);
+}
+
+#define ITREE_INSERT_BENCHMARK(Name, Interface, Distribution)                  \
+	using Name = ITreeFixture<Interface, InsertExperiment, Distribution, true,   \
+	                          false, false>;                                     \
+	BENCHMARK_DEFINE_F(Name, BM_ITree_Insertion)(benchmark::State & state)       \
+	{                                                                            \
+		itree_insert(*this, state);                                                \
+	}                                                                            \
+	REGISTER(Name, BM_ITree_Insertion)
+
+/*
+ * Ygg's Interval Tree
+ */
+ITREE_INSERT_BENCHMARK(InsertYggITreeUniformFixture,
+                       YggITreeInterface<BasicITreeOptions>, UniformIntervals);
+ITREE_INSERT_BENCHMARK(InsertYggITreeClusteredFixture,
+                       YggITreeInterface<BasicITreeOptions>,
+                       ClusteredIntervals);
+ITREE_INSERT_BENCHMARK(InsertYggITreeNestedFixture,
+                       YggITreeInterface<BasicITreeOptions>, NestedIntervals);
+
+/*
+ * Boost::Intrusive::Multiset
+ */
+ITREE_INSERT_BENCHMARK(InsertBISetUniformFixture, BoostITreeInterface,
+                       UniformIntervals);
+ITREE_INSERT_BENCHMARK(InsertBISetClusteredFixture, BoostITreeInterface,
+                       ClusteredIntervals);
+ITREE_INSERT_BENCHMARK(InsertBISetNestedFixture, BoostITreeInterface,
+                       NestedIntervals);
+
+/*
+ * std::multimap
+ */
+ITREE_INSERT_BENCHMARK(InsertStdMultimapUniformFixture,
+                       StdMultimapITreeInterface, UniformIntervals);
+ITREE_INSERT_BENCHMARK(InsertStdMultimapClusteredFixture,
+                       StdMultimapITreeInterface, ClusteredIntervals);
+ITREE_INSERT_BENCHMARK(InsertStdMultimapNestedFixture,
+                       StdMultimapITreeInterface, NestedIntervals);
+
+#ifndef NOMAIN
+#include "main.hpp"
+#endif
+
+#endif
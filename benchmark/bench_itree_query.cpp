@@ -0,0 +1,90 @@
+#ifndef BENCH_ITREE_QUERY_HPP
+#define BENCH_ITREE_QUERY_HPP
+
+#include "common_itree.hpp"
+
+template <class Fixture>
+void
+itree_query(Fixture & f, benchmark::State & state)
+{
+	using Interface = typename Fixture::InterfaceType;
+
+	for (auto _ : state) {
+		f.papi.start();
+		for (const auto & q : f.experiment_queries) {
+			Interface::query(f.t, q,
+			                 [](const auto & n) { benchmark::DoNotOptimize(n); });
+		}
+		f.papi.stop();
+	}
+
+	f.papi.report_and_reset(state);
+}
+
+/*
+ * Every combination of data structure, interval distribution and query
+ * length (i.e., selectivity)
+ */
+#define ITREE_QUERY_BENCHMARK(Name, Interface, Distribution, Experiment,       \
+                              length)                                          \
+	using Name = ITreeFixture<Interface, Experiment, Distribution, false, true,  \
+	                          false, length>;                                    \
+	BENCHMARK_DEFINE_F(Name, BM_ITree_Query)(benchmark::State & state)           \
+	{                                                                            \
+		itree_query(*this, state);                                                 \
+	}                                                                            \
+	REGISTER(Name, BM_ITree_Query)
+
+#define ITREE_QUERY_SWEEP(Prefix, Interface, Distribution)                     \
+	ITREE_QUERY_BENCHMARK(Prefix##StabbingFixture, Interface, Distribution,      \
+	                      StabbingQueryExperiment, ITREE_STABBING_QUERY);        \
+	ITREE_QUERY_BENCHMARK(Prefix##ShortFixture, Interface, Distribution,         \
+	                      ShortQueryExperiment, ITREE_SHORT_QUERY);              \
+	ITREE_QUERY_BENCHMARK(Prefix##LongFixture, Interface, Distribution,          \
+	                      LongQueryExperiment, ITREE_LONG_QUERY)
+
+/*
+ * Ygg's Interval Tree
+ */
+ITREE_QUERY_SWEEP(QueryYggITreeUniform, YggITreeInterface<BasicITreeOptions>,
+                  UniformIntervals);
+ITREE_QUERY_SWEEP(QueryYggITreeClustered, YggITreeInterface<BasicITreeOptions>,
+                  ClusteredIntervals);
+ITREE_QUERY_SWEEP(QueryYggITreeNested, YggITreeInterface<BasicITreeOptions>,
+                  NestedIntervals);
+
+/*
+ * Ygg's Interval Tree, frozen into a nested containment list
+ */
+ITREE_QUERY_SWEEP(QuerySnapshotUniform,
+                  YggITreeSnapshotInterface<BasicITreeOptions>,
+                  UniformIntervals);
+ITREE_QUERY_SWEEP(QuerySnapshotClustered,
+                  YggITreeSnapshotInterface<BasicITreeOptions>,
+                  ClusteredIntervals);
+ITREE_QUERY_SWEEP(QuerySnapshotNested,
+                  YggITreeSnapshotInterface<BasicITreeOptions>,
+                  NestedIntervals);
+
+/*
+ * Boost::Intrusive::Multiset
+ */
+ITREE_QUERY_SWEEP(QueryBISetUniform, BoostITreeInterface, UniformIntervals);
+ITREE_QUERY_SWEEP(QueryBISetClustered, BoostITreeInterface, ClusteredIntervals);
+ITREE_QUERY_SWEEP(QueryBISetNested, BoostITreeInterface, NestedIntervals);
+
+/*
+ * std::multimap
+ */
+ITREE_QUERY_SWEEP(QueryStdMultimapUniform, StdMultimapITreeInterface,
+                  UniformIntervals);
+ITREE_QUERY_SWEEP(QueryStdMultimapClustered, StdMultimapITreeInterface,
+                  ClusteredIntervals);
+ITREE_QUERY_SWEEP(QueryStdMultimapNested, StdMultimapITreeInterface,
+                  NestedIntervals);
+
+#ifndef NOMAIN
+#include "main.hpp"
+#endif
+
+#endif
@@ -25,6 +25,32 @@ constexpr auto insert_experiment_c = BOOST_HANA_STRING("Insert");
 using InsertExperiment = decltype(insert_experiment_c);
 constexpr auto search_experiment_c = BOOST_HANA_STRING("Search");
 using SearchExperiment = decltype(search_experiment_c);
+constexpr auto sorted_insert_experiment_c = BOOST_HANA_STRING("Sorted Insert");
+using SortedInsertExperiment = decltype(sorted_insert_experiment_c);
+constexpr auto batch_insert_experiment_c = BOOST_HANA_STRING("Batch Insert");
+using BatchInsertExperiment = decltype(batch_insert_experiment_c);
+constexpr auto merge_batch_insert_experiment_c =
+    BOOST_HANA_STRING("Batch Insert (Constant Time Size)");
+using MergeBatchInsertExperiment = decltype(merge_batch_insert_experiment_c);
+constexpr auto heap_nodes_experiment_c =
+    BOOST_HANA_STRING("Insert + Search (Heap Nodes)");
+using HeapNodesExperiment = decltype(heap_nodes_experiment_c);
+constexpr auto pooled_nodes_experiment_c =
+    BOOST_HANA_STRING("Insert + Search (Pooled Nodes)");
+using PooledNodesExperiment = decltype(pooled_nodes_experiment_c);
+constexpr auto snapshot_search_experiment_c =
+    BOOST_HANA_STRING("Search (Eytzinger Snapshot)");
+using SnapshotSearchExperiment = decltype(snapshot_search_experiment_c);
+constexpr auto batch_search_experiment_c =
+    BOOST_HANA_STRING("Search (Batched)");
+using BatchSearchExperiment = decltype(batch_search_experiment_c);
+constexpr auto stabbing_query_experiment_c =
+    BOOST_HANA_STRING("Query (Stabbing)");
+using StabbingQueryExperiment = decltype(stabbing_query_experiment_c);
+constexpr auto short_query_experiment_c = BOOST_HANA_STRING("Query (Short)");
+using ShortQueryExperiment = decltype(short_query_experiment_c);
+constexpr auto long_query_experiment_c = BOOST_HANA_STRING("Query (Long)");
+using LongQueryExperiment = decltype(long_query_experiment_c);
 
 
 std::vector<std::string> PAPI_MEASUREMENTS;
@@ -295,6 +295,75 @@ struct hash<ZipNode<T>>
 };
 } // namespace std
 
+/*
+ * B-Tree Interface
+ */
+class BNode {
+private:
+	int value;
+
+public:
+	BNode(int value_in) : value(value_in){};
+
+	void
+	set_value(int new_value)
+	{
+		this->value = new_value;
+	}
+
+	int
+	get_value() const
+	{
+		return this->value;
+	}
+
+	bool
+	operator<(const BNode & rhs) const
+	{
+		return this->value < rhs.value;
+	}
+};
+
+class BNodeKeyOf {
+public:
+	static int
+	get_key(const BNode & n)
+	{
+		return n.get_value();
+	}
+};
+
+template <class MyTreeOptions>
+class YggBTreeInterface {
+public:
+	using Node = BNode;
+	using Tree = ygg::BTree<Node, BNodeKeyOf, MyTreeOptions>;
+
+	static void
+	insert(Tree & t, Node & n)
+	{
+		t.insert(n);
+	}
+
+	static std::string
+	get_name()
+	{
+		return "BTree";
+	}
+
+	static Node
+	create_node(int val)
+	{
+		return Node(val);
+	}
+
+	static void
+	clear(Tree & t)
+	{
+		t.clear();
+	}
+};
+
 /*
  * Boost::Intrusive::Set Interface
  */
@@ -394,4 +463,13 @@ using BasicTreeOptions =
                      ygg::TreeFlags::ZTREE_RANK_HASH_UNIVERSALIZE_MODUL<
                          std::numeric_limits<size_t>::max()>>;
 
+using SizedTreeOptions =
+    ygg::TreeOptions<ygg::TreeFlags::CONSTANT_TIME_SIZE,
+                     ygg::TreeFlags::ZTREE_USE_HASH,
+                     ygg::TreeFlags::ZTREE_RANK_TYPE<uint8_t>,
+                     ygg::TreeFlags::ZTREE_RANK_HASH_UNIVERSALIZE_COEFFICIENT<
+                         9859957398433823229ul>,
+                     ygg::TreeFlags::ZTREE_RANK_HASH_UNIVERSALIZE_MODUL<
+                         std::numeric_limits<size_t>::max()>>;
+
 #endif
@@ -0,0 +1,517 @@
+#ifndef BENCH_COMMON_ITREE_HPP
+#define BENCH_COMMON_ITREE_HPP
+
+#include "benchmark.h"
+#include <algorithm>
+#include <boost/intrusive/set.hpp>
+#include <draup.hpp>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../src/ygg.hpp"
+
+#include "common.hpp"
+
+// Intervals of the uniform and clustered distributions are at most this long
+constexpr int ITREE_MAX_LENGTH = 1000;
+
+// Query lengths for the selectivity sweep
+constexpr int ITREE_STABBING_QUERY = 0;
+constexpr int ITREE_SHORT_QUERY = ITREE_MAX_LENGTH / 10;
+constexpr int ITREE_LONG_QUERY = 10 * ITREE_MAX_LENGTH;
+
+/*
+ * Interval distributions. The domain is scaled with the number of intervals,
+ * such that every point is covered by a few intervals on average.
+ */
+class UniformIntervals {
+public:
+	static std::string
+	get_name()
+	{
+		return "Uniform";
+	}
+
+	template <class RNG>
+	static std::pair<int, int>
+	draw(RNG & rng, int domain)
+	{
+		std::uniform_int_distribution<int> lower_distr(0, domain);
+		std::uniform_int_distribution<int> length_distr(0, ITREE_MAX_LENGTH);
+		int lower = lower_distr(rng);
+		return {lower, lower + length_distr(rng)};
+	}
+};
+
+// Intervals pile up around a few hot spots
+class ClusteredIntervals {
+public:
+	static constexpr int CLUSTERS = 16;
+
+	static std::string
+	get_name()
+	{
+		return "Clustered";
+	}
+
+	template <class RNG>
+	static std::pair<int, int>
+	draw(RNG & rng, int domain)
+	{
+		std::uniform_int_distribution<int> cluster_distr(0, CLUSTERS - 1);
+		std::normal_distribution<double> offset_distr(
+		    0, std::max(1.0, (double)domain / (CLUSTERS * 16)));
+		std::uniform_int_distribution<int> length_distr(0, ITREE_MAX_LENGTH);
+
+		int center = (int)((int64_t)domain * (2 * cluster_distr(rng) + 1) /
+		                   (2 * CLUSTERS));
+		int lower = std::max(0, std::min(domain, center + (int)offset_distr(rng)));
+		return {lower, lower + length_distr(rng)};
+	}
+};
+
+// Intervals sharing a center are nested into each other
+class NestedIntervals {
+public:
+	static constexpr int CENTERS = 64;
+
+	static std::string
+	get_name()
+	{
+		return "Nested";
+	}
+
+	template <class RNG>
+	static std::pair<int, int>
+	draw(RNG & rng, int domain)
+	{
+		std::uniform_int_distribution<int> center_distr(0, CENTERS - 1);
+		std::uniform_int_distribution<int> width_distr(
+		    0, std::max(1, domain / (2 * CENTERS)));
+
+		int center = (int)((int64_t)domain * (2 * center_distr(rng) + 1) /
+		                   (2 * CENTERS));
+		int width = width_distr(rng);
+		return {center - width, center + width};
+	}
+};
+
+template <class Interface, typename Experiment, class Distribution,
+          bool need_nodes, bool need_queries, bool need_node_pointers,
+          int query_length = ITREE_SHORT_QUERY>
+class ITreeFixture : public benchmark::Fixture {
+public:
+	using InterfaceType = Interface;
+
+	ITreeFixture() : rng(std::random_device{}()) {}
+
+	static std::string
+	get_name()
+	{
+		auto experiment_c = Experiment{};
+		std::string name = std::string("ITree :: ") +
+		                   boost::hana::to<char const *>(experiment_c) +
+		                   std::string(" :: ") + Distribution::get_name() +
+		                   std::string(" :: ") + Interface::get_name();
+		return name;
+	}
+
+	void
+	set_name(std::string name)
+	{
+		this->SetName(name.c_str());
+	}
+
+	void
+	SetUp(const ::benchmark::State & state)
+	{
+		this->papi.initialize();
+
+		size_t fixed_count = state.range(0);
+		size_t experiment_count = state.range(1);
+
+		int domain = (int)std::min((size_t)std::numeric_limits<int>::max() / 4,
+		                           fixed_count * (size_t)ITREE_MAX_LENGTH / 8);
+
+		this->fixed_nodes.clear();
+		for (size_t i = 0; i < fixed_count; ++i) {
+			auto bounds = Distribution::draw(this->rng, domain);
+			this->fixed_nodes.push_back(
+			    Interface::create_node(bounds.first, bounds.second));
+		}
+		for (auto & n : this->fixed_nodes) {
+			Interface::insert(this->t, n);
+		}
+		Interface::prepare(this->t);
+
+		if (need_nodes) {
+			this->experiment_nodes.clear();
+			for (size_t i = 0; i < experiment_count; ++i) {
+				auto bounds = Distribution::draw(this->rng, domain);
+				this->experiment_nodes.push_back(
+				    Interface::create_node(bounds.first, bounds.second));
+			}
+		}
+
+		if (need_queries) {
+			this->experiment_queries.clear();
+			std::uniform_int_distribution<int> lower_distr(0, domain);
+			for (size_t i = 0; i < experiment_count; ++i) {
+				int lower = lower_distr(this->rng);
+				this->experiment_queries.emplace_back(lower, lower + query_length);
+			}
+		}
+
+		if (need_node_pointers) {
+			this->experiment_node_pointers.clear();
+			std::vector<typename Interface::Node *> ptrs;
+			for (auto & n : this->fixed_nodes) {
+				ptrs.push_back(&n);
+			}
+			std::shuffle(ptrs.begin(), ptrs.end(), this->rng);
+			this->experiment_node_pointers.insert(
+			    this->experiment_node_pointers.begin(), ptrs.begin(),
+			    ptrs.begin() + (ptrdiff_t)std::min(experiment_count, fixed_count));
+		}
+	}
+
+	void
+	TearDown(const ::benchmark::State & state)
+	{
+		Interface::clear(this->t);
+	}
+
+	std::vector<typename Interface::Node> fixed_nodes;
+
+	std::vector<typename Interface::Node> experiment_nodes;
+	std::vector<std::pair<int, int>> experiment_queries;
+	std::vector<typename Interface::Node *> experiment_node_pointers;
+
+	std::mt19937 rng;
+
+	typename Interface::Tree t;
+
+	PapiMeasurements papi;
+};
+
+/*
+ * Interval Tree Interface
+ */
+template <class Node>
+class ITNodeTraits : public ygg::ITreeNodeTraits<Node> {
+public:
+	using key_type = int;
+
+	static int
+	get_lower(const Node & n)
+	{
+		return n.lower;
+	}
+
+	static int
+	get_upper(const Node & n)
+	{
+		return n.upper;
+	}
+
+	static int
+	get_lower(const std::pair<int, int> & q)
+	{
+		return q.first;
+	}
+
+	static int
+	get_upper(const std::pair<int, int> & q)
+	{
+		return q.second;
+	}
+};
+
+template <class MyTreeOptions>
+class ITNode
+    : public ygg::ITreeNodeBase<ITNode<MyTreeOptions>,
+                                ITNodeTraits<ITNode<MyTreeOptions>>,
+                                MyTreeOptions> {
+public:
+	int lower;
+	int upper;
+};
+
+template <class MyTreeOptions>
+class YggITreeInterface {
+public:
+	using Node = ITNode<MyTreeOptions>;
+	using NodeTraits = ITNodeTraits<Node>;
+	using Tree = ygg::IntervalTree<Node, NodeTraits, MyTreeOptions>;
+
+	static std::string
+	get_name()
+	{
+		return "IntervalTree";
+	}
+
+	static void
+	insert(Tree & t, Node & n)
+	{
+		t.insert(n);
+	}
+
+	static void
+	remove(Tree & t, Node & n)
+	{
+		t.remove(n);
+	}
+
+	static void
+	prepare(Tree & t)
+	{
+		(void)t;
+	}
+
+	template <class Callback>
+	static void
+	query(const Tree & t, const std::pair<int, int> & q, Callback && callback)
+	{
+		for (const auto & n : t.query(q)) {
+			callback(n);
+		}
+	}
+
+	static Node
+	create_node(int lower, int upper)
+	{
+		Node n;
+		n.lower = lower;
+		n.upper = upper;
+
+		return n;
+	}
+
+	static void
+	clear(Tree & t)
+	{
+		t.clear();
+	}
+};
+
+/*
+ * Interval Tree frozen into an IntervalSnapshot. Only useful for queries.
+ */
+template <class MyTreeOptions>
+class YggITreeSnapshotInterface {
+public:
+	using Base = YggITreeInterface<MyTreeOptions>;
+	using Node = typename Base::Node;
+
+	class Tree {
+	public:
+		typename Base::Tree tree;
+		ygg::IntervalSnapshot<Node, typename Base::NodeTraits> snapshot;
+	};
+
+	static std::string
+	get_name()
+	{
+		return "IntervalSnapshot";
+	}
+
+	static void
+	insert(Tree & t, Node & n)
+	{
+		t.tree.insert(n);
+	}
+
+	static void
+	prepare(Tree & t)
+	{
+		t.snapshot.rebuild(t.tree);
+	}
+
+	template <class Callback>
+	static void
+	query(const Tree & t, const std::pair<int, int> & q, Callback && callback)
+	{
+		t.snapshot.query(q, callback);
+	}
+
+	static Node
+	create_node(int lower, int upper)
+	{
+		return Base::create_node(lower, upper);
+	}
+
+	static void
+	clear(Tree & t)
+	{
+		t.tree.clear();
+		t.snapshot.rebuild(t.tree);
+	}
+};
+
+/*
+ * Boost::Intrusive::Multiset Interface. Sorted by the lower bounds only, a
+ * query scans all intervals that start at most the longest interval's length
+ * before the query.
+ */
+class BoostITreeInterface {
+public:
+	class Node
+	    : public boost::intrusive::set_base_hook<boost::intrusive::link_mode<
+	          boost::intrusive::link_mode_type::normal_link>> {
+	public:
+		int lower;
+		int upper;
+
+		Node(int lower_in, int upper_in) : lower(lower_in), upper(upper_in) {}
+
+		bool
+		operator<(const Node & rhs) const
+		{
+			return this->lower < rhs.lower;
+		}
+	};
+
+	class LowerKey {
+	public:
+		using type = int;
+
+		int
+		operator()(const Node & n) const
+		{
+			return n.lower;
+		}
+	};
+
+	class Tree {
+	public:
+		boost::intrusive::multiset<Node, boost::intrusive::key_of_value<LowerKey>>
+		    set;
+		int max_length = 0;
+	};
+
+	static std::string
+	get_name()
+	{
+		return "boost::intrusive::multiset";
+	}
+
+	static void
+	insert(Tree & t, Node & n)
+	{
+		t.set.insert(n);
+		t.max_length = std::max(t.max_length, n.upper - n.lower);
+	}
+
+	static void
+	remove(Tree & t, Node & n)
+	{
+		t.set.erase(t.set.iterator_to(n));
+	}
+
+	static void
+	prepare(Tree & t)
+	{
+		(void)t;
+	}
+
+	template <class Callback>
+	static void
+	query(const Tree & t, const std::pair<int, int> & q, Callback && callback)
+	{
+		for (auto it = t.set.lower_bound(q.first - t.max_length);
+		     (it != t.set.end()) && (it->lower <= q.second); ++it) {
+			if (it->upper >= q.first) {
+				callback(*it);
+			}
+		}
+	}
+
+	static Node
+	create_node(int lower, int upper)
+	{
+		return Node(lower, upper);
+	}
+
+	static void
+	clear(Tree & t)
+	{
+		t.set.clear();
+		t.max_length = 0;
+	}
+};
+
+/*
+ * std::multimap Interface, mapping lower to upper bounds. Queries work as for
+ * the boost::intrusive::multiset.
+ */
+class StdMultimapITreeInterface {
+public:
+	using Node = std::pair<int, int>;
+
+	class Tree {
+	public:
+		std::multimap<int, int> map;
+		int max_length = 0;
+	};
+
+	static std::string
+	get_name()
+	{
+		return "std::multimap";
+	}
+
+	static void
+	insert(Tree & t, Node & n)
+	{
+		t.map.emplace(n.first, n.second);
+		t.max_length = std::max(t.max_length, n.second - n.first);
+	}
+
+	static void
+	remove(Tree & t, Node & n)
+	{
+		auto range = t.map.equal_range(n.first);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second == n.second) {
+				t.map.erase(it);
+				return;
+			}
+		}
+	}
+
+	static void
+	prepare(Tree & t)
+	{
+		(void)t;
+	}
+
+	template <class Callback>
+	static void
+	query(const Tree & t, const std::pair<int, int> & q, Callback && callback)
+	{
+		for (auto it = t.map.lower_bound(q.first - t.max_length);
+		     (it != t.map.end()) && (it->first <= q.second); ++it) {
+			if (it->second >= q.first) {
+				callback(*it);
+			}
+		}
+	}
+
+	static Node
+	create_node(int lower, int upper)
+	{
+		return Node(lower, upper);
+	}
+
+	static void
+	clear(Tree & t)
+	{
+		t.map.clear();
+		t.max_length = 0;
+	}
+};
+
+using BasicITreeOptions = ygg::TreeOptions<ygg::TreeFlags::MULTIPLE>;
+
+#endif
@@ -2,10 +2,15 @@
 
 #include "bench_bst_delete.cpp"
 #include "bench_bst_insert.cpp"
+#include "bench_bst_pool.cpp"
 #include "bench_bst_search.cpp"
 
 #include "bench_dst_insert.cpp"
 #include "bench_dst_delete.cpp"
 #include "bench_dst_move.cpp"
 
+#include "bench_itree_delete.cpp"
+#include "bench_itree_insert.cpp"
+#include "bench_itree_query.cpp"
+
 #include "main.hpp"
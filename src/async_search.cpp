@@ -0,0 +1,105 @@
+#ifndef YGG_ASYNC_SEARCH_CPP
+#define YGG_ASYNC_SEARCH_CPP
+
+#include "async_search.hpp"
+
+namespace ygg {
+
+template <class Tree, class Comparable, bool exact>
+AsyncSearch<Tree, Comparable, exact>::AsyncSearch(const Tree & t,
+                                                  const Comparable & query_in)
+    : query(&query_in), cur(t.get_root()), last_left(nullptr), cmp()
+{
+	if (this->cur != nullptr) {
+		__builtin_prefetch(this->cur);
+	}
+}
+
+template <class Tree, class Comparable, bool exact>
+bool
+AsyncSearch<Tree, Comparable, exact>::step()
+{
+	if (this->cur == nullptr) {
+		return false;
+	}
+
+	// Same descent as RBTree::find() / RBTree::lower_bound()
+	if (this->cmp(*this->cur, *this->query)) {
+		this->cur = NodeInterface::get_right(this->cur);
+	} else {
+		this->last_left = this->cur;
+		this->cur = NodeInterface::get_left(this->cur);
+	}
+
+	if (this->cur == nullptr) {
+		return false;
+	}
+
+	// By the time we get here again, this should be in the cache.
+	__builtin_prefetch(this->cur);
+	return true;
+}
+
+template <class Tree, class Comparable, bool exact>
+bool
+AsyncSearch<Tree, Comparable, exact>::done() const noexcept
+{
+	return this->cur == nullptr;
+}
+
+template <class Tree, class Comparable, bool exact>
+typename AsyncSearch<Tree, Comparable, exact>::Node *
+AsyncSearch<Tree, Comparable, exact>::get() const
+{
+	// TODO constexpr - if
+	if (exact && (this->last_left != nullptr) &&
+	    this->cmp(*this->query, *this->last_left)) {
+		return nullptr;
+	}
+	return this->last_left;
+}
+
+template <class Tree, class Comparable>
+AsyncSearch<Tree, Comparable, true>
+async_find(const Tree & t, const Comparable & query)
+{
+	return AsyncSearch<Tree, Comparable, true>(t, query);
+}
+
+template <class Tree, class Comparable>
+AsyncSearch<Tree, Comparable, false>
+async_lower_bound(const Tree & t, const Comparable & query)
+{
+	return AsyncSearch<Tree, Comparable, false>(t, query);
+}
+
+template <class... Searches>
+void
+run_interleaved(Searches &... searches)
+{
+	bool active = true;
+	while (active) {
+		active = false;
+		// Steps every search once, in order. Stepping a finished search is a
+		// no-op.
+		(void)std::initializer_list<int>{
+		    (active = searches.step() || active, 0)...};
+	}
+}
+
+template <class ForwardIt>
+void
+run_interleaved_range(ForwardIt begin, ForwardIt end)
+{
+	bool active = true;
+	while (active) {
+		active = false;
+		for (ForwardIt it = begin; it != end; ++it) {
+			active = it->step() || active;
+		}
+	}
+}
+
+} // namespace ygg
+
+#endif // YGG_ASYNC_SEARCH_CPP
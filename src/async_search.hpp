@@ -0,0 +1,162 @@
+#ifndef YGG_ASYNC_SEARCH_HPP
+#define YGG_ASYNC_SEARCH_HPP
+
+#include <cstddef>
+#include <initializer_list>
+
+#include "intervaltree.hpp"
+#include "rbtree.hpp"
+#include "ziptree.hpp"
+
+namespace ygg {
+
+namespace async_internal {
+/// @cond INTERNAL
+
+/*
+ * Extracts the node and compare classes from the supported tree classes. The
+ * tree's NodeInterface is used to walk the nodes.
+ */
+template <class Tree>
+struct SearchTypes;
+
+template <class Node_, class NodeTraits, class Options, class Tag,
+          class Compare_>
+struct SearchTypes<RBTree<Node_, NodeTraits, Options, Tag, Compare_>>
+{
+	using Node = Node_;
+	using Compare = Compare_;
+};
+
+template <class Node_, class NodeTraits, class Options, class Tag,
+          class Compare_, class RankGetter>
+struct SearchTypes<ZTree<Node_, NodeTraits, Options, Tag, Compare_, RankGetter>>
+{
+	using Node = Node_;
+	using Compare = Compare_;
+};
+
+template <class Node_, class NodeTraits, class Options, class Tag>
+struct SearchTypes<IntervalTree<Node_, NodeTraits, Options, Tag>>
+{
+	using Node = Node_;
+	using Compare = intervaltree_internal::IntervalCompare<Node_, NodeTraits>;
+};
+
+/// @endcond
+} // namespace async_internal
+
+/**
+ * @brief A lookup in a tree that is executed step by step
+ *
+ * This is a state machine performing a find() or lower_bound() in an RBTree,
+ * ZTree or IntervalTree. Every call to step() descends one level and
+ * prefetches the node that will be visited next, then returns control to the
+ * caller. By stepping multiple lookups in turn - which may be in different
+ * trees, even of different types - the cache misses of all of them overlap.
+ * See run_interleaved().
+ *
+ * Create instances via async_find() and async_lower_bound().
+ *
+ * @warning Neither the tree nor the query are copied. Both must outlive the
+ * lookup, and the tree must not be modified while the lookup is running.
+ *
+ * @tparam Tree         The tree class
+ * @tparam Comparable   The type of the query
+ * @tparam exact        If true, behaves like find(), otherwise like
+ * lower_bound()
+ */
+template <class Tree, class Comparable, bool exact>
+class AsyncSearch {
+public:
+	using Node = typename async_internal::SearchTypes<Tree>::Node;
+	using Compare = typename async_internal::SearchTypes<Tree>::Compare;
+
+	/**
+	 * @brief Starts a lookup of <query> in <t>
+	 *
+	 * Only prefetches the root of <t>.
+	 *
+	 * @param t       The tree to search in
+	 * @param query   The query. Must be comparable to the tree's nodes.
+	 */
+	AsyncSearch(const Tree & t, const Comparable & query);
+
+	/**
+	 * @brief Descends one level
+	 *
+	 * @returns true if the lookup needs more steps, false if it is done
+	 */
+	bool step();
+
+	/**
+	 * Returns whether the lookup is done, i.e., whether get() may be called.
+	 */
+	bool done() const noexcept;
+
+	/**
+	 * @brief Returns the result of the lookup
+	 *
+	 * May only be called once done() returns true.
+	 *
+	 * @returns For an async_find(), a pointer to the first element comparing
+	 * equally to the query. For an async_lower_bound(), a pointer to the first
+	 * element not less than the query. nullptr if there is no such element.
+	 */
+	Node * get() const;
+
+private:
+	using NodeInterface = typename Tree::NodeInterface;
+
+	const Comparable * query;
+	Node * cur;
+	Node * last_left;
+	Compare cmp;
+};
+
+/**
+ * @brief Creates a step-by-step find() for <query> in <t>
+ *
+ * See AsyncSearch.
+ */
+template <class Tree, class Comparable>
+AsyncSearch<Tree, Comparable, true> async_find(const Tree & t,
+                                               const Comparable & query);
+
+/**
+ * @brief Creates a step-by-step lower_bound() for <query> in <t>
+ *
+ * See AsyncSearch.
+ */
+template <class Tree, class Comparable>
+AsyncSearch<Tree, Comparable, false> async_lower_bound(const Tree & t,
+                                                       const Comparable & query);
+
+/**
+ * @brief Runs a number of lookups to completion, interleaving their steps
+ *
+ * Steps all lookups in a round-robin fashion until all of them are done. The
+ * lookups may be of different types.
+ *
+ * @param searches  The lookups, created via async_find() or
+ * async_lower_bound()
+ */
+template <class... Searches>
+void run_interleaved(Searches &... searches);
+
+/**
+ * @brief Runs a range of lookups to completion, interleaving their steps
+ *
+ * Same as the variadic overload, for a range of lookups of the same type.
+ *
+ * @param begin   Iterator to the first lookup
+ * @param end     Iterator past the last lookup
+ */
+template <class ForwardIt>
+void run_interleaved_range(ForwardIt begin, ForwardIt end);
+
+} // namespace ygg
+
+#include "async_search.cpp"
+
+#endif // YGG_ASYNC_SEARCH_HPP
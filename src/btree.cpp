@@ -0,0 +1,979 @@
+#ifndef YGG_BTREE_CPP
+#define YGG_BTREE_CPP
+
+#include "btree.hpp"
+
+namespace ygg {
+
+namespace btree_internal {
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+bool
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator==(
+    const ConcreteIterator & other) const
+{
+	return (this->leaf == other.leaf) && (this->index == other.index);
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+bool
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator!=(
+    const ConcreteIterator & other) const
+{
+	return !(*this == other);
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+ConcreteIterator &
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator++()
+{
+	// TODO constexpr - if
+	if (reverse) {
+		this->step_back();
+	} else {
+		this->step_forward();
+	}
+	return *(static_cast<ConcreteIterator *>(this));
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+ConcreteIterator
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator++(int)
+{
+	ConcreteIterator cpy(*(static_cast<ConcreteIterator *>(this)));
+	++(*this);
+	return cpy;
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+ConcreteIterator &
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator--()
+{
+	// TODO constexpr - if
+	if (reverse) {
+		this->step_forward();
+	} else {
+		this->step_back();
+	}
+	return *(static_cast<ConcreteIterator *>(this));
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+ConcreteIterator
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator--(int)
+{
+	ConcreteIterator cpy(*(static_cast<ConcreteIterator *>(this)));
+	--(*this);
+	return cpy;
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+typename IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::reference
+    IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator*() const
+{
+	return *(this->leaf->nodes[this->index]);
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+typename IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::pointer
+    IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::operator->() const
+{
+	return this->leaf->nodes[this->index];
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+void
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::step_forward()
+{
+	this->index++;
+	if (this->index >= this->leaf->count) {
+		this->leaf = this->leaf->next;
+		this->index = 0;
+	}
+}
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+void
+IteratorBase<ConcreteIterator, LeafT, NodeT, reverse>::step_back()
+{
+	if (this->index > 0) {
+		this->index--;
+		return;
+	}
+
+	this->leaf = this->leaf->prev;
+	// Leaves in the tree are never empty
+	this->index = (this->leaf != nullptr) ? (size_t)(this->leaf->count - 1) : 0;
+}
+
+} // namespace btree_internal
+
+template <class Node, class KeyOf, class Options, class Compare>
+BTree<Node, KeyOf, Options, Compare>::BTree() : root(nullptr)
+{}
+
+template <class Node, class KeyOf, class Options, class Compare>
+BTree<Node, KeyOf, Options, Compare>::BTree(MyClass && other)
+    : root(other.root), s(other.s), cmp(other.cmp)
+{
+	other.root = nullptr;
+	other.s.set(0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::MyClass &
+BTree<Node, KeyOf, Options, Compare>::operator=(MyClass && other)
+{
+	if (this != &other) {
+		this->clear();
+		this->root = other.root;
+		this->s = other.s;
+		this->cmp = other.cmp;
+		other.root = nullptr;
+		other.s.set(0);
+	}
+	return *this;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+BTree<Node, KeyOf, Options, Compare>::~BTree()
+{
+	this->clear();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+size_t
+BTree<Node, KeyOf, Options, Compare>::count_less(
+    const Key * keys, size_t n, const Comparable & query) const
+{
+	// The pages are small, thus a linear scan without early exit is usually
+	// faster than a binary search.
+	size_t result = 0;
+	for (size_t i = 0; i < n; ++i) {
+		result += this->cmp(keys[i], query) ? 1 : 0;
+	}
+	return result;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+size_t
+BTree<Node, KeyOf, Options, Compare>::count_not_greater(
+    const Key * keys, size_t n, const Comparable & query) const
+{
+	size_t result = 0;
+	for (size_t i = 0; i < n; ++i) {
+		result += this->cmp(query, keys[i]) ? 0 : 1;
+	}
+	return result;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::prefetch_page(
+    const Header * page) noexcept
+{
+	const char * base = reinterpret_cast<const char *>(page);
+	for (size_t offset = 0; offset < Options::btree_page_size; offset += 64) {
+		__builtin_prefetch(base + offset);
+	}
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <bool upper, class Comparable>
+std::pair<const typename BTree<Node, KeyOf, Options, Compare>::Leaf *, size_t>
+BTree<Node, KeyOf, Options, Compare>::descend(const Comparable & query) const
+{
+	if (this->root == nullptr) {
+		return {nullptr, 0};
+	}
+
+	const Header * page = this->root;
+	while (!page->is_leaf) {
+		const Inner * inner = static_cast<const Inner *>(page);
+		size_t pos;
+		// TODO constexpr - if
+		if (upper) {
+			pos = this->count_not_greater(inner->keys, inner->count - 1u, query);
+		} else {
+			pos = this->count_less(inner->keys, inner->count - 1u, query);
+		}
+		page = inner->children[pos];
+		prefetch_page(page);
+	}
+
+	const Leaf * leaf = static_cast<const Leaf *>(page);
+	size_t pos;
+	// TODO constexpr - if
+	if (upper) {
+		pos = this->count_not_greater(leaf->keys, leaf->count, query);
+	} else {
+		pos = this->count_less(leaf->keys, leaf->count, query);
+	}
+
+	// The separators only bound the keys in a subtree. If all keys in this leaf
+	// are too small, the result is the first element of the next leaf.
+	if (pos == leaf->count) {
+		return {leaf->next, 0};
+	}
+	return {leaf, pos};
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+std::pair<const typename BTree<Node, KeyOf, Options, Compare>::Leaf *, size_t>
+BTree<Node, KeyOf, Options, Compare>::locate(const Node & node) const
+{
+	const Key key = KeyOf::get_key(node);
+	auto pos = this->template descend<false>(key);
+
+	const Leaf * leaf = pos.first;
+	size_t index = pos.second;
+	while ((leaf != nullptr) && !this->cmp(key, leaf->keys[index])) {
+		if (leaf->nodes[index] == &node) {
+			return {leaf, index};
+		}
+		index++;
+		if (index == leaf->count) {
+			leaf = leaf->next;
+			index = 0;
+		}
+	}
+
+	return {nullptr, 0};
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+const typename BTree<Node, KeyOf, Options, Compare>::Leaf *
+BTree<Node, KeyOf, Options, Compare>::get_first_leaf() const
+{
+	if (this->root == nullptr) {
+		return nullptr;
+	}
+
+	const Header * page = this->root;
+	while (!page->is_leaf) {
+		page = static_cast<const Inner *>(page)->children[0];
+	}
+	return static_cast<const Leaf *>(page);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+const typename BTree<Node, KeyOf, Options, Compare>::Leaf *
+BTree<Node, KeyOf, Options, Compare>::get_last_leaf() const
+{
+	if (this->root == nullptr) {
+		return nullptr;
+	}
+
+	const Header * page = this->root;
+	while (!page->is_leaf) {
+		const Inner * inner = static_cast<const Inner *>(page);
+		page = inner->children[inner->count - 1];
+	}
+	return static_cast<const Leaf *>(page);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::insert(Node & node)
+{
+	const Key key = KeyOf::get_key(node);
+
+	if (this->root == nullptr) {
+		Leaf * leaf = new Leaf();
+		leaf->count = 1;
+		leaf->is_leaf = true;
+		leaf->prev = nullptr;
+		leaf->next = nullptr;
+		leaf->keys[0] = key;
+		leaf->nodes[0] = &node;
+		this->root = leaf;
+		this->s.add(1);
+		return;
+	}
+
+	Split split;
+	if (!this->insert_below(this->root, key, &node, split)) {
+		return;
+	}
+	this->s.add(1);
+
+	if (split.right != nullptr) {
+		// The root was split. Grow the tree by one level.
+		Inner * new_root = new Inner();
+		new_root->count = 2;
+		new_root->is_leaf = false;
+		new_root->keys[0] = split.separator;
+		new_root->children[0] = this->root;
+		new_root->children[1] = split.right;
+		this->root = new_root;
+	}
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::insert_below(Header * page,
+                                                   const Key & key, Node * node,
+                                                   Split & split)
+{
+	if (page->is_leaf) {
+		return this->insert_into_leaf(static_cast<Leaf *>(page), key, node, split);
+	}
+
+	Inner * inner = static_cast<Inner *>(page);
+	size_t pos = this->count_not_greater(inner->keys, inner->count - 1u, key);
+	Header * child = inner->children[pos];
+	prefetch_page(child);
+
+	Split child_split;
+	if (!this->insert_below(child, key, node, child_split)) {
+		return false;
+	}
+
+	if (child_split.right == nullptr) {
+		split.right = nullptr;
+	} else {
+		this->insert_into_inner(inner, pos, child_split, split);
+	}
+	return true;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::insert_into_leaf(Leaf * leaf,
+                                                       const Key & key,
+                                                       Node * node,
+                                                       Split & split)
+{
+	// Insert after all equal elements
+	size_t pos = this->count_not_greater(leaf->keys, leaf->count, key);
+
+	// TODO constexpr - if
+	if (!Options::multiple) {
+		// The element before the insertion point is not greater than <key>. If it
+		// is also not smaller, it's a duplicate.
+		const Key * before = nullptr;
+		if (pos > 0) {
+			before = &leaf->keys[pos - 1];
+		} else if (leaf->prev != nullptr) {
+			before = &leaf->prev->keys[leaf->prev->count - 1];
+		}
+		if ((before != nullptr) && !this->cmp(*before, key)) {
+			return false;
+		}
+	}
+
+	Leaf * target = leaf;
+	split.right = nullptr;
+
+	if (leaf->count == LEAF_CAPACITY) {
+		// Move the upper half into a new right sibling
+		Leaf * right = new Leaf();
+		right->is_leaf = true;
+		size_t keep = LEAF_CAPACITY / 2;
+		right->count = (uint16_t)(LEAF_CAPACITY - keep);
+		for (size_t i = 0; i < right->count; ++i) {
+			right->keys[i] = leaf->keys[keep + i];
+			right->nodes[i] = leaf->nodes[keep + i];
+		}
+		leaf->count = (uint16_t)keep;
+
+		right->prev = leaf;
+		right->next = leaf->next;
+		if (leaf->next != nullptr) {
+			leaf->next->prev = right;
+		}
+		leaf->next = right;
+
+		if (pos > keep) {
+			target = right;
+			pos -= keep;
+		}
+		split.right = right;
+	}
+
+	for (size_t i = target->count; i > pos; --i) {
+		target->keys[i] = target->keys[i - 1];
+		target->nodes[i] = target->nodes[i - 1];
+	}
+	target->keys[pos] = key;
+	target->nodes[pos] = node;
+	target->count++;
+
+	if (split.right != nullptr) {
+		split.separator = static_cast<Leaf *>(split.right)->keys[0];
+	}
+
+	return true;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::insert_into_inner(
+    Inner * inner, size_t pos, const Split & child_split, Split & split)
+{
+	Inner * target = inner;
+	split.right = nullptr;
+
+	if (inner->count == INNER_CAPACITY) {
+		// The left page keeps <keep> children. The separator between the two
+		// halves moves up.
+		Inner * right = new Inner();
+		right->is_leaf = false;
+		size_t keep = INNER_CAPACITY / 2;
+		right->count = (uint16_t)(INNER_CAPACITY - keep);
+		for (size_t i = 0; i < right->count; ++i) {
+			right->children[i] = inner->children[keep + i];
+		}
+		for (size_t i = 0; i + 1 < right->count; ++i) {
+			right->keys[i] = inner->keys[keep + i];
+		}
+		split.separator = inner->keys[keep - 1];
+		inner->count = (uint16_t)keep;
+
+		if (pos >= keep) {
+			target = right;
+			pos -= keep;
+		}
+		split.right = right;
+	}
+
+	// Key <pos> separates child <pos> from its new right sibling
+	for (size_t i = target->count; i > pos + 1; --i) {
+		target->children[i] = target->children[i - 1];
+	}
+	for (size_t i = target->count - 1u; i > pos; --i) {
+		target->keys[i] = target->keys[i - 1];
+	}
+	target->keys[pos] = child_split.separator;
+	target->children[pos + 1] = child_split.right;
+	target->count++;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::remove(Node & node)
+{
+	if (this->root == nullptr) {
+		return;
+	}
+
+	if (!this->remove_below(this->root, KeyOf::get_key(node), &node)) {
+		return;
+	}
+	this->s.reduce(1);
+
+	if (this->root->is_leaf) {
+		if (this->root->count == 0) {
+			delete static_cast<Leaf *>(this->root);
+			this->root = nullptr;
+		}
+	} else if (this->root->count == 1) {
+		// Shrink the tree by one level
+		Inner * old_root = static_cast<Inner *>(this->root);
+		this->root = old_root->children[0];
+		delete old_root;
+	}
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::remove_below(Header * page,
+                                                   const Key & key,
+                                                   const Node * node)
+{
+	if (page->is_leaf) {
+		Leaf * leaf = static_cast<Leaf *>(page);
+		size_t pos = this->count_less(leaf->keys, leaf->count, key);
+		while ((pos < leaf->count) && (leaf->nodes[pos] != node) &&
+		       !this->cmp(key, leaf->keys[pos])) {
+			pos++;
+		}
+		if ((pos == leaf->count) || (leaf->nodes[pos] != node)) {
+			return false;
+		}
+
+		for (size_t i = pos; i + 1 < leaf->count; ++i) {
+			leaf->keys[i] = leaf->keys[i + 1];
+			leaf->nodes[i] = leaf->nodes[i + 1];
+		}
+		leaf->count--;
+		return true;
+	}
+
+	// Elements comparing equally to <key> may be spread over several children.
+	Inner * inner = static_cast<Inner *>(page);
+	size_t first = this->count_less(inner->keys, inner->count - 1u, key);
+	size_t last = this->count_not_greater(inner->keys, inner->count - 1u, key);
+	for (size_t pos = first; pos <= last; ++pos) {
+		if (this->remove_below(inner->children[pos], key, node)) {
+			this->fix_underflow(inner, pos);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::fix_underflow(Inner * parent,
+                                                    size_t pos)
+{
+	Header * child = parent->children[pos];
+	size_t min_count = child->is_leaf ? LEAF_MIN : INNER_MIN;
+	if (child->count >= min_count) {
+		return;
+	}
+
+	Header * left = (pos > 0) ? parent->children[pos - 1] : nullptr;
+	Header * right =
+	    (pos + 1 < parent->count) ? parent->children[pos + 1] : nullptr;
+
+	if ((left != nullptr) && (left->count > min_count)) {
+		// Borrow the largest entry from the left sibling
+		if (child->is_leaf) {
+			Leaf * c = static_cast<Leaf *>(child);
+			Leaf * l = static_cast<Leaf *>(left);
+			for (size_t i = c->count; i > 0; --i) {
+				c->keys[i] = c->keys[i - 1];
+				c->nodes[i] = c->nodes[i - 1];
+			}
+			c->keys[0] = l->keys[l->count - 1];
+			c->nodes[0] = l->nodes[l->count - 1];
+			c->count++;
+			l->count--;
+			parent->keys[pos - 1] = c->keys[0];
+		} else {
+			Inner * c = static_cast<Inner *>(child);
+			Inner * l = static_cast<Inner *>(left);
+			for (size_t i = c->count; i > 0; --i) {
+				c->children[i] = c->children[i - 1];
+			}
+			for (size_t i = c->count - 1u; i > 0; --i) {
+				c->keys[i] = c->keys[i - 1];
+			}
+			c->children[0] = l->children[l->count - 1];
+			c->keys[0] = parent->keys[pos - 1];
+			parent->keys[pos - 1] = l->keys[l->count - 2];
+			c->count++;
+			l->count--;
+		}
+	} else if ((right != nullptr) && (right->count > min_count)) {
+		// Borrow the smallest entry from the right sibling
+		if (child->is_leaf) {
+			Leaf * c = static_cast<Leaf *>(child);
+			Leaf * r = static_cast<Leaf *>(right);
+			c->keys[c->count] = r->keys[0];
+			c->nodes[c->count] = r->nodes[0];
+			c->count++;
+			for (size_t i = 0; i + 1 < r->count; ++i) {
+				r->keys[i] = r->keys[i + 1];
+				r->nodes[i] = r->nodes[i + 1];
+			}
+			r->count--;
+			parent->keys[pos] = r->keys[0];
+		} else {
+			Inner * c = static_cast<Inner *>(child);
+			Inner * r = static_cast<Inner *>(right);
+			c->keys[c->count - 1] = parent->keys[pos];
+			c->children[c->count] = r->children[0];
+			c->count++;
+			parent->keys[pos] = r->keys[0];
+			for (size_t i = 0; i + 1 < r->count; ++i) {
+				r->children[i] = r->children[i + 1];
+			}
+			for (size_t i = 0; i + 2 < r->count; ++i) {
+				r->keys[i] = r->keys[i + 1];
+			}
+			r->count--;
+		}
+	} else if (left != nullptr) {
+		this->merge_children(parent, pos - 1);
+	} else if (right != nullptr) {
+		this->merge_children(parent, pos);
+	}
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::merge_children(Inner * parent,
+                                                     size_t pos)
+{
+	// Merges child <pos + 1> into child <pos>
+	Header * left = parent->children[pos];
+	Header * right = parent->children[pos + 1];
+
+	if (left->is_leaf) {
+		Leaf * l = static_cast<Leaf *>(left);
+		Leaf * r = static_cast<Leaf *>(right);
+		for (size_t i = 0; i < r->count; ++i) {
+			l->keys[l->count + i] = r->keys[i];
+			l->nodes[l->count + i] = r->nodes[i];
+		}
+		l->count = (uint16_t)(l->count + r->count);
+
+		l->next = r->next;
+		if (r->next != nullptr) {
+			r->next->prev = l;
+		}
+		delete r;
+	} else {
+		Inner * l = static_cast<Inner *>(left);
+		Inner * r = static_cast<Inner *>(right);
+		l->keys[l->count - 1] = parent->keys[pos];
+		for (size_t i = 0; i < r->count; ++i) {
+			l->children[l->count + i] = r->children[i];
+		}
+		for (size_t i = 0; i + 1 < r->count; ++i) {
+			l->keys[l->count + i] = r->keys[i];
+		}
+		l->count = (uint16_t)(l->count + r->count);
+		delete r;
+	}
+
+	for (size_t i = pos + 1; i + 1 < parent->count; ++i) {
+		parent->children[i] = parent->children[i + 1];
+	}
+	for (size_t i = pos; i + 2 < parent->count; ++i) {
+		parent->keys[i] = parent->keys[i + 1];
+	}
+	parent->count--;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::free_page(Header * page)
+{
+	if (page->is_leaf) {
+		delete static_cast<Leaf *>(page);
+		return;
+	}
+
+	Inner * inner = static_cast<Inner *>(page);
+	for (size_t i = 0; i < inner->count; ++i) {
+		free_page(inner->children[i]);
+	}
+	delete inner;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+void
+BTree<Node, KeyOf, Options, Compare>::clear()
+{
+	if (this->root != nullptr) {
+		free_page(this->root);
+	}
+	this->root = nullptr;
+	this->s.set(0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::find(const Comparable & query) const
+{
+	auto pos = this->template descend<false>(query);
+	if ((pos.first == nullptr) ||
+	    this->cmp(query, pos.first->keys[pos.second])) {
+		return this->cend();
+	}
+	return const_iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::find(const Comparable & query)
+{
+	auto pos = this->template descend<false>(query);
+	if ((pos.first == nullptr) ||
+	    this->cmp(query, pos.first->keys[pos.second])) {
+		return this->end();
+	}
+	return iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::upper_bound(
+    const Comparable & query) const
+{
+	auto pos = this->template descend<true>(query);
+	return const_iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::upper_bound(const Comparable & query)
+{
+	auto pos = this->template descend<true>(query);
+	return iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::lower_bound(
+    const Comparable & query) const
+{
+	auto pos = this->template descend<false>(query);
+	return const_iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+template <class Comparable>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::lower_bound(const Comparable & query)
+{
+	auto pos = this->template descend<false>(query);
+	return iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::iterator_to(const Node & node) const
+{
+	auto pos = this->locate(node);
+	return const_iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::iterator_to(Node & node)
+{
+	auto pos = this->locate(node);
+	return iterator<false>(pos.first, pos.second);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::cbegin() const
+{
+	return const_iterator<false>(this->get_first_leaf(), 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::cend() const
+{
+	return const_iterator<false>(nullptr, 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::begin() const
+{
+	return this->cbegin();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::begin()
+{
+	return iterator<false>(this->get_first_leaf(), 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<false>
+BTree<Node, KeyOf, Options, Compare>::end() const
+{
+	return this->cend();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<false>
+BTree<Node, KeyOf, Options, Compare>::end()
+{
+	return iterator<false>(nullptr, 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<true>
+BTree<Node, KeyOf, Options, Compare>::crbegin() const
+{
+	const Leaf * last = this->get_last_leaf();
+	return const_iterator<true>(
+	    last, (last != nullptr) ? (size_t)(last->count - 1) : 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<true>
+BTree<Node, KeyOf, Options, Compare>::crend() const
+{
+	return const_iterator<true>(nullptr, 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<true>
+BTree<Node, KeyOf, Options, Compare>::rbegin() const
+{
+	return this->crbegin();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<true>
+BTree<Node, KeyOf, Options, Compare>::rbegin()
+{
+	const Leaf * last = this->get_last_leaf();
+	return iterator<true>(last,
+	                      (last != nullptr) ? (size_t)(last->count - 1) : 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template const_iterator<true>
+BTree<Node, KeyOf, Options, Compare>::rend() const
+{
+	return this->crend();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+typename BTree<Node, KeyOf, Options, Compare>::template iterator<true>
+BTree<Node, KeyOf, Options, Compare>::rend()
+{
+	return iterator<true>(nullptr, 0);
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+size_t
+BTree<Node, KeyOf, Options, Compare>::size() const
+{
+	return this->s.get();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::empty() const
+{
+	return this->root == nullptr;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::verify_page(
+    const Header * page, const Key * lower, const Key * upper, size_t depth,
+    size_t & leaf_depth, const Leaf *& last_leaf, size_t & count) const
+{
+	bool is_root = (page == this->root);
+
+	if (page->is_leaf) {
+		const Leaf * leaf = static_cast<const Leaf *>(page);
+		if ((leaf->count == 0) || (leaf->count > LEAF_CAPACITY)) {
+			return false;
+		}
+		if (!is_root && (leaf->count < LEAF_MIN)) {
+			return false;
+		}
+
+		// All leaves must be on the same level
+		if (leaf_depth == 0) {
+			leaf_depth = depth;
+		} else if (leaf_depth != depth) {
+			return false;
+		}
+
+		// The leaves must be linked in order
+		if (leaf->prev != last_leaf) {
+			return false;
+		}
+		if ((last_leaf != nullptr) && (last_leaf->next != leaf)) {
+			return false;
+		}
+		last_leaf = leaf;
+
+		for (size_t i = 0; i < leaf->count; ++i) {
+			const Key node_key = KeyOf::get_key(*leaf->nodes[i]);
+			if (this->cmp(node_key, leaf->keys[i]) ||
+			    this->cmp(leaf->keys[i], node_key)) {
+				return false;
+			}
+			if ((i > 0) && this->cmp(leaf->keys[i], leaf->keys[i - 1])) {
+				return false;
+			}
+			// TODO constexpr - if
+			if (!Options::multiple && (i > 0) &&
+			    !this->cmp(leaf->keys[i - 1], leaf->keys[i])) {
+				return false;
+			}
+			if ((lower != nullptr) && this->cmp(leaf->keys[i], *lower)) {
+				return false;
+			}
+			if ((upper != nullptr) && this->cmp(*upper, leaf->keys[i])) {
+				return false;
+			}
+		}
+		count += leaf->count;
+
+		return true;
+	}
+
+	const Inner * inner = static_cast<const Inner *>(page);
+	if ((inner->count < 2) || (inner->count > INNER_CAPACITY)) {
+		return false;
+	}
+	if (!is_root && (inner->count < INNER_MIN)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < inner->count; ++i) {
+		const Key * child_lower = (i > 0) ? &inner->keys[i - 1] : lower;
+		const Key * child_upper = (i + 1 < inner->count) ? &inner->keys[i] : upper;
+		if ((child_lower != nullptr) && (child_upper != nullptr) &&
+		    this->cmp(*child_upper, *child_lower)) {
+			return false;
+		}
+		if (!this->verify_page(inner->children[i], child_lower, child_upper,
+		                       depth + 1, leaf_depth, last_leaf, count)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::verify_integrity() const
+{
+	if (this->root == nullptr) {
+		return true;
+	}
+
+	size_t leaf_depth = 0;
+	const Leaf * last_leaf = nullptr;
+	size_t count = 0;
+	if (!this->verify_page(this->root, nullptr, nullptr, 1, leaf_depth,
+	                       last_leaf, count)) {
+		return false;
+	}
+	if (last_leaf->next != nullptr) {
+		return false;
+	}
+
+	return this->verify_size(
+	    count, std::integral_constant<bool, Options::constant_time_size>());
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::verify_size(size_t count,
+                                                  std::true_type) const
+{
+	return count == this->size();
+}
+
+template <class Node, class KeyOf, class Options, class Compare>
+bool
+BTree<Node, KeyOf, Options, Compare>::verify_size(size_t count,
+                                                  std::false_type) const
+{
+	(void)count;
+	return true;
+}
+
+} // namespace ygg
+
+#endif // YGG_BTREE_CPP
@@ -0,0 +1,423 @@
+#ifndef YGG_BTREE_HPP
+#define YGG_BTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "options.hpp"
+#include "size_holder.hpp"
+#include "util.hpp"
+
+namespace ygg {
+
+namespace btree_internal {
+/// @cond INTERNAL
+
+/*
+ * Every page starts with this header. For leaves, count is the number of
+ * elements, for inner pages it is the number of children.
+ */
+struct PageHeader
+{
+	uint16_t count;
+	bool is_leaf;
+};
+
+/*
+ * A leaf stores copies of the keys and pointers to the respective nodes. The
+ * leaves are doubly linked in key order, which is all the iterators need.
+ */
+template <class Key, class Node, size_t page_bytes>
+struct Leaf : public PageHeader
+{
+	static constexpr size_t overhead = 3 * sizeof(void *);
+	static constexpr size_t fitting =
+	    (page_bytes - overhead) / (sizeof(Key) + sizeof(Node *));
+	static constexpr size_t capacity = (fitting < 4) ? 4 : fitting;
+
+	Leaf * prev;
+	Leaf * next;
+	Key keys[capacity];
+	Node * nodes[capacity];
+};
+
+/*
+ * An inner page with count children stores count - 1 separator keys. All keys
+ * in the subtree of children[i] are >= keys[i - 1] and <= keys[i]. Since
+ * separators are not updated on removal, they need not be present in the tree.
+ */
+template <class Key, size_t page_bytes>
+struct Inner : public PageHeader
+{
+	static constexpr size_t overhead = sizeof(void *);
+	static constexpr size_t fitting =
+	    (page_bytes - overhead + sizeof(Key)) / (sizeof(Key) + sizeof(void *));
+	static constexpr size_t capacity = (fitting < 4) ? 4 : fitting;
+
+	Key keys[capacity - 1];
+	PageHeader * children[capacity];
+};
+
+template <class ConcreteIterator, class LeafT, class NodeT, bool reverse>
+class IteratorBase {
+public:
+	typedef ptrdiff_t difference_type;
+	typedef NodeT value_type;
+	typedef NodeT & reference;
+	typedef NodeT * pointer;
+	typedef std::input_iterator_tag iterator_category;
+
+	IteratorBase() : leaf(nullptr), index(0){};
+	IteratorBase(const LeafT * leaf_in, size_t index_in)
+	    : leaf(leaf_in), index(index_in){};
+
+	bool operator==(const ConcreteIterator & other) const;
+	bool operator!=(const ConcreteIterator & other) const;
+
+	ConcreteIterator & operator++();
+	ConcreteIterator operator++(int);
+	ConcreteIterator & operator--();
+	ConcreteIterator operator--(int);
+
+	reference operator*() const;
+	pointer operator->() const;
+
+protected:
+	void step_forward();
+	void step_back();
+
+	const LeafT * leaf;
+	size_t index;
+};
+
+/// @endcond
+} // namespace btree_internal
+
+/**
+ * @brief An intrusive B-Tree
+ *
+ * The B-Tree offers the same interface as RBTree and also does not copy or own
+ * your nodes. However, it does not link the nodes with each other. Instead, it
+ * allocates pages of (about) TreeFlags::BTREE_PAGE_SIZE bytes which store
+ * copies of the keys together with pointers to the nodes. A lookup thus only
+ * touches a few contiguous pages instead of one node per level, and only
+ * dereferences the node it returns. For large trees, this is usually a lot
+ * faster than any binary tree.
+ *
+ * All elements are stored in the leaves (i.e., this is a B+-Tree). Full pages
+ * are split on insertion. Pages that are less than half full after a removal
+ * borrow from or are merged with a sibling.
+ *
+ * Your node class does not need to derive from any base class, and a node can
+ * be in any number of BTrees at once.
+ *
+ * @warning Other than for the binary trees, any modification of the tree
+ * invalidates all iterators. Also, the key of a node must not change while the
+ * node is in the tree.
+ *
+ * @tparam Node     The node class
+ * @tparam KeyOf    A class providing a static method get_key(const Node &). The
+ * returned key is copied into the tree, thus it should be small and cheap to
+ * copy.
+ * @tparam Options  The TreeOptions class specifying the parameters of this
+ * BTree. MULTIPLE, CONSTANT_TIME_SIZE and BTREE_PAGE_SIZE are supported.
+ * @tparam Compare  A compare class. See RBTree for details. It must be able to
+ * compare the keys to all your Comparable types in both directions.
+ */
+template <class Node, class KeyOf, class Options = DefaultOptions,
+          class Compare = ygg::rbtree_internal::flexible_less>
+class BTree {
+public:
+	using MyClass = BTree<Node, KeyOf, Options, Compare>;
+	using Key = typename std::decay<decltype(
+	    KeyOf::get_key(std::declval<const Node &>()))>::type;
+
+	/**
+	 * @brief Creates a new empty B-Tree
+	 */
+	BTree();
+
+	/**
+	 * @brief Create a new B-Tree from a different B-Tree
+	 *
+	 * The other B-Tree is moved into this one and left empty.
+	 *
+	 * @param other  The B-Tree that this one is constructed from
+	 */
+	BTree(MyClass && other);
+
+	/**
+	 * @brief Move-assign an other B-Tree to this one
+	 *
+	 * The elements of this tree are discarded. The other B-Tree is moved into
+	 * this one and left empty.
+	 *
+	 * @param other  The B-Tree that this one is constructed from
+	 */
+	MyClass & operator=(MyClass && other);
+
+	BTree(const MyClass & other) = delete;
+	MyClass & operator=(const MyClass & other) = delete;
+
+	/**
+	 * @brief Frees all pages. Your nodes are not touched.
+	 */
+	~BTree();
+
+private:
+	using Header = btree_internal::PageHeader;
+	using Leaf =
+	    btree_internal::Leaf<Key, Node, Options::btree_page_size>;
+	using Inner = btree_internal::Inner<Key, Options::btree_page_size>;
+
+public:
+	/**
+	 * The maximum number of elements in a leaf
+	 */
+	static constexpr size_t LEAF_CAPACITY = Leaf::capacity;
+	/**
+	 * The maximum number of children of an inner page
+	 */
+	static constexpr size_t INNER_CAPACITY = Inner::capacity;
+
+	// forward, for friendship
+	template <bool reverse>
+	class const_iterator;
+
+	template <bool reverse>
+	class iterator : public btree_internal::IteratorBase<iterator<reverse>, Leaf,
+	                                                     Node, reverse> {
+	public:
+		using btree_internal::IteratorBase<iterator<reverse>, Leaf, Node,
+		                                   reverse>::IteratorBase;
+
+	private:
+		friend class const_iterator<reverse>;
+	};
+
+	template <bool reverse>
+	class const_iterator
+	    : public btree_internal::IteratorBase<const_iterator<reverse>, Leaf,
+	                                          const Node, reverse> {
+	public:
+		using btree_internal::IteratorBase<const_iterator<reverse>, Leaf,
+		                                   const Node, reverse>::IteratorBase;
+		const_iterator(const iterator<reverse> & orig)
+		    : btree_internal::IteratorBase<const_iterator<reverse>, Leaf,
+		                                   const Node, reverse>(orig.leaf,
+		                                                        orig.index){};
+	};
+
+	/**
+	 * @brief Inserts <node> into the tree
+	 *
+	 * The node is placed after all elements that compare equally to it. If
+	 * MULTIPLE is not set and such an element exists, <node> is not inserted.
+	 *
+	 * *Warning*: As for the other trees, <node> *may not move in memory* while it
+	 * is in the tree.
+	 *
+	 * @param node  The node to be inserted
+	 */
+	void insert(Node & node);
+
+	/**
+	 * @brief Removes <node> from the tree
+	 *
+	 * Nothing happens if <node> is not in the tree.
+	 *
+	 * @param node  The node to be removed
+	 */
+	void remove(Node & node);
+
+	/**
+	 * @brief Finds an element in the tree
+	 *
+	 * Returns an iterator to the first element that compares equally to <query>.
+	 * See RBTree::find() for details.
+	 *
+	 * @param query An object comparing equally to the element that should be
+	 * found.
+	 * @returns An iterator to the first element comparing equally to <query>, or
+	 * end() if no such element exists
+	 */
+	template <class Comparable>
+	const_iterator<false> find(const Comparable & query) const;
+	template <class Comparable>
+	iterator<false> find(const Comparable & query);
+
+	/**
+	 * @brief Upper-bounds an element
+	 *
+	 * Returns an iterator to the first element that compares greater than
+	 * <query>. See RBTree::upper_bound() for details.
+	 *
+	 * @param query An object comparable to the keys that should be upper-bounded
+	 * @returns An iterator to the first element greater than <query>, or end()
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	const_iterator<false> upper_bound(const Comparable & query) const;
+	template <class Comparable>
+	iterator<false> upper_bound(const Comparable & query);
+
+	/**
+	 * @brief Lower-bounds an element
+	 *
+	 * Returns an iterator to the first element that does not compare less than
+	 * <query>. See RBTree::lower_bound() for details.
+	 *
+	 * @param query An object comparable to the keys that should be lower-bounded
+	 * @returns An iterator to the first element not less than <query>, or end()
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	const_iterator<false> lower_bound(const Comparable & query) const;
+	template <class Comparable>
+	iterator<false> lower_bound(const Comparable & query);
+
+	/**
+	 * @brief Removes all elements from the tree
+	 *
+	 * Frees all pages. Your nodes are not touched.
+	 */
+	void clear();
+
+	// Mainly debugging methods
+	/// @cond INTERNAL
+	bool verify_integrity() const;
+	/// @endcond
+
+	// Iteration
+	/**
+	 * Returns an iterator pointing to the smallest element in the tree.
+	 */
+	const_iterator<false> cbegin() const;
+	/**
+	 * Returns an iterator pointing after the largest element in the tree.
+	 */
+	const_iterator<false> cend() const;
+	/**
+	 * Returns an iterator pointing to the smallest element in the tree.
+	 */
+	const_iterator<false> begin() const;
+	iterator<false> begin();
+
+	/**
+	 * Returns an iterator pointing after the largest element in the tree.
+	 */
+	const_iterator<false> end() const;
+	iterator<false> end();
+
+	/**
+	 * Returns an reverse iterator pointing to the largest element in the tree.
+	 */
+	const_iterator<true> crbegin() const;
+	/**
+	 * Returns an reverse iterator pointing before the smallest element in the
+	 * tree.
+	 */
+	const_iterator<true> crend() const;
+	/**
+	 * Returns an reverse iterator pointing to the largest element in the tree.
+	 */
+	const_iterator<true> rbegin() const;
+	iterator<true> rbegin();
+
+	/**
+	 * Returns an reverse iterator pointing before the smallest element in the
+	 * tree.
+	 */
+	const_iterator<true> rend() const;
+	iterator<true> rend();
+
+	/**
+	 * Returns an iterator pointing to the entry held in node. Since the nodes
+	 * do not know their position, this performs a lookup of the node's key.
+	 *
+	 * @param node  The node the iterator should point to.
+	 */
+	const_iterator<false> iterator_to(const Node & node) const;
+	iterator<false> iterator_to(Node & node);
+
+	/**
+	 * Return the number of elements in the tree.
+	 *
+	 * This method runs in O(1).
+	 *
+	 * @warning This method is only available if CONSTANT_TIME_SIZE is set as
+	 * option!
+	 *
+	 * @return The number of elements in the tree.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Returns whether the tree is empty
+	 *
+	 * This method runs in O(1).
+	 *
+	 * @return true if the tree is empty, false otherwise
+	 */
+	bool empty() const;
+
+private:
+	static constexpr size_t LEAF_MIN = LEAF_CAPACITY / 2;
+	static constexpr size_t INNER_MIN = INNER_CAPACITY / 2;
+
+	// The result of inserting below a page: the new right sibling of that page
+	// (if it was split) and the separator between the two.
+	struct Split
+	{
+		Header * right;
+		Key separator;
+	};
+
+	Header * root;
+	SizeHolder<Options::constant_time_size> s;
+	Compare cmp;
+
+	template <class Comparable>
+	size_t count_less(const Key * keys, size_t n,
+	                  const Comparable & query) const;
+	template <class Comparable>
+	size_t count_not_greater(const Key * keys, size_t n,
+	                         const Comparable & query) const;
+
+	template <bool upper, class Comparable>
+	std::pair<const Leaf *, size_t> descend(const Comparable & query) const;
+	std::pair<const Leaf *, size_t> locate(const Node & node) const;
+
+	const Leaf * get_first_leaf() const;
+	const Leaf * get_last_leaf() const;
+
+	static void prefetch_page(const Header * page) noexcept;
+
+	bool insert_below(Header * page, const Key & key, Node * node,
+	                  Split & split);
+	bool insert_into_leaf(Leaf * leaf, const Key & key, Node * node,
+	                      Split & split);
+	void insert_into_inner(Inner * inner, size_t pos, const Split & child_split,
+	                       Split & split);
+
+	bool remove_below(Header * page, const Key & key, const Node * node);
+	void fix_underflow(Inner * parent, size_t pos);
+	void merge_children(Inner * parent, size_t pos);
+
+	static void free_page(Header * page);
+
+	bool verify_page(const Header * page, const Key * lower, const Key * upper,
+	                 size_t depth, size_t & leaf_depth, const Leaf *& last_leaf,
+	                 size_t & count) const;
+	bool verify_size(size_t count, std::true_type) const;
+	bool verify_size(size_t count, std::false_type) const;
+};
+
+} // namespace ygg
+
+#include "btree.cpp"
+
+#endif // YGG_BTREE_HPP
@@ -0,0 +1,215 @@
+#ifndef YGG_CACHED_KEY_HPP
+#define YGG_CACHED_KEY_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include "options.hpp"
+
+namespace ygg {
+namespace cached_key_internal {
+/// @cond INTERNAL
+
+/*
+ * Storage for the cached key if TreeFlags::CACHED_KEY is set. The owner (i.e.,
+ * the node base class of the respective tree) keeps the bases of nodes that
+ * live in multiple trees apart.
+ */
+template <class Owner, class CachedKey>
+class CachedKeyStorage {
+};
+
+template <class Owner, class Extractor, class T>
+class CachedKeyStorage<Owner, TreeFlags::CACHED_KEY<Extractor, T>> {
+public:
+	T _cached_key;
+};
+
+/*
+ * Whether the Extractor can compute a cached key from a query of type
+ * Comparable. If it can't, comparisons against such queries always use the
+ * full Compare.
+ */
+template <class Extractor, class Comparable, class = void>
+struct has_cached_key : std::false_type
+{
+};
+
+template <class Extractor, class Comparable>
+struct has_cached_key<Extractor, Comparable,
+                      decltype((void)Extractor::get_cached_key(
+                          std::declval<const Comparable &>()))> : std::true_type
+{
+};
+
+/*
+ * Selects the compare class a tree uses internally and fills the cached keys.
+ * Without TreeFlags::CACHED_KEY, this is the user's Compare, filling is a
+ * no-op and queries are passed through unchanged.
+ */
+template <class Node, class Owner, class CachedKey, class UserCompare>
+struct CachedKeys
+{
+	using Compare = UserCompare;
+
+	static void
+	fill(Node & node) noexcept
+	{
+		(void)node;
+	}
+
+	template <class Comparable>
+	static const Comparable &
+	query(const Comparable & q) noexcept
+	{
+		return q;
+	}
+};
+
+template <class Node, class Owner, class Extractor, class T, class UserCompare>
+struct CachedKeys<Node, Owner, TreeFlags::CACHED_KEY<Extractor, T>,
+                  UserCompare>
+{
+	using Storage =
+	    CachedKeyStorage<Owner, TreeFlags::CACHED_KEY<Extractor, T>>;
+
+	static const T &
+	get(const Node & node) noexcept
+	{
+		return static_cast<const Storage &>(node)._cached_key;
+	}
+
+	static void
+	fill(Node & node)
+	{
+		static_cast<Storage &>(node)._cached_key = Extractor::get_cached_key(node);
+	}
+
+	/*
+	 * A node that is used as a query. Its stored cached key is only valid if
+	 * the node is in the tree, thus the key is computed when wrapping it.
+	 */
+	class NodeQuery {
+	public:
+		explicit NodeQuery(const Node & node_in)
+		    : node(node_in), key(Extractor::get_cached_key(node_in))
+		{}
+
+		const Node & node;
+		const T key;
+	};
+
+	/*
+	 * Must be applied to every query before searching for it. Queries of any
+	 * type other than Node compute their key during comparison anyways.
+	 */
+	template <class Comparable>
+	static const Comparable &
+	query(const Comparable & q) noexcept
+	{
+		return q;
+	}
+
+	static NodeQuery
+	query(const Node & q)
+	{
+		return NodeQuery(q);
+	}
+
+	/*
+	 * Compares the cached keys first. The user's Compare is only asked if these
+	 * are equal. Comparing two nodes reads both stored keys, which is only
+	 * valid for nodes that are in the tree or are being inserted.
+	 */
+	class Compare : public UserCompare {
+	public:
+		bool
+		operator()(const Node & lhs, const Node & rhs) const
+		{
+			return this->compare_keys(get(lhs), lhs, get(rhs), rhs);
+		}
+
+		bool
+		operator()(const Node & lhs, const NodeQuery & rhs) const
+		{
+			return this->compare_keys(get(lhs), lhs, rhs.key, rhs.node);
+		}
+
+		bool
+		operator()(const NodeQuery & lhs, const Node & rhs) const
+		{
+			return this->compare_keys(lhs.key, lhs.node, get(rhs), rhs);
+		}
+
+		template <class Comparable>
+		bool
+		operator()(const Node & lhs, const Comparable & rhs) const
+		{
+			return this->compare_to_query(
+			    lhs, rhs, has_cached_key<Extractor, Comparable>());
+		}
+
+		template <class Comparable>
+		bool
+		operator()(const Comparable & lhs, const Node & rhs) const
+		{
+			return this->compare_from_query(
+			    lhs, rhs, has_cached_key<Extractor, Comparable>());
+		}
+
+	private:
+		template <class LHS, class RHS>
+		bool
+		compare_keys(const T & lhs_key, const LHS & lhs, const T & rhs_key,
+		             const RHS & rhs) const
+		{
+			if (lhs_key < rhs_key) {
+				return true;
+			}
+			if (rhs_key < lhs_key) {
+				return false;
+			}
+			return UserCompare::operator()(lhs, rhs);
+		}
+
+		template <class Comparable>
+		bool
+		compare_to_query(const Node & lhs, const Comparable & rhs,
+		                 std::true_type) const
+		{
+			return this->compare_keys(get(lhs), lhs, Extractor::get_cached_key(rhs),
+			                          rhs);
+		}
+
+		template <class Comparable>
+		bool
+		compare_to_query(const Node & lhs, const Comparable & rhs,
+		                 std::false_type) const
+		{
+			return UserCompare::operator()(lhs, rhs);
+		}
+
+		template <class Comparable>
+		bool
+		compare_from_query(const Comparable & lhs, const Node & rhs,
+		                   std::true_type) const
+		{
+			return this->compare_keys(Extractor::get_cached_key(lhs), lhs, get(rhs),
+			                          rhs);
+		}
+
+		template <class Comparable>
+		bool
+		compare_from_query(const Comparable & lhs, const Node & rhs,
+		                   std::false_type) const
+		{
+			return UserCompare::operator()(lhs, rhs);
+		}
+	};
+};
+
+/// @endcond
+} // namespace cached_key_internal
+} // namespace ygg
+
+#endif // YGG_CACHED_KEY_HPP
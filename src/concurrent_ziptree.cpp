@@ -0,0 +1,653 @@
+#ifndef YGG_CONCURRENT_ZIPTREE_CPP
+#define YGG_CONCURRENT_ZIPTREE_CPP
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "concurrent_ziptree.hpp"
+
+namespace ygg {
+
+namespace czt_internal {
+
+inline EpochManager::EpochManager() noexcept : epoch(0)
+{
+	for (auto & stripe : this->stripes) {
+		stripe.pinned[0].store(0, std::memory_order_relaxed);
+		stripe.pinned[1].store(0, std::memory_order_relaxed);
+	}
+}
+
+inline size_t
+EpochManager::stripe_index() noexcept
+{
+	thread_local size_t index =
+	    std::hash<std::thread::id>()(std::this_thread::get_id()) % STRIPES;
+	return index;
+}
+
+inline EpochManager::Guard::Guard(EpochManager & mgr) noexcept
+{
+	Stripe & stripe = mgr.stripes[EpochManager::stripe_index()];
+	while (true) {
+		uint64_t e = mgr.epoch.load();
+		this->counter = &stripe.pinned[e & 1];
+		this->counter->fetch_add(1);
+		// If the epoch moved on in between, the counter might already have been
+		// checked for being zero.
+		if (mgr.epoch.load() == e) {
+			return;
+		}
+		this->counter->fetch_sub(1);
+	}
+}
+
+inline EpochManager::Guard::~Guard() noexcept
+{
+	this->counter->fetch_sub(1, std::memory_order_release);
+}
+
+inline uint64_t
+EpochManager::current() const noexcept
+{
+	return this->epoch.load();
+}
+
+inline uint64_t
+EpochManager::try_advance() noexcept
+{
+	uint64_t e = this->epoch.load();
+	// Operations pinned to e - 1 use the same counters as e + 1 will
+	uint64_t previous = (e + 1) & 1;
+	for (auto & stripe : this->stripes) {
+		if (stripe.pinned[previous].load() != 0) {
+			return e;
+		}
+	}
+
+	if (this->epoch.compare_exchange_strong(e, e + 1)) {
+		return e + 1;
+	}
+	return e;
+}
+
+} // namespace czt_internal
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::ConcurrentZTree(
+    NodeTraits traits_in) noexcept
+    : root_version(0), root(nullptr), traits(traits_in), cmp()
+{}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::~ConcurrentZTree()
+{
+	for (auto & entry : this->retired) {
+		this->traits.reclaim(entry.first);
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::Pin::Pin(
+    MyClass & tree_in) noexcept
+    : guard(tree_in.epochs), tree(&tree_in)
+{}
+
+/*
+ * Version lock primitives
+ */
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+uint64_t
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::read_version(
+    const std::atomic<uint64_t> & version, bool & ok) noexcept
+{
+	uint64_t seen = version.load(std::memory_order_acquire);
+	if ((seen & (czt_internal::VERSION_LOCKED |
+	             czt_internal::VERSION_OBSOLETE)) != 0) {
+		ok = false;
+	}
+	return seen;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::validate(
+    const std::atomic<uint64_t> & version, uint64_t seen) noexcept
+{
+	// Nothing read before may be reordered after this.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return version.load(std::memory_order_relaxed) == seen;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::try_lock(
+    std::atomic<uint64_t> & version, uint64_t seen) noexcept
+{
+	if ((seen & (czt_internal::VERSION_LOCKED |
+	             czt_internal::VERSION_OBSOLETE)) != 0) {
+		return false;
+	}
+	if (!version.compare_exchange_strong(seen,
+	                                     seen | czt_internal::VERSION_LOCKED,
+	                                     std::memory_order_acquire)) {
+		return false;
+	}
+
+	// The links are stored relaxed while the lock is held. This fence orders
+	// these stores after the locked version, pairing with the acquire fence in
+	// validate(): A reader that saw any of the new links must see the locked
+	// (or a later) version when validating, and retries.
+	std::atomic_thread_fence(std::memory_order_release);
+	return true;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::unlock(
+    std::atomic<uint64_t> & version) noexcept
+{
+	uint64_t locked = version.load(std::memory_order_relaxed);
+	version.store((locked & ~czt_internal::VERSION_LOCKED) +
+	                  czt_internal::VERSION_STEP,
+	              std::memory_order_release);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::unlock_unchanged(
+    std::atomic<uint64_t> & version) noexcept
+{
+	// Nothing was written, readers that saw the old version may go on.
+	uint64_t locked = version.load(std::memory_order_relaxed);
+	version.store(locked & ~czt_internal::VERSION_LOCKED,
+	              std::memory_order_release);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::unlock_obsolete(
+    std::atomic<uint64_t> & version) noexcept
+{
+	uint64_t locked = version.load(std::memory_order_relaxed);
+	version.store(((locked & ~czt_internal::VERSION_LOCKED) +
+	               czt_internal::VERSION_STEP) |
+	                  czt_internal::VERSION_OBSOLETE,
+	              std::memory_order_release);
+}
+
+/*
+ * Helpers
+ */
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+uint8_t
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::draw_rank() noexcept
+{
+	thread_local ztree_internal::FastRankGenerator gen(
+	    static_cast<uint64_t>(
+	        std::chrono::high_resolution_clock::now().time_since_epoch().count()) ^
+	    std::hash<std::thread::id>()(std::this_thread::get_id()));
+	return static_cast<uint8_t>(gen.draw_rank());
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::above(
+    const Node & a, const Node & b) const noexcept
+{
+	// Ties are broken towards the smaller key, i.e., a node may only have an
+	// equal-ranked right child.
+	return (a.NB::_czt_rank > b.NB::_czt_rank) ||
+	       ((a.NB::_czt_rank == b.NB::_czt_rank) && this->cmp(a, b));
+}
+
+/*
+ * Locks the search path for <node>, starting at <start>. Fails if any node on
+ * the path is locked by another writer, or if an element equal to <node> is
+ * encountered (which sets <duplicate>). All locks taken so far are released on
+ * failure.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::lock_path(
+    Node * start, const Node & node, bool & duplicate)
+{
+	Node * cur = start;
+	while (cur != nullptr) {
+		uint64_t seen = cur->NB::_czt_version.load(std::memory_order_acquire);
+		duplicate = !this->cmp(*cur, node) && !this->cmp(node, *cur);
+		if (duplicate || !try_lock(cur->NB::_czt_version, seen)) {
+			// Nothing has been restructured yet, so the path is still intact
+			Node * unlock_cur = start;
+			while (unlock_cur != cur) {
+				Node * next = this->cmp(*unlock_cur, node)
+				                  ? unlock_cur->NB::_czt_right.load()
+				                  : unlock_cur->NB::_czt_left.load();
+				unlock_unchanged(unlock_cur->NB::_czt_version);
+				unlock_cur = next;
+			}
+			return false;
+		}
+
+		if (this->cmp(*cur, node)) {
+			cur = cur->NB::_czt_right.load(std::memory_order_relaxed);
+		} else {
+			cur = cur->NB::_czt_left.load(std::memory_order_relaxed);
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Unlocks a path of nodes that leads away from <node>: nodes smaller than
+ * <node> continue to the right, larger ones to the left. This is both the
+ * shape of the spines of an inserted node and of a zipped path.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::unlock_path(
+    Node * start, const Node & node, bool changed)
+{
+	Node * cur = start;
+	while (cur != nullptr) {
+		// Must be read before unlocking, other writers may change it afterwards
+		Node * next = this->cmp(*cur, node)
+		                  ? cur->NB::_czt_right.load(std::memory_order_relaxed)
+		                  : cur->NB::_czt_left.load(std::memory_order_relaxed);
+		if (changed) {
+			unlock(cur->NB::_czt_version);
+		} else {
+			unlock_unchanged(cur->NB::_czt_version);
+		}
+		cur = next;
+	}
+}
+
+/*
+ * Modifying methods
+ */
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::insert(Node & node)
+{
+	czt_internal::EpochManager::Guard guard(this->epochs);
+
+	node.NB::_czt_rank = draw_rank();
+	node.NB::_czt_left.store(nullptr, std::memory_order_relaxed);
+	node.NB::_czt_right.store(nullptr, std::memory_order_relaxed);
+	// Nobody may descend below the new node before it is complete
+	node.NB::_czt_version.store(czt_internal::VERSION_LOCKED,
+	                            std::memory_order_relaxed);
+
+	while (true) {
+		bool ok = true;
+		Parent parent{&this->root_version, &this->root,
+		              read_version(this->root_version, ok)};
+		if (!ok) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Find the insertion point: the first node on the search path that must
+		// be below <node>.
+		Node * cur = parent.link->load(std::memory_order_relaxed);
+		uint64_t cur_seen = 0;
+		bool duplicate = false;
+		while (cur != nullptr) {
+			cur_seen = read_version(cur->NB::_czt_version, ok);
+			if (!ok || !validate(*parent.version, parent.seen)) {
+				ok = false;
+				break;
+			}
+
+			if (!this->cmp(*cur, node) && !this->cmp(node, *cur)) {
+				duplicate = true;
+				ok = validate(cur->NB::_czt_version, cur_seen);
+				break;
+			}
+			if (!this->above(*cur, node)) {
+				break;
+			}
+
+			std::atomic<Node *> * link = this->cmp(node, *cur)
+			                                 ? &cur->NB::_czt_left
+			                                 : &cur->NB::_czt_right;
+			parent = Parent{&cur->NB::_czt_version, link, cur_seen};
+			cur = link->load(std::memory_order_relaxed);
+		}
+		if (!ok) {
+			continue;
+		}
+		if (duplicate) {
+			unlock_unchanged(node.NB::_czt_version);
+			return false;
+		}
+
+		// Having locked the unchanged parent, it must still point to cur.
+		if (!try_lock(*parent.version, parent.seen)) {
+			continue;
+		}
+		if ((cur != nullptr) && !try_lock(cur->NB::_czt_version, cur_seen)) {
+			unlock_unchanged(*parent.version);
+			continue;
+		}
+		if (cur != nullptr) {
+			// cur itself is already locked, start below it.
+			Node * below = this->cmp(*cur, node)
+			                   ? cur->NB::_czt_right.load(std::memory_order_relaxed)
+			                   : cur->NB::_czt_left.load(std::memory_order_relaxed);
+			if (!this->lock_path(below, node, duplicate)) {
+				unlock_unchanged(cur->NB::_czt_version);
+				unlock_unchanged(*parent.version);
+				if (duplicate) {
+					unlock_unchanged(node.NB::_czt_version);
+					return false;
+				}
+				continue;
+			}
+		}
+
+		// Unzip the (locked) path below cur into the spines of the new node
+		std::atomic<Node *> * left_tail = &node.NB::_czt_left;
+		std::atomic<Node *> * right_tail = &node.NB::_czt_right;
+		Node * unzip = cur;
+		while (unzip != nullptr) {
+			if (this->cmp(*unzip, node)) {
+				left_tail->store(unzip, std::memory_order_relaxed);
+				left_tail = &unzip->NB::_czt_right;
+				unzip = left_tail->load(std::memory_order_relaxed);
+			} else {
+				right_tail->store(unzip, std::memory_order_relaxed);
+				right_tail = &unzip->NB::_czt_left;
+				unzip = right_tail->load(std::memory_order_relaxed);
+			}
+		}
+		left_tail->store(nullptr, std::memory_order_relaxed);
+		right_tail->store(nullptr, std::memory_order_relaxed);
+
+		parent.link->store(&node, std::memory_order_release);
+
+		this->unlock_path(node.NB::_czt_left.load(std::memory_order_relaxed),
+		                  node, true);
+		this->unlock_path(node.NB::_czt_right.load(std::memory_order_relaxed),
+		                  node, true);
+		unlock(node.NB::_czt_version);
+		unlock(*parent.version);
+		return true;
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::remove(Node & node)
+{
+	{
+		czt_internal::EpochManager::Guard guard(this->epochs);
+
+		while (true) {
+			bool ok = true;
+			Parent parent{&this->root_version, &this->root,
+			              read_version(this->root_version, ok)};
+			if (!ok) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			Node * cur = parent.link->load(std::memory_order_relaxed);
+			uint64_t cur_seen = 0;
+			while (cur != nullptr) {
+				cur_seen = read_version(cur->NB::_czt_version, ok);
+				if (!ok || !validate(*parent.version, parent.seen)) {
+					ok = false;
+					break;
+				}
+				if (cur == &node) {
+					break;
+				}
+
+				std::atomic<Node *> * link = this->cmp(node, *cur)
+				                                 ? &cur->NB::_czt_left
+				                                 : &cur->NB::_czt_right;
+				parent = Parent{&cur->NB::_czt_version, link, cur_seen};
+				cur = link->load(std::memory_order_relaxed);
+			}
+			if (!ok) {
+				continue;
+			}
+			if (cur == nullptr) {
+				if (!validate(*parent.version, parent.seen)) {
+					continue;
+				}
+				return false;
+			}
+
+			if (!try_lock(*parent.version, parent.seen)) {
+				continue;
+			}
+			if (!try_lock(node.NB::_czt_version, cur_seen)) {
+				unlock_unchanged(*parent.version);
+				continue;
+			}
+
+			// Lock both spines. They have the shape of a search path for <node>.
+			Node * left = node.NB::_czt_left.load(std::memory_order_relaxed);
+			Node * right = node.NB::_czt_right.load(std::memory_order_relaxed);
+			bool duplicate = false;
+			if (!this->lock_path(left, node, duplicate)) {
+				unlock_unchanged(node.NB::_czt_version);
+				unlock_unchanged(*parent.version);
+				continue;
+			}
+			if (!this->lock_path(right, node, duplicate)) {
+				this->unlock_path(left, node, false);
+				unlock_unchanged(node.NB::_czt_version);
+				unlock_unchanged(*parent.version);
+				continue;
+			}
+
+			// Zip the spines into the parent's link
+			std::atomic<Node *> * tail = parent.link;
+			while ((left != nullptr) && (right != nullptr)) {
+				if (this->above(*left, *right)) {
+					tail->store(left, std::memory_order_relaxed);
+					tail = &left->NB::_czt_right;
+					left = tail->load(std::memory_order_relaxed);
+				} else {
+					tail->store(right, std::memory_order_relaxed);
+					tail = &right->NB::_czt_left;
+					right = tail->load(std::memory_order_relaxed);
+				}
+			}
+			tail->store((left != nullptr) ? left : right, std::memory_order_relaxed);
+
+			this->unlock_path(parent.link->load(std::memory_order_relaxed), node,
+			                  true);
+			unlock_obsolete(node.NB::_czt_version);
+			unlock(*parent.version);
+			break;
+		}
+	}
+
+	this->retire(node);
+	return true;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::retire(Node & node)
+{
+	uint64_t epoch = this->epochs.current();
+	{
+		std::lock_guard<std::mutex> lock(this->retired_mutex);
+		this->retired.emplace_back(&node, epoch);
+	}
+
+	this->reclaim_until(this->epochs.try_advance());
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::reclaim_until(
+    uint64_t epoch)
+{
+	std::vector<Node *> reclaimable;
+	{
+		std::lock_guard<std::mutex> lock(this->retired_mutex);
+		// Entries are sorted by epoch
+		size_t count = 0;
+		while ((count < this->retired.size()) &&
+		       (this->retired[count].second + 2 <= epoch)) {
+			reclaimable.push_back(this->retired[count].first);
+			count++;
+		}
+		this->retired.erase(this->retired.begin(),
+		                    this->retired.begin() + static_cast<ptrdiff_t>(count));
+	}
+
+	// The hook may take long, so it must not run under the lock.
+	for (Node * n : reclaimable) {
+		this->traits.reclaim(n);
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::collect()
+{
+	// Two advances are needed for everything retired so far
+	this->epochs.try_advance();
+	this->reclaim_until(this->epochs.try_advance());
+}
+
+/*
+ * Reading methods
+ */
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::lower_bound(
+    const Comparable & query, const Pin & pin)
+{
+	// The pin keeps every node we encounter from being reclaimed
+	assert(pin.tree == this);
+	(void)pin;
+
+	while (true) {
+		bool ok = true;
+		const std::atomic<uint64_t> * parent_version = &this->root_version;
+		uint64_t parent_seen = read_version(this->root_version, ok);
+		if (!ok) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		Node * cur = this->root.load(std::memory_order_relaxed);
+		Node * result = nullptr;
+		while (cur != nullptr) {
+			uint64_t cur_seen = read_version(cur->NB::_czt_version, ok);
+			// Lock coupling: the parent must not have changed while we went on
+			// to cur.
+			if (!ok || !validate(*parent_version, parent_seen)) {
+				ok = false;
+				break;
+			}
+
+			Node * next;
+			if (this->cmp(*cur, query)) {
+				next = cur->NB::_czt_right.load(std::memory_order_relaxed);
+			} else {
+				result = cur;
+				next = cur->NB::_czt_left.load(std::memory_order_relaxed);
+			}
+
+			parent_version = &cur->NB::_czt_version;
+			parent_seen = cur_seen;
+			cur = next;
+		}
+
+		if (ok && validate(*parent_version, parent_seen)) {
+			return result;
+		}
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::find(
+    const Comparable & query, const Pin & pin)
+{
+	Node * candidate = this->lower_bound(query, pin);
+	// Keys never change while a node is in the tree. Since it is still pinned,
+	// the candidate has not been reclaimed even if it was removed meanwhile.
+	if ((candidate != nullptr) && !this->cmp(query, *candidate)) {
+		return candidate;
+	}
+	return nullptr;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::empty() const
+{
+	return this->root.load() == nullptr;
+}
+
+/*
+ * Debugging methods
+ */
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::verify_subtree(
+    const Node * n, const Node * lower, const Node * upper) const
+{
+	if (n == nullptr) {
+		return true;
+	}
+
+	if ((n->NB::_czt_version.load() & (czt_internal::VERSION_LOCKED |
+	                                   czt_internal::VERSION_OBSOLETE)) != 0) {
+		return false;
+	}
+	if ((lower != nullptr) && !this->cmp(*lower, *n)) {
+		return false;
+	}
+	if ((upper != nullptr) && !this->cmp(*n, *upper)) {
+		return false;
+	}
+
+	const Node * left = n->NB::_czt_left.load();
+	const Node * right = n->NB::_czt_right.load();
+	if ((left != nullptr) && !this->above(*n, *left)) {
+		return false;
+	}
+	if ((right != nullptr) && !this->above(*n, *right)) {
+		return false;
+	}
+
+	return this->verify_subtree(left, lower, n) &&
+	       this->verify_subtree(right, n, upper);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>::verify_integrity()
+    const
+{
+	if ((this->root_version.load() & czt_internal::VERSION_LOCKED) != 0) {
+		return false;
+	}
+	return this->verify_subtree(this->root.load(), nullptr, nullptr);
+}
+
+} // namespace ygg
+
+#endif // YGG_CONCURRENT_ZIPTREE_CPP
@@ -0,0 +1,350 @@
+#ifndef YGG_CONCURRENT_ZIPTREE_HPP
+#define YGG_CONCURRENT_ZIPTREE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "options.hpp"
+#include "ziptree.hpp"
+
+namespace ygg {
+
+namespace czt_internal {
+/// @cond INTERNAL
+
+/*
+ * Optimistic version locks. The lowest bit marks a locked node, the second bit
+ * marks a node that has been removed from the tree. Every unlock advances the
+ * version, which makes optimistic readers of the node restart.
+ */
+constexpr uint64_t VERSION_LOCKED = 1;
+constexpr uint64_t VERSION_OBSOLETE = 2;
+constexpr uint64_t VERSION_STEP = 4;
+
+/*
+ * Epoch based reclamation. Every operation pins the current epoch for its
+ * duration. A node removed in epoch e can be reclaimed as soon as the global
+ * epoch has reached e + 2, since then no operation that might still see the
+ * node is running. The pin counters are striped to keep readers on different
+ * threads from contending on one cache line.
+ */
+class EpochManager {
+public:
+	EpochManager() noexcept;
+
+	class Guard {
+	public:
+		explicit Guard(EpochManager & mgr) noexcept;
+		~Guard() noexcept;
+
+		Guard(const Guard &) = delete;
+		Guard & operator=(const Guard &) = delete;
+
+	private:
+		std::atomic<uint64_t> * counter;
+	};
+
+	uint64_t current() const noexcept;
+
+	// Advances the global epoch if no operation is pinned to the previous one.
+	// Returns the (possibly new) current epoch.
+	uint64_t try_advance() noexcept;
+
+private:
+	static constexpr size_t STRIPES = 16;
+
+	struct alignas(64) Stripe
+	{
+		std::atomic<uint64_t> pinned[2];
+	};
+
+	std::atomic<uint64_t> epoch;
+	Stripe stripes[STRIPES];
+
+	static size_t stripe_index() noexcept;
+};
+
+/// @endcond
+} // namespace czt_internal
+
+/**
+ * @brief Base class (template) to supply your node class with metainformation
+ * for a ConcurrentZTree
+ *
+ * The class you use as nodes for the ConcurrentZTree must derive from this
+ * class template.
+ *
+ * @tparam Node     The node class itself
+ * @tparam Options  The TreeOptions class. See ConcurrentZTree.
+ * @tparam Tag      The tag identifying the tree. See ConcurrentZTree.
+ */
+template <class Node, class Options = TreeOptions<>, class Tag = int>
+class ConcurrentZTreeNodeBase {
+public:
+	std::atomic<Node *> _czt_left;
+	std::atomic<Node *> _czt_right;
+	std::atomic<uint64_t> _czt_version;
+	uint8_t _czt_rank;
+
+	ConcurrentZTreeNodeBase() noexcept
+	    : _czt_left(nullptr), _czt_right(nullptr), _czt_version(0), _czt_rank(0)
+	{}
+};
+
+/**
+ * @brief Default node traits for the ConcurrentZTree
+ *
+ * Derive from this to implement your own reclaim() hook.
+ */
+template <class Node>
+class ConcurrentZTreeDefaultNodeTraits {
+public:
+	/**
+	 * @brief Called when a removed node is not accessed by any operation
+	 * anymore
+	 *
+	 * After remove() has returned, other threads might still be looking at the
+	 * node. This is called as soon as none of them can do so anymore. Only from
+	 * then on may the node be destroyed, re-used or inserted again.
+	 *
+	 * @param node  The node that may now be reclaimed
+	 */
+	void
+	reclaim(Node * node) const noexcept
+	{
+		(void)node;
+	}
+};
+
+/**
+ * @brief A zip tree that can be modified and read by many threads
+ * concurrently
+ *
+ * Like in a ZTree, inserting or removing a node only restructures a single
+ * path: the path below the insertion point is unzipped into the new node's
+ * left and right spine, and the spines of a removed node are zipped back into
+ * a path. This makes fine-grained synchronization cheap.
+ *
+ * Every node carries a version lock, which writers acquire via
+ * compare-and-swap. A writer locks the parent of the insertion point (or of
+ * the removed node) and the path it restructures. Writers working on disjoint
+ * parts of the tree do not block each other. Readers (find(), lower_bound())
+ * take no locks at all. They validate the versions of the nodes on their path
+ * and restart if a node has been changed concurrently.
+ *
+ * Since nodes are intrusive, removed nodes are not freed by the tree. Instead,
+ * nodes are reclaimed via epoch-based reclamation: once no running operation
+ * can access a removed node anymore, the NodeTraits' reclaim() hook is
+ * called. See ConcurrentZTreeDefaultNodeTraits. Readers must hold a Pin for as
+ * long as they access the nodes they found.
+ *
+ * The tree is an ordered set, TreeFlags::MULTIPLE is not supported. This is
+ * why the options default to an empty TreeOptions instead of DefaultOptions.
+ *
+ * @tparam Node         The node class. Must derive from
+ * ConcurrentZTreeNodeBase.
+ * @tparam NodeTraits   A class providing the reclaim() hook, see
+ * ConcurrentZTreeDefaultNodeTraits
+ * @tparam Options      The TreeOptions class
+ * @tparam Tag          The tag identifying the tree. See RBTree.
+ * @tparam Compare      The compare class. See RBTree.
+ */
+template <class Node, class NodeTraits = ConcurrentZTreeDefaultNodeTraits<Node>,
+          class Options = TreeOptions<>, class Tag = int,
+          class Compare = ygg::rbtree_internal::flexible_less>
+class ConcurrentZTree {
+public:
+	using NB = ConcurrentZTreeNodeBase<Node, Options, Tag>;
+	using MyClass = ConcurrentZTree<Node, NodeTraits, Options, Tag, Compare>;
+
+	static_assert(std::is_base_of<NB, Node>::value,
+	              "Node class not properly derived from ConcurrentZTreeNodeBase");
+	static_assert(!Options::multiple,
+	              "ConcurrentZTree does not support TreeFlags::MULTIPLE.");
+
+	/**
+	 * @brief Create a new empty concurrent zip tree
+	 *
+	 * @param traits  The NodeTraits object whose reclaim() hook is called
+	 */
+	explicit ConcurrentZTree(NodeTraits traits = NodeTraits()) noexcept;
+
+	/**
+	 * @brief Destroys the tree
+	 *
+	 * All nodes that have been removed but not yet reclaimed are reclaimed. No
+	 * other thread may access the tree anymore. Nodes that are still in the
+	 * tree are left alone.
+	 */
+	~ConcurrentZTree();
+
+	ConcurrentZTree(const MyClass &) = delete;
+	MyClass & operator=(const MyClass &) = delete;
+
+	/**
+	 * @brief Keeps the nodes found through it from being reclaimed
+	 *
+	 * A node returned by find() or lower_bound() might be removed concurrently
+	 * at any time. It is only handed to the reclaim() hook after every Pin that
+	 * existed at the time of its removal has been destroyed. Thus, the returned
+	 * node may be accessed for as long as the Pin that was passed lives.
+	 *
+	 * Keep pins short-lived: As long as a Pin lives, no node removed after its
+	 * creation can be reclaimed.
+	 */
+	class Pin {
+	public:
+		/**
+		 * @brief Pins the current epoch of <tree>
+		 *
+		 * @param tree  The tree whose nodes should be kept from being reclaimed
+		 */
+		explicit Pin(MyClass & tree) noexcept;
+
+		Pin(const Pin &) = delete;
+		Pin & operator=(const Pin &) = delete;
+
+	private:
+		czt_internal::EpochManager::Guard guard;
+		const MyClass * tree;
+
+		friend class ConcurrentZTree;
+	};
+
+	/**
+	 * @brief Inserts <node> into the tree
+	 *
+	 * Safe to call concurrently with all other operations. Draws a random rank
+	 * for <node>.
+	 *
+	 * @param node  The node to be inserted
+	 * @returns true if <node> was inserted, false if an element comparing
+	 * equally to <node> is already in the tree
+	 */
+	bool insert(Node & node);
+
+	/**
+	 * @brief Removes <node> from the tree
+	 *
+	 * Safe to call concurrently with all other operations. The node is handed
+	 * to the NodeTraits' reclaim() hook once no operation can access it
+	 * anymore.
+	 *
+	 * @param node  The node to be removed
+	 * @returns true if <node> was removed, false if it was not in the tree
+	 * (e.g. because it had been removed concurrently)
+	 */
+	bool remove(Node & node);
+
+	/**
+	 * @brief Finds an element
+	 *
+	 * Safe to call concurrently with all other operations. Takes no locks, but
+	 * restarts whenever a writer changes a node on the search path, and waits
+	 * for writers that have locked the root. Concurrent writers can thus delay
+	 * it.
+	 *
+	 * @param query An object comparing equally to the element that should be
+	 * found.
+	 * @param pin   A Pin of this tree. The returned node may only be accessed
+	 * while <pin> lives.
+	 * @returns A pointer to the element comparing equally to <query>, or
+	 * nullptr if no such element exists
+	 */
+	template <class Comparable>
+	Node * find(const Comparable & query, const Pin & pin);
+
+	/**
+	 * @brief Lower-bounds an element
+	 *
+	 * Safe to call concurrently with all other operations. Like find(), it takes
+	 * no locks, but may be delayed by concurrent writers.
+	 *
+	 * @param query An object comparable to Node that should be lower-bounded
+	 * @param pin   A Pin of this tree. The returned node may only be accessed
+	 * while <pin> lives.
+	 * @returns A pointer to the first element not less than <query>, or nullptr
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	Node * lower_bound(const Comparable & query, const Pin & pin);
+
+	/**
+	 * @brief Reclaims removed nodes that are not accessed anymore
+	 *
+	 * remove() does this on its own. Call this to reclaim the last removed nodes
+	 * after the tree has gone quiet.
+	 */
+	void collect();
+
+	/**
+	 * Returns whether the tree is empty. Only a snapshot if other threads modify
+	 * the tree.
+	 */
+	bool empty() const;
+
+	// Debugging methods
+	/**
+	 * @brief Checks the tree's invariants
+	 *
+	 * Checks the search tree order, the rank order and that no node is locked.
+	 * Not synchronized: only call this while no other thread uses the tree.
+	 *
+	 * @returns true if the tree is valid
+	 */
+	bool verify_integrity() const;
+
+private:
+	std::atomic<uint64_t> root_version;
+	std::atomic<Node *> root;
+
+	czt_internal::EpochManager epochs;
+
+	std::mutex retired_mutex;
+	std::vector<std::pair<Node *, uint64_t>> retired;
+
+	NodeTraits traits;
+	Compare cmp;
+
+	// The link through which the node at hand was reached
+	struct Parent
+	{
+		std::atomic<uint64_t> * version;
+		std::atomic<Node *> * link;
+		uint64_t seen;
+	};
+
+	static uint64_t read_version(const std::atomic<uint64_t> & version,
+	                             bool & ok) noexcept;
+	static bool validate(const std::atomic<uint64_t> & version,
+	                     uint64_t seen) noexcept;
+	static bool try_lock(std::atomic<uint64_t> & version, uint64_t seen) noexcept;
+	static void unlock(std::atomic<uint64_t> & version) noexcept;
+	static void unlock_unchanged(std::atomic<uint64_t> & version) noexcept;
+	static void unlock_obsolete(std::atomic<uint64_t> & version) noexcept;
+
+	static uint8_t draw_rank() noexcept;
+
+	// Returns whether <a> must be an ancestor of <b>
+	bool above(const Node & a, const Node & b) const noexcept;
+
+	bool lock_path(Node * start, const Node & node, bool & duplicate);
+	void unlock_path(Node * start, const Node & node, bool changed);
+
+	void retire(Node & node);
+	void reclaim_until(uint64_t epoch);
+
+	bool verify_subtree(const Node * n, const Node * lower,
+	                    const Node * upper) const;
+};
+
+} // namespace ygg
+
+#include "concurrent_ziptree.cpp"
+
+#endif // YGG_CONCURRENT_ZIPTREE_HPP
@@ -0,0 +1,161 @@
+#ifndef YGG_INDEX_LINK_HPP
+#define YGG_INDEX_LINK_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "options.hpp"
+
+namespace ygg {
+namespace internal {
+/// @cond INTERNAL
+
+/*
+ * A link to a node that is stored as a 32-bit index into the contiguous node
+ * array provided by Pool::get_base(). It behaves like a Node *, i.e., it can be
+ * assigned from, compared to and converted to Node *.
+ *
+ * The topmost bit is never used by the index itself. It is available to the
+ * owner of the link via get_flag() / set_flag(), e.g. to store a color.
+ */
+template <class Node, class Pool>
+class IndexLink {
+public:
+	static constexpr uint32_t FLAG_BIT = static_cast<uint32_t>(1) << 31;
+	static constexpr uint32_t NULL_INDEX = FLAG_BIT - 1;
+
+	IndexLink() noexcept : idx(NULL_INDEX) {}
+	IndexLink(Node * n) noexcept : idx(encode(n)) {}
+
+	IndexLink &
+	operator=(Node * n) noexcept
+	{
+		this->idx = encode(n) | (this->idx & FLAG_BIT);
+		return *this;
+	}
+
+	operator Node *() const noexcept { return decode(this->idx & NULL_INDEX); }
+
+	Node * operator->() const noexcept
+	{
+		return decode(this->idx & NULL_INDEX);
+	}
+
+	bool
+	get_flag() const noexcept
+	{
+		return (this->idx & FLAG_BIT) != 0;
+	}
+
+	void
+	set_flag(bool flag) noexcept
+	{
+		if (flag) {
+			this->idx |= FLAG_BIT;
+		} else {
+			this->idx &= ~FLAG_BIT;
+		}
+	}
+
+private:
+	static uint32_t
+	encode(const Node * n) noexcept
+	{
+		if (n == nullptr) {
+			return NULL_INDEX;
+		}
+		// Larger indices would alias NULL_INDEX or clobber FLAG_BIT
+		assert((n >= Pool::get_base()) &&
+		       (static_cast<size_t>(n - Pool::get_base()) < NULL_INDEX));
+		return static_cast<uint32_t>(n - Pool::get_base());
+	}
+
+	static Node *
+	decode(uint32_t i) noexcept
+	{
+		if (i == NULL_INDEX) {
+			return nullptr;
+		}
+		return Pool::get_base() + i;
+	}
+
+	uint32_t idx;
+};
+
+/*
+ * A link to a node that is only ever read and written as a relaxed atomic,
+ * such that it may be followed while another thread changes it. It behaves
+ * like a Node *, just as IndexLink does.
+ */
+template <class Node>
+class AtomicLink {
+public:
+	AtomicLink() noexcept : ptr(nullptr) {}
+	AtomicLink(Node * n) noexcept : ptr(n) {}
+	AtomicLink(const AtomicLink & other) noexcept
+	    : ptr(static_cast<Node *>(other))
+	{}
+
+	AtomicLink &
+	operator=(const AtomicLink & other) noexcept
+	{
+		return *this = static_cast<Node *>(other);
+	}
+
+	AtomicLink &
+	operator=(Node * n) noexcept
+	{
+		this->ptr.store(n, std::memory_order_relaxed);
+		return *this;
+	}
+
+	operator Node *() const noexcept
+	{
+		return this->ptr.load(std::memory_order_relaxed);
+	}
+
+	Node * operator->() const noexcept
+	{
+		return this->ptr.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<Node *> ptr;
+};
+
+/*
+ * Selects the type of the links between nodes: Plain pointers, indices if
+ * TreeFlags::INDEX_LINKS is set, or atomic pointers if TreeFlags::ATOMIC_LINKS
+ * is set.
+ */
+template <class Node, class Links, bool atomic = false>
+struct LinkTypeSelector
+{
+	using type = Node *;
+};
+
+template <class Node>
+struct LinkTypeSelector<Node, bool, true>
+{
+	using type = AtomicLink<Node>;
+};
+
+template <class Node, class Pool, bool atomic>
+struct LinkTypeSelector<Node, TreeFlags::INDEX_LINKS<Pool>, atomic>
+{
+	static_assert(!atomic, "INDEX_LINKS and ATOMIC_LINKS can not be combined.");
+	using type = IndexLink<Node, Pool>;
+};
+
+template <class Node, class Options>
+using LinkType =
+    typename LinkTypeSelector<Node, typename Options::index_links>::type;
+
+/// @endcond
+} // namespace internal
+} // namespace ygg
+
+#endif // YGG_INDEX_LINK_HPP
@@ -0,0 +1,216 @@
+#ifndef YGG_INTERVAL_SNAPSHOT_CPP
+#define YGG_INTERVAL_SNAPSHOT_CPP
+
+#include <algorithm>
+
+#include "interval_snapshot.hpp"
+
+namespace ygg {
+
+template <class Node, class NodeTraits>
+constexpr size_t IntervalSnapshot<Node, NodeTraits>::NONE;
+
+template <class Node, class NodeTraits>
+IntervalSnapshot<Node, NodeTraits>::IntervalSnapshot() : top_end(0)
+{}
+
+template <class Node, class NodeTraits>
+template <class Tree>
+IntervalSnapshot<Node, NodeTraits>::IntervalSnapshot(Tree & tree) : top_end(0)
+{
+	this->rebuild(tree);
+}
+
+template <class Node, class NodeTraits>
+template <class Tree>
+void
+IntervalSnapshot<Node, NodeTraits>::rebuild(Tree & tree)
+{
+	this->build(tree.begin(), tree.end());
+}
+
+template <class Node, class NodeTraits>
+template <class ForwardIt>
+void
+IntervalSnapshot<Node, NodeTraits>::build(ForwardIt begin, ForwardIt end)
+{
+	std::vector<Node *> sorted;
+	for (ForwardIt it = begin; it != end; ++it) {
+		sorted.push_back(&utilities::deref_node<Node>(*it));
+	}
+
+	// Containing intervals must come before the intervals they contain
+	std::stable_sort(sorted.begin(), sorted.end(),
+	                 [](const Node * lhs, const Node * rhs) {
+		                 if (NodeTraits::get_lower(*lhs) < NodeTraits::get_lower(*rhs)) {
+			                 return true;
+		                 }
+		                 if (NodeTraits::get_lower(*rhs) < NodeTraits::get_lower(*lhs)) {
+			                 return false;
+		                 }
+		                 return NodeTraits::get_upper(*rhs) <
+		                        NodeTraits::get_upper(*lhs);
+	                 });
+
+	size_t count = sorted.size();
+
+	// The parent of every interval is the innermost interval containing it.
+	// These are the ones that are still "open" on a stack.
+	std::vector<size_t> sorted_parent(count);
+	std::vector<size_t> open;
+	for (size_t i = 0; i < count; ++i) {
+		while (!open.empty() && (NodeTraits::get_upper(*sorted[open.back()]) <
+		                         NodeTraits::get_upper(*sorted[i]))) {
+			open.pop_back();
+		}
+		sorted_parent[i] = open.empty() ? NONE : open.back();
+		open.push_back(i);
+	}
+
+	// Group the intervals by their parents, keeping them sorted within each
+	// group. The top-level list is group 0, the list contained in the i-th
+	// sorted interval is group i + 1.
+	std::vector<size_t> list_start(count + 2, 0);
+	for (size_t i = 0; i < count; ++i) {
+		size_t group = (sorted_parent[i] == NONE) ? 0 : sorted_parent[i] + 1;
+		list_start[group + 1]++;
+	}
+	for (size_t group = 1; group < count + 2; ++group) {
+		list_start[group] += list_start[group - 1];
+	}
+
+	std::vector<size_t> position(count);
+	std::vector<size_t> next_free(list_start);
+	for (size_t i = 0; i < count; ++i) {
+		size_t group = (sorted_parent[i] == NONE) ? 0 : sorted_parent[i] + 1;
+		position[i] = next_free[group]++;
+	}
+
+	this->lowers.resize(count);
+	this->uppers.resize(count);
+	this->nodes.resize(count);
+	this->sub_begin.resize(count);
+	this->sub_end.resize(count);
+	this->parent.resize(count);
+	this->top_end = list_start[1];
+
+	for (size_t i = 0; i < count; ++i) {
+		size_t pos = position[i];
+		this->lowers[pos] = NodeTraits::get_lower(*sorted[i]);
+		this->uppers[pos] = NodeTraits::get_upper(*sorted[i]);
+		this->nodes[pos] = sorted[i];
+		this->sub_begin[pos] = list_start[i + 1];
+		this->sub_end[pos] = list_start[i + 2];
+		this->parent[pos] =
+		    (sorted_parent[i] == NONE) ? NONE : position[sorted_parent[i]];
+	}
+}
+
+template <class Node, class NodeTraits>
+size_t
+IntervalSnapshot<Node, NodeTraits>::first_reaching(size_t begin, size_t end,
+                                                   const Key & lower) const
+{
+	// Within a list, the upper bounds are sorted
+	return static_cast<size_t>(
+	    std::lower_bound(this->uppers.begin() + static_cast<ptrdiff_t>(begin),
+	                     this->uppers.begin() + static_cast<ptrdiff_t>(end),
+	                     lower) -
+	    this->uppers.begin());
+}
+
+template <class Node, class NodeTraits>
+template <class Comparable, class Visitor>
+void
+IntervalSnapshot<Node, NodeTraits>::traverse(const Comparable & q,
+                                             Visitor && visitor) const
+{
+	if (this->empty()) {
+		return;
+	}
+
+	const Key q_lower = NodeTraits::get_lower(q);
+	const Key q_upper = NodeTraits::get_upper(q);
+
+	// The entry owning the list we are scanning, and the end of that list
+	size_t owner = NONE;
+	size_t list_end = this->top_end;
+	size_t i = this->first_reaching(0, this->top_end, q_lower);
+
+	while (true) {
+		if ((i < list_end) && !(q_upper < this->lowers[i])) {
+			visitor(i);
+
+			size_t sub = this->first_reaching(this->sub_begin[i], this->sub_end[i],
+			                                  q_lower);
+			if (sub < this->sub_end[i]) {
+				// Descend into the contained intervals
+				owner = i;
+				list_end = this->sub_end[i];
+				i = sub;
+			} else {
+				i++;
+			}
+			continue;
+		}
+
+		// This list is done, continue after its owner
+		if (owner == NONE) {
+			return;
+		}
+		i = owner + 1;
+		owner = this->parent[owner];
+		list_end = (owner == NONE) ? this->top_end : this->sub_end[owner];
+	}
+}
+
+template <class Node, class NodeTraits>
+template <class Comparable, class Callback>
+void
+IntervalSnapshot<Node, NodeTraits>::query(const Comparable & q,
+                                          Callback && callback) const
+{
+	this->traverse(q, [&](size_t i) { callback(*this->nodes[i]); });
+}
+
+template <class Node, class NodeTraits>
+template <class Comparable>
+bool
+IntervalSnapshot<Node, NodeTraits>::any_overlap(const Comparable & q) const
+{
+	// Contained intervals can only overlap q if their container does.
+	size_t i = this->first_reaching(0, this->top_end, NodeTraits::get_lower(q));
+	return (i < this->top_end) &&
+	       !(NodeTraits::get_upper(q) < this->lowers[i]);
+}
+
+template <class Node, class NodeTraits>
+template <class Comparable>
+size_t
+IntervalSnapshot<Node, NodeTraits>::count_overlaps(const Comparable & q) const
+{
+	size_t count = 0;
+	this->traverse(q, [&](size_t i) {
+		(void)i;
+		count++;
+	});
+	return count;
+}
+
+template <class Node, class NodeTraits>
+size_t
+IntervalSnapshot<Node, NodeTraits>::size() const noexcept
+{
+	return this->nodes.size();
+}
+
+template <class Node, class NodeTraits>
+bool
+IntervalSnapshot<Node, NodeTraits>::empty() const noexcept
+{
+	return this->nodes.empty();
+}
+
+} // namespace ygg
+
+#endif // YGG_INTERVAL_SNAPSHOT_CPP
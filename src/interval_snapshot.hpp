@@ -0,0 +1,154 @@
+#ifndef YGG_INTERVAL_SNAPSHOT_HPP
+#define YGG_INTERVAL_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "util.hpp"
+
+namespace ygg {
+
+/**
+ * @brief A read-only, cache-friendly overlap index over the nodes of an
+ * IntervalTree
+ *
+ * An IntervalSnapshot freezes the current contents of an IntervalTree (or any
+ * range of interval nodes) into a nested containment list (NCList): The
+ * intervals that are not contained in any other interval form the top-level
+ * list. Every interval owns the list of the intervals directly contained in
+ * it. Within a list, no interval contains another, thus the lists are sorted
+ * by both their lower and their upper bounds, and the first overlapping
+ * interval of a list can be found by binary search.
+ *
+ * All lists are stored contiguously in flat arrays, with the bounds kept
+ * separate from the node pointers. A query therefore scans arrays instead of
+ * chasing child and parent pointers, and does not need a stack.
+ *
+ * The results are references to the nodes in the tree. The snapshot does not
+ * notice changes to the tree. After modifying the tree, call rebuild(). Any
+ * node that is removed from the tree must not be accessed via the snapshot
+ * anymore.
+ *
+ * @tparam Node         The node class
+ * @tparam NodeTraits   The node traits of the IntervalTree, see
+ * ITreeNodeTraits. Queries must be comparable to intervals, see
+ * IntervalTree::query().
+ */
+template <class Node, class NodeTraits>
+class IntervalSnapshot {
+public:
+	using Key = typename NodeTraits::key_type;
+
+	/**
+	 * @brief Creates an empty snapshot
+	 */
+	IntervalSnapshot();
+
+	/**
+	 * @brief Creates a snapshot of the current contents of <tree>
+	 *
+	 * @param tree  The tree to be frozen. Anything that can be iterated works,
+	 * e.g. an IntervalTree.
+	 */
+	template <class Tree>
+	explicit IntervalSnapshot(Tree & tree);
+
+	/**
+	 * @brief Replaces the contents of the snapshot with the contents of <tree>
+	 *
+	 * Runs in O(n log n).
+	 *
+	 * @param tree  The tree to be frozen
+	 */
+	template <class Tree>
+	void rebuild(Tree & tree);
+
+	/**
+	 * @brief Replaces the contents of the snapshot with a range of nodes
+	 *
+	 * The range can either contain nodes or pointers to nodes, in any order.
+	 * Runs in O(n log n).
+	 *
+	 * @param begin   Iterator to the first node (or node pointer)
+	 * @param end     Iterator past the last node (or node pointer)
+	 */
+	template <class ForwardIt>
+	void build(ForwardIt begin, ForwardIt end);
+
+	/**
+	 * @brief Reports all intervals overlapping a query
+	 *
+	 * Calls callback(Node & node) for every interval that overlaps <q>. The
+	 * intervals are reported sorted by their lower bounds, but among intervals
+	 * with the same lower bound, the longer one is reported first. Runs in
+	 * O(log n + k) for k reported intervals, up to one binary search per
+	 * reported interval that contains other intervals.
+	 *
+	 * @param q         Anything that is comparable to an interval, see
+	 * IntervalTree::query()
+	 * @param callback  Called for every overlapping interval
+	 */
+	template <class Comparable, class Callback>
+	void query(const Comparable & q, Callback && callback) const;
+
+	/**
+	 * @brief Checks whether any interval overlaps a query
+	 *
+	 * Only the top-level list must be searched for this. Thus, this runs in
+	 * O(log n).
+	 *
+	 * @param q   Anything that is comparable to an interval, see
+	 * IntervalTree::query()
+	 * @result true if at least one interval overlaps q
+	 */
+	template <class Comparable>
+	bool any_overlap(const Comparable & q) const;
+
+	/**
+	 * @brief Counts the intervals overlapping a query
+	 *
+	 * Does the same search as query(), but only counts the results.
+	 *
+	 * @param q   Anything that is comparable to an interval, see
+	 * IntervalTree::query()
+	 * @result The number of intervals overlapping q
+	 */
+	template <class Comparable>
+	size_t count_overlaps(const Comparable & q) const;
+
+	/**
+	 * Returns the number of nodes in the snapshot.
+	 */
+	size_t size() const noexcept;
+
+	/**
+	 * Returns whether the snapshot is empty.
+	 */
+	bool empty() const noexcept;
+
+private:
+	static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+	// All lists are stored back to back. The top-level list is [0, top_end).
+	std::vector<Key> lowers;
+	std::vector<Key> uppers;
+	std::vector<Node *> nodes;
+	// The list contained in entry i is [sub_begin[i], sub_end[i]).
+	std::vector<size_t> sub_begin;
+	std::vector<size_t> sub_end;
+	// The entry whose list contains entry i, or NONE for the top-level list.
+	std::vector<size_t> parent;
+	size_t top_end;
+
+	size_t first_reaching(size_t begin, size_t end, const Key & lower) const;
+
+	template <class Comparable, class Visitor>
+	void traverse(const Comparable & q, Visitor && visitor) const;
+};
+
+} // namespace ygg
+
+#include "interval_snapshot.cpp"
+
+#endif // YGG_INTERVAL_SNAPSHOT_HPP
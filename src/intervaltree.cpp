@@ -37,6 +37,9 @@ ExtendedNodeTraits<Node, INB, NodeTraits>::leaf_inserted(Node & node,
 		cur->INB::_it_max_upper = node.INB::_it_max_upper;
 		cur = cur->get_parent();
 	}
+
+	MinUppers::leaf_inserted(node);
+	MinLowers::leaf_inserted(node);
 }
 
 template <class Node, class INB, class NodeTraits>
@@ -44,6 +47,8 @@ void
 ExtendedNodeTraits<Node, INB, NodeTraits>::fix_node(Node & node)
 {
 	auto old_val = node.INB::_it_max_upper;
+	auto old_min = MinUppers::get(node);
+	auto old_min_lower = MinLowers::get(node);
 	node.INB::_it_max_upper = NodeTraits::get_upper(node);
 
 	if (node._rbt_left != nullptr) {
@@ -56,14 +61,18 @@ ExtendedNodeTraits<Node, INB, NodeTraits>::fix_node(Node & node)
 		    std::max(node.INB::_it_max_upper, node._rbt_right->INB::_it_max_upper);
 	}
 
-	if (old_val != node.INB::_it_max_upper) {
-		// propagate up
-		Node * cur = node.get_parent();
-		if (cur != nullptr) {
-			if ((cur->INB::_it_max_upper < node.INB::_it_max_upper) ||
-			    (cur->INB::_it_max_upper == old_val)) {
-				fix_node(*cur);
-			}
+	MinUppers::fix(node);
+	MinLowers::fix(node);
+
+	// propagate up
+	Node * cur = node.get_parent();
+	if (cur != nullptr) {
+		if (((old_val != node.INB::_it_max_upper) &&
+		     ((cur->INB::_it_max_upper < node.INB::_it_max_upper) ||
+		      (cur->INB::_it_max_upper == old_val))) ||
+		    MinUppers::parent_outdated(node, old_min, *cur) ||
+		    MinLowers::parent_outdated(node, old_min_lower, *cur)) {
+			fix_node(*cur);
 		}
 	}
 }
@@ -124,6 +133,31 @@ ExtendedNodeTraits<Node, INB, NodeTraits>::swapped(Node & n1, Node & n2,
 	}
 }
 
+template <class Node, class INB, class NodeTraits>
+template <class BaseTree>
+void
+ExtendedNodeTraits<Node, INB, NodeTraits>::rebuilt(Node & node, BaseTree & t)
+{
+	(void)t;
+
+	// The children are already up to date and the parent is not yet valid, so
+	// we must not propagate upwards here.
+	node.INB::_it_max_upper = NodeTraits::get_upper(node);
+
+	if (node._rbt_left != nullptr) {
+		node.INB::_it_max_upper =
+		    std::max(node.INB::_it_max_upper, node._rbt_left->INB::_it_max_upper);
+	}
+
+	if (node._rbt_right != nullptr) {
+		node.INB::_it_max_upper =
+		    std::max(node.INB::_it_max_upper, node._rbt_right->INB::_it_max_upper);
+	}
+
+	MinUppers::fix(node);
+	MinLowers::fix(node);
+}
+
 template <class Node, class INB, class NodeTraits>
 typename NodeTraits::key_type
 ExtendedNodeTraits<Node, INB, NodeTraits>::get_lower(
@@ -177,6 +211,10 @@ IntervalTree<Node, NodeTraits, Options, Tag>::verify_maxima(Node * n) const
 	}
 
 	valid &= (maximum == n->INB::_it_max_upper);
+	valid &= intervaltree_internal::MinUppers<
+	    Node, INB, NodeTraits, Options::itree_count_overlaps>::verify(*n);
+	valid &= intervaltree_internal::MinLowers<
+	    Node, INB, NodeTraits, Options::itree_min_lower>::verify(*n);
 
 	return valid;
 }
@@ -193,10 +231,76 @@ template <class Comparable>
 typename IntervalTree<Node, NodeTraits, Options,
                       Tag>::template QueryResult<Comparable>
 IntervalTree<Node, NodeTraits, Options, Tag>::query(const Comparable & q) const
+{
+	return QueryResult<Comparable>(this->find_first_overlap(q), q);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag>
+template <class Comparable>
+bool
+IntervalTree<Node, NodeTraits, Options, Tag>::any_overlap(
+    const Comparable & q) const
+{
+	return this->find_first_overlap(q) != nullptr;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag>
+template <class Comparable>
+size_t
+IntervalTree<Node, NodeTraits, Options, Tag>::count_overlaps(
+    const Comparable & q) const
+{
+	static_assert(Options::order_statistics && Options::itree_count_overlaps,
+	              "count_overlaps() requires ORDER_STATISTICS and "
+	              "ITREE_COUNT_OVERLAPS to be set.");
+
+	return this->count_overlaps_below(this->root, q, false);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag>
+template <class Comparable>
+size_t
+IntervalTree<Node, NodeTraits, Options, Tag>::count_overlaps_below(
+    const Node * n, const Comparable & q, bool all_start_before) const
+{
+	// all_start_before indicates that no interval below n starts after q ends
+	if ((n == nullptr) ||
+	    (n->INB::_it_max_upper < NodeTraits::get_lower(q)) ||
+	    intervaltree_internal::MinLowers<
+	        Node, INB, NodeTraits, Options::itree_min_lower>::starts_after(*n,
+	                                                                       q)) {
+		return 0;
+	}
+
+	if (all_start_before &&
+	    !(n->INB::_it_min_upper < NodeTraits::get_lower(q))) {
+		// Every interval below n overlaps
+		return BaseTree::NodeInterface::get_subtree_size(n);
+	}
+
+	if (NodeTraits::get_lower(*n) > NodeTraits::get_upper(q)) {
+		// Neither n nor anything to its right can overlap
+		return this->count_overlaps_below(n->_rbt_left, q, false);
+	}
+
+	size_t count = this->count_overlaps_below(n->_rbt_left, q, true);
+	if (NodeTraits::get_upper(*n) >= NodeTraits::get_lower(q)) {
+		count++;
+	}
+	count += this->count_overlaps_below(n->_rbt_right, q, all_start_before);
+
+	return count;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag>
+template <class Comparable>
+Node *
+IntervalTree<Node, NodeTraits, Options, Tag>::find_first_overlap(
+    const Comparable & q) const
 {
 	Node * cur = this->root;
 	if (this->root == nullptr) {
-		return QueryResult<Comparable>(nullptr, q);
+		return nullptr;
 	}
 
 	// Find the smallest node s.t. not everything below it ends too early
@@ -216,7 +320,60 @@ IntervalTree<Node, NodeTraits, Options, Tag>::query(const Comparable & q) const
 		                                                 false, Comparable>(cur, q);
 	}
 
-	return QueryResult<Comparable>(hit, q);
+	return hit;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag>
+template <class QueryIt, class Callback>
+void
+IntervalTree<Node, NodeTraits, Options, Tag>::query_batch(
+    QueryIt queries_begin, QueryIt queries_end, Callback && callback) const
+{
+	using Comparable = typename std::iterator_traits<QueryIt>::value_type;
+
+	if ((this->root == nullptr) || (queries_begin == queries_end)) {
+		return;
+	}
+
+	/* The cursor is the smallest node that does not end before the lower bound
+	 * of the current query. Since the lower bounds of the queries do not
+	 * decrease, the cursor only ever moves forward. Thus, we descend from the
+	 * root only once, and the cursor is advanced via the same max-upper
+	 * pruning that find_next_overlapping uses. */
+	const Comparable & first_query = *queries_begin;
+	Node * cursor = this->root;
+	while ((cursor->_rbt_left != nullptr) &&
+	       (cursor->_rbt_left->INB::_it_max_upper >=
+	        NodeTraits::get_lower(first_query))) {
+		cursor = cursor->_rbt_left;
+	}
+
+	size_t index = 0;
+	for (QueryIt it = queries_begin; it != queries_end; ++it, ++index) {
+		const Comparable & q = *it;
+
+		if (NodeTraits::get_upper(*cursor) < NodeTraits::get_lower(q)) {
+			cursor = intervaltree_internal::find_next_candidate<
+			    Node, INB, NodeTraits, false, Comparable>(cursor, q);
+			if (cursor == nullptr) {
+				// Everything ends before this query, and thus before all
+				// following queries.
+				return;
+			}
+		}
+
+		if (NodeTraits::get_lower(*cursor) > NodeTraits::get_upper(q)) {
+			// The first interval that reaches the query starts after it
+			continue;
+		}
+
+		Node * hit = cursor;
+		while (hit != nullptr) {
+			callback(index, static_cast<const Node &>(*hit));
+			hit = intervaltree_internal::find_next_overlapping<
+			    Node, INB, NodeTraits, false, Comparable>(hit, q);
+		}
+	}
 }
 
 template <class Node, class NodeTraits, class Options, class Tag>
@@ -246,6 +403,14 @@ template <class Node, class INB, class NodeTraits, bool skipfirst,
           class Comparable>
 Node *
 find_next_overlapping(Node * cur, const Comparable & q)
+{
+	return find_next_candidate<Node, INB, NodeTraits, true, Comparable>(cur, q);
+}
+
+template <class Node, class INB, class NodeTraits, bool bounded,
+          class Comparable>
+Node *
+find_next_candidate(Node * cur, const Comparable & q)
 {
 	// We search for the next bigger node, pruning the search as necessary. When
 	// Pruning occurrs, we need to restart the search for the next larger node.
@@ -257,6 +422,13 @@ find_next_overlapping(Node * cur, const Comparable & q)
 		if (cur->_rbt_right != nullptr) {
 			// go to smallest larger-or-equal child
 			cur = cur->_rbt_right;
+			// TODO constexpr - if
+			if (bounded && MinLowers<Node, INB, NodeTraits,
+			                         INB::_it_track_min_lower>::starts_after(*cur,
+			                                                                 q)) {
+				// Everything in this subtree and every larger node starts after q
+				return nullptr;
+			}
 			if (cur->INB::_it_max_upper < NodeTraits::get_lower(q)) {
 				// Prune!
 				// Nothing starting from this node can overlap b/c of upper limit.
@@ -307,7 +479,9 @@ find_next_overlapping(Node * cur, const Comparable & q)
 			}
 		}
 
-		if (NodeTraits::get_lower(*cur) > NodeTraits::get_upper(q)) {
+		// TODO constexpr - if
+		if (bounded &&
+		    (NodeTraits::get_lower(*cur) > NodeTraits::get_upper(q))) {
 			// No larger node can be an overlap!
 			return nullptr;
 		}
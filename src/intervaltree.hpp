@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <string>
 
 #include "rbtree.hpp"
@@ -13,6 +14,14 @@ template <class Node, class INB, class NodeTraits, bool skipfirst,
           class Comparable>
 Node * find_next_overlapping(Node * cur, const Comparable & q);
 
+/*
+ * Finds the next node after cur that does not end before q starts. If bounded
+ * is set, the search stops at nodes that start after q ends.
+ */
+template <class Node, class INB, class NodeTraits, bool bounded,
+          class Comparable>
+Node * find_next_candidate(Node * cur, const Comparable & q);
+
 template <class KeyType>
 class DummyRange : public std::pair<KeyType, KeyType> {
 public:
@@ -26,9 +35,272 @@ public:
 	bool operator()(const T1 & lhs, const T2 & rhs) const;
 };
 
+/*
+ * Storage for the subtree minimum of the upper interval bounds. This is only
+ * kept if TreeFlags::ITREE_COUNT_OVERLAPS is set, see
+ * IntervalTree::count_overlaps().
+ */
+template <class KeyType, bool enable>
+class MinUpperStorage {
+};
+
+template <class KeyType>
+class MinUpperStorage<KeyType, true> {
+public:
+	KeyType _it_min_upper;
+};
+
+/*
+ * Maintenance of the subtree minima of the upper interval bounds. All of these
+ * are no-ops if TreeFlags::ITREE_COUNT_OVERLAPS is not set.
+ */
+template <class Node, class INB, class NodeTraits, bool enable>
+struct MinUppers;
+
+template <class Node, class INB, class NodeTraits>
+struct MinUppers<Node, INB, NodeTraits, true>
+{
+	using Key = typename NodeTraits::key_type;
+
+	static Key
+	get(const Node & node)
+	{
+		return node.INB::_it_min_upper;
+	}
+
+	static void
+	leaf_inserted(Node & node)
+	{
+		node.INB::_it_min_upper = NodeTraits::get_upper(node);
+
+		Node * cur = node.get_parent();
+		while ((cur != nullptr) &&
+		       (node.INB::_it_min_upper < cur->INB::_it_min_upper)) {
+			cur->INB::_it_min_upper = node.INB::_it_min_upper;
+			cur = cur->get_parent();
+		}
+	}
+
+	static void
+	fix(Node & node)
+	{
+		node.INB::_it_min_upper = NodeTraits::get_upper(node);
+
+		if (node._rbt_left != nullptr) {
+			node.INB::_it_min_upper =
+			    std::min(node.INB::_it_min_upper, node._rbt_left->INB::_it_min_upper);
+		}
+
+		if (node._rbt_right != nullptr) {
+			node.INB::_it_min_upper = std::min(node.INB::_it_min_upper,
+			                                   node._rbt_right->INB::_it_min_upper);
+		}
+	}
+
+	static bool
+	parent_outdated(const Node & node, const Key & old_val, const Node & parent)
+	{
+		return (old_val != node.INB::_it_min_upper) &&
+		       ((node.INB::_it_min_upper < parent.INB::_it_min_upper) ||
+		        (parent.INB::_it_min_upper == old_val));
+	}
+
+	static bool
+	verify(const Node & node)
+	{
+		auto minimum = NodeTraits::get_upper(node);
+		if (node._rbt_left != nullptr) {
+			minimum = std::min(minimum, node._rbt_left->INB::_it_min_upper);
+		}
+		if (node._rbt_right != nullptr) {
+			minimum = std::min(minimum, node._rbt_right->INB::_it_min_upper);
+		}
+		return minimum == node.INB::_it_min_upper;
+	}
+};
+
+template <class Node, class INB, class NodeTraits>
+struct MinUppers<Node, INB, NodeTraits, false>
+{
+	static bool
+	get(const Node & node)
+	{
+		(void)node;
+		return false;
+	}
+
+	static void
+	leaf_inserted(Node & node)
+	{
+		(void)node;
+	}
+
+	static void
+	fix(Node & node)
+	{
+		(void)node;
+	}
+
+	static bool
+	parent_outdated(const Node & node, bool old_val, const Node & parent)
+	{
+		(void)node;
+		(void)old_val;
+		(void)parent;
+		return false;
+	}
+
+	static bool
+	verify(const Node & node)
+	{
+		(void)node;
+		return true;
+	}
+};
+
+/*
+ * Storage for the subtree minimum of the lower interval bounds if
+ * TreeFlags::ITREE_MIN_LOWER is set.
+ */
+template <class KeyType, bool enable>
+class MinLowerStorage {
+};
+
+template <class KeyType>
+class MinLowerStorage<KeyType, true> {
+public:
+	KeyType _it_min_lower;
+};
+
+/*
+ * Maintenance of the subtree minima of the lower interval bounds. All of these
+ * are no-ops if TreeFlags::ITREE_MIN_LOWER is not set.
+ */
+template <class Node, class INB, class NodeTraits, bool enable>
+struct MinLowers;
+
+template <class Node, class INB, class NodeTraits>
+struct MinLowers<Node, INB, NodeTraits, true>
+{
+	using Key = typename NodeTraits::key_type;
+
+	static Key
+	get(const Node & node)
+	{
+		return node.INB::_it_min_lower;
+	}
+
+	static void
+	leaf_inserted(Node & node)
+	{
+		node.INB::_it_min_lower = NodeTraits::get_lower(node);
+
+		Node * cur = node.get_parent();
+		while ((cur != nullptr) &&
+		       (node.INB::_it_min_lower < cur->INB::_it_min_lower)) {
+			cur->INB::_it_min_lower = node.INB::_it_min_lower;
+			cur = cur->get_parent();
+		}
+	}
+
+	static void
+	fix(Node & node)
+	{
+		// The tree is ordered by the lower bounds, thus the minimum is at the left
+		if (node._rbt_left != nullptr) {
+			node.INB::_it_min_lower = node._rbt_left->INB::_it_min_lower;
+		} else {
+			node.INB::_it_min_lower = NodeTraits::get_lower(node);
+		}
+	}
+
+	static bool
+	parent_outdated(const Node & node, const Key & old_val, const Node & parent)
+	{
+		return (old_val != node.INB::_it_min_lower) &&
+		       ((node.INB::_it_min_lower < parent.INB::_it_min_lower) ||
+		        (parent.INB::_it_min_lower == old_val));
+	}
+
+	template <class Comparable>
+	static bool
+	starts_after(const Node & node, const Comparable & q)
+	{
+		return node.INB::_it_min_lower > NodeTraits::get_upper(q);
+	}
+
+	static bool
+	verify(const Node & node)
+	{
+		auto minimum = NodeTraits::get_lower(node);
+		if (node._rbt_left != nullptr) {
+			minimum = std::min(minimum, node._rbt_left->INB::_it_min_lower);
+		}
+		if (node._rbt_right != nullptr) {
+			minimum = std::min(minimum, node._rbt_right->INB::_it_min_lower);
+		}
+		return minimum == node.INB::_it_min_lower;
+	}
+};
+
+template <class Node, class INB, class NodeTraits>
+struct MinLowers<Node, INB, NodeTraits, false>
+{
+	static bool
+	get(const Node & node)
+	{
+		(void)node;
+		return false;
+	}
+
+	static void
+	leaf_inserted(Node & node)
+	{
+		(void)node;
+	}
+
+	static void
+	fix(Node & node)
+	{
+		(void)node;
+	}
+
+	static bool
+	parent_outdated(const Node & node, bool old_val, const Node & parent)
+	{
+		(void)node;
+		(void)old_val;
+		(void)parent;
+		return false;
+	}
+
+	template <class Comparable>
+	static bool
+	starts_after(const Node & node, const Comparable & q)
+	{
+		(void)node;
+		(void)q;
+		return false;
+	}
+
+	static bool
+	verify(const Node & node)
+	{
+		(void)node;
+		return true;
+	}
+};
+
 // TODO add a possibility for bulk updates
 template <class Node, class INB, class NodeTraits>
 class ExtendedNodeTraits : public NodeTraits {
+	using MinUppers =
+	    intervaltree_internal::MinUppers<Node, INB, NodeTraits,
+	                                     INB::_it_track_min_upper>;
+	using MinLowers =
+	    intervaltree_internal::MinLowers<Node, INB, NodeTraits,
+	                                     INB::_it_track_min_lower>;
+
 public:
 	// TODO these can probably made more efficient
 	template <class BaseTree>
@@ -50,6 +322,8 @@ public:
 	}
 	template <class BaseTree>
 	static void swapped(Node & n1, Node & n2, BaseTree & t);
+	template <class BaseTree>
+	static void rebuilt(Node & node, BaseTree & t);
 
 	// Make our DummyRange comparable
 	static typename NodeTraits::key_type get_lower(
@@ -63,9 +337,19 @@ public:
 
 template <class Node, class NodeTraits, class Options = DefaultOptions,
           class Tag = int>
-class ITreeNodeBase : public RBTreeNodeBase<Node, Options, Tag> {
+class ITreeNodeBase
+    : public RBTreeNodeBase<Node, Options, Tag>,
+      public intervaltree_internal::MinUpperStorage<
+          typename NodeTraits::key_type, Options::itree_count_overlaps>,
+      public intervaltree_internal::MinLowerStorage<
+          typename NodeTraits::key_type, Options::itree_min_lower> {
 public:
 	typename NodeTraits::key_type _it_max_upper;
+
+	/// @cond INTERNAL
+	static constexpr bool _it_track_min_upper = Options::itree_count_overlaps;
+	static constexpr bool _it_track_min_lower = Options::itree_min_lower;
+	/// @endcond
 };
 
 /**
@@ -212,6 +496,64 @@ public:
 	template <class Comparable>
 	QueryResult<Comparable> query(const Comparable & q) const;
 
+	/**
+	 * @brief Checks whether any interval in the tree overlaps a query
+	 *
+	 * This does the same search as query(), but stops at the first overlapping
+	 * interval.
+	 *
+	 * @param q Anything that is comparable (i.e., has get_lower() and
+	 * get_upper() methods in NodeTraits) to an interval
+	 * @result true if at least one interval in the tree overlaps q
+	 */
+	template <class Comparable>
+	bool any_overlap(const Comparable & q) const;
+
+	/**
+	 * @brief Counts the intervals in the tree that overlap a query
+	 *
+	 * Instead of visiting every overlapping interval, whole subtrees are counted
+	 * at once if all intervals in them are known to overlap q, using the subtree
+	 * sizes and the subtree minima of the upper interval bounds. Subtrees in
+	 * which no interval can overlap q are skipped. For stabbing queries on sets
+	 * of similarly long intervals, this visits O(log n) nodes.
+	 *
+	 * @warning This method is only available if both ORDER_STATISTICS and
+	 * ITREE_COUNT_OVERLAPS are set as options. Together, they make every node
+	 * store its subtree size and the subtree minimum of the upper interval
+	 * bounds.
+	 *
+	 * @param q Anything that is comparable (i.e., has get_lower() and
+	 * get_upper() methods in NodeTraits) to an interval
+	 * @result The number of intervals in the tree that overlap q
+	 */
+	template <class Comparable>
+	size_t count_overlaps(const Comparable & q) const;
+
+	/**
+	 * @brief Answers a batch of queries in a single sweep over the tree
+	 *
+	 * This does the same as calling query() for every element of the range
+	 * [queries_begin, queries_end), but the queries must be sorted by their
+	 * lower bounds (as returned by NodeTraits::get_lower()). Instead of starting
+	 * every query at the root, the search for the first candidate of a query
+	 * continues where the search for the previous query stopped.
+	 *
+	 * For every pair of a query and an interval overlapping it, <callback> is
+	 * called as callback(size_t query_index, const Node & node), where
+	 * query_index is the position of the query in the given range. For each
+	 * query, the overlapping intervals are reported in the same order in which
+	 * query() would report them, and the queries are processed in order.
+	 *
+	 * @param queries_begin Iterator to the first query. The value type must be
+	 * comparable to an interval, see query().
+	 * @param queries_end Iterator past the last query
+	 * @param callback Called for every overlap that is found
+	 */
+	template <class QueryIt, class Callback>
+	void query_batch(QueryIt queries_begin, QueryIt queries_end,
+	                 Callback && callback) const;
+
 	template <class Comparable>
 	typename BaseTree::template const_iterator<false>
 	interval_upper_bound(const Comparable & query_range) const;
@@ -221,6 +563,12 @@ public:
 
 private:
 	bool verify_maxima(Node * n) const;
+
+	template <class Comparable>
+	Node * find_first_overlap(const Comparable & q) const;
+	template <class Comparable>
+	size_t count_overlaps_below(const Node * n, const Comparable & q,
+	                            bool all_start_before) const;
 };
 
 } // namespace ygg
@@ -0,0 +1,168 @@
+#ifndef YGG_NODE_POOL_CPP
+#define YGG_NODE_POOL_CPP
+
+#include "node_pool.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace ygg {
+
+template <class Node>
+constexpr size_t
+NodePool<Node>::default_slab_nodes() noexcept
+{
+	return std::max(static_cast<size_t>(16),
+	                static_cast<size_t>(64 * 1024 / sizeof(Slot)));
+}
+
+template <class Node>
+NodePool<Node>::NodePool(size_t slab_nodes_in) noexcept
+    : slab_nodes(std::max(slab_nodes_in, static_cast<size_t>(1))),
+      free_list(nullptr), bump_index(slab_nodes), allocated(0)
+{}
+
+template <class Node>
+NodePool<Node>::~NodePool()
+{
+	// TODO constexpr - if
+	if (std::is_trivially_destructible<Node>::value || (this->allocated == 0)) {
+		return;
+	}
+
+	// All used slots that are not in the free list hold live nodes
+	std::vector<Slot *> free_slots;
+	for (Slot * s = this->free_list; s != nullptr; s = s->next_free) {
+		free_slots.push_back(s);
+	}
+	std::sort(free_slots.begin(), free_slots.end());
+
+	for (size_t i = 0; i < this->slabs.size(); ++i) {
+		size_t used =
+		    (i + 1 == this->slabs.size()) ? this->bump_index : this->slab_nodes;
+		for (size_t j = 0; j < used; ++j) {
+			Slot * s = &this->slabs[i][j];
+			if (!std::binary_search(free_slots.begin(), free_slots.end(), s)) {
+				reinterpret_cast<Node *>(&s->storage)->~Node();
+			}
+		}
+	}
+}
+
+template <class Node>
+void
+NodePool<Node>::add_slab()
+{
+	this->slabs.emplace_back(new Slot[this->slab_nodes]);
+	this->bump_index = 0;
+}
+
+template <class Node>
+template <class... Args>
+Node *
+NodePool<Node>::construct(Args &&... args)
+{
+	Slot * s;
+	if (this->free_list != nullptr) {
+		s = this->free_list;
+		this->free_list = s->next_free;
+	} else {
+		if (this->bump_index == this->slab_nodes) {
+			this->add_slab();
+		}
+		s = &this->slabs.back()[this->bump_index];
+		this->bump_index++;
+	}
+
+	Node * n;
+	try {
+		n = new (&s->storage) Node(std::forward<Args>(args)...);
+	} catch (...) {
+		s->next_free = this->free_list;
+		this->free_list = s;
+		throw;
+	}
+
+	this->allocated++;
+	return n;
+}
+
+template <class Node>
+void
+NodePool<Node>::destroy(Node * n) noexcept
+{
+	n->~Node();
+
+	Slot * s = reinterpret_cast<Slot *>(n);
+	s->next_free = this->free_list;
+	this->free_list = s;
+
+	this->allocated--;
+}
+
+template <class Node>
+template <class Container, class... Args>
+Node *
+NodePool<Node>::emplace_insert(Container & c, Args &&... args)
+{
+	Node * n = this->construct(std::forward<Args>(args)...);
+	pool_internal::ContainerAdapter<Container>::insert(c, *n);
+	return n;
+}
+
+template <class Node>
+template <class Container>
+void
+NodePool<Node>::erase_and_free(Container & c, Node & n) noexcept
+{
+	pool_internal::ContainerAdapter<Container>::remove(c, n);
+	this->destroy(&n);
+}
+
+template <class Node>
+void
+NodePool<Node>::reserve(size_t n)
+{
+	size_t available = this->capacity() - this->allocated;
+	while (this->allocated + available < n) {
+		if (this->bump_index == this->slab_nodes) {
+			this->add_slab();
+		} else {
+			// Keep bump-allocating from the current slab, which must stay the last
+			// one. The slots of the new slab go into the free list.
+			auto slab = this->slabs.emplace(this->slabs.end() - 1,
+			                                new Slot[this->slab_nodes]);
+			for (size_t i = this->slab_nodes; i > 0; --i) {
+				(*slab)[i - 1].next_free = this->free_list;
+				this->free_list = &(*slab)[i - 1];
+			}
+		}
+		available += this->slab_nodes;
+	}
+}
+
+template <class Node>
+size_t
+NodePool<Node>::size() const noexcept
+{
+	return this->allocated;
+}
+
+template <class Node>
+size_t
+NodePool<Node>::capacity() const noexcept
+{
+	return this->slabs.size() * this->slab_nodes;
+}
+
+template <class Node>
+NodePool<Node> &
+NodePool<Node>::thread_local_pool()
+{
+	thread_local NodePool<Node> pool;
+	return pool;
+}
+
+} // namespace ygg
+
+#endif // YGG_NODE_POOL_CPP
@@ -0,0 +1,211 @@
+#ifndef YGG_NODE_POOL_HPP
+#define YGG_NODE_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "list.hpp"
+
+namespace ygg {
+
+namespace pool_internal {
+/// @cond INTERNAL
+
+/*
+ * Tells the NodePool how to put nodes into and take nodes out of a container.
+ * Trees use insert(Node &) / remove(Node &), lists append at the end.
+ */
+template <class Container>
+struct ContainerAdapter
+{
+	template <class Node>
+	static void
+	insert(Container & c, Node & n)
+	{
+		c.insert(n);
+	}
+
+	template <class Node>
+	static void
+	remove(Container & c, Node & n)
+	{
+		c.remove(n);
+	}
+};
+
+template <class ListNode, class Options, class Tag>
+struct ContainerAdapter<List<ListNode, Options, Tag>>
+{
+	template <class Node>
+	static void
+	insert(List<ListNode, Options, Tag> & l, Node & n)
+	{
+		l.insert(nullptr, &n);
+	}
+
+	template <class Node>
+	static void
+	remove(List<ListNode, Options, Tag> & l, Node & n)
+	{
+		l.remove(&n);
+	}
+};
+
+/// @endcond
+} // namespace pool_internal
+
+/**
+ * @brief A slab allocator for the nodes of intrusive containers
+ *
+ * Since all containers in this library are intrusive, you have to store your
+ * nodes yourself. Storing them in a std::vector is a common pitfall, since the
+ * vector moves its elements when it grows. The NodePool instead allocates
+ * nodes from slabs of fixed size, which are never moved or released until the
+ * pool is destroyed. Thus, nodes have stable addresses.
+ *
+ * Freed nodes are put into a free list and recycled in O(1). New slots are
+ * taken in address order from the most recent slab, so nodes that are created
+ * in sequence are also adjacent in memory.
+ *
+ * A NodePool is not thread safe. See thread_local_pool() for a pool per
+ * thread.
+ *
+ * @tparam Node   The node class to be allocated
+ */
+template <class Node>
+class NodePool {
+public:
+	/**
+	 * @brief Creates an empty pool
+	 *
+	 * No memory is allocated until the first node is constructed.
+	 *
+	 * @param slab_nodes   The number of nodes per slab. Defaults to as many
+	 * nodes as fit into 64 KiB (but at least 16).
+	 */
+	explicit NodePool(size_t slab_nodes = default_slab_nodes()) noexcept;
+
+	/**
+	 * @brief Destroys the pool
+	 *
+	 * Destroys all nodes that are still allocated from this pool and releases
+	 * all memory.
+	 *
+	 * @warning Remove all nodes from their containers before destroying the
+	 * pool!
+	 */
+	~NodePool();
+
+	NodePool(const NodePool &) = delete;
+	NodePool & operator=(const NodePool &) = delete;
+
+	/**
+	 * @brief Constructs a new node in the pool
+	 *
+	 * Constructs a new node from <args> and returns a pointer to it. The node
+	 * stays at this address until it is passed to destroy().
+	 *
+	 * @param args   Arguments passed on to the constructor of Node
+	 * @returns A pointer to the new node
+	 */
+	template <class... Args>
+	Node * construct(Args &&... args);
+
+	/**
+	 * @brief Destroys a node and recycles its memory
+	 *
+	 * Calls the destructor of <n> and puts its memory into the free list, from
+	 * which it will be reused by the next call to construct().
+	 *
+	 * @warning <n> must have been constructed by this pool and must not be part
+	 * of any container anymore.
+	 *
+	 * @param n   The node to be destroyed
+	 */
+	void destroy(Node * n) noexcept;
+
+	/**
+	 * @brief Constructs a node and inserts it into a container
+	 *
+	 * Constructs a new node from <args> and inserts it into <c>, which can be an
+	 * RBTree, ZTree, IntervalTree or any other container offering
+	 * insert(Node &). If <c> is a List, the node is appended at the end.
+	 *
+	 * @param c      The container to insert the new node into
+	 * @param args   Arguments passed on to the constructor of Node
+	 * @returns A pointer to the new node
+	 */
+	template <class Container, class... Args>
+	Node * emplace_insert(Container & c, Args &&... args);
+
+	/**
+	 * @brief Removes a node from a container and destroys it
+	 *
+	 * @param c   The container that <n> is removed from
+	 * @param n   The node to be removed and destroyed. Must have been
+	 * constructed by this pool.
+	 */
+	template <class Container>
+	void erase_and_free(Container & c, Node & n) noexcept;
+
+	/**
+	 * @brief Preallocates memory
+	 *
+	 * Makes sure that at least <n> nodes can be allocated in total without
+	 * allocating new slabs.
+	 *
+	 * @param n   The number of nodes that should fit into the pool
+	 */
+	void reserve(size_t n);
+
+	/**
+	 * Returns the number of nodes currently allocated from this pool.
+	 */
+	size_t size() const noexcept;
+
+	/**
+	 * Returns the number of nodes that fit into the slabs allocated so far.
+	 */
+	size_t capacity() const noexcept;
+
+	/**
+	 * @brief Returns a pool exclusive to the calling thread
+	 *
+	 * Returns a per-thread pool. Since the pages of a slab are first touched by
+	 * the thread that allocates nodes from it, an operating system with a
+	 * first-touch policy will place them on the NUMA node that this thread runs
+	 * on.
+	 *
+	 * @warning Nodes allocated from a thread's pool must be destroyed by the same
+	 * thread, and they become invalid once the thread exits.
+	 */
+	static NodePool & thread_local_pool();
+
+private:
+	union Slot {
+		Slot * next_free;
+		typename std::aligned_storage<sizeof(Node), alignof(Node)>::type storage;
+	};
+
+	static constexpr size_t default_slab_nodes() noexcept;
+
+	void add_slab();
+
+	std::vector<std::unique_ptr<Slot[]>> slabs;
+	size_t slab_nodes;
+
+	Slot * free_list;
+	// Slots in the last slab at or after this have never been used
+	size_t bump_index;
+
+	size_t allocated;
+};
+
+} // namespace ygg
+
+#include "node_pool.cpp"
+
+#endif // YGG_NODE_POOL_HPP
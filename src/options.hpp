@@ -42,10 +42,25 @@ public:
 	 * that question for every pair (a,b). For elements that compare equally (i.e.
 	 * Compare(a,b) == Compare(b,a) == false), the hinted version of
 	 * RBTree::insert allows you to enforce a certain order on equal elements.
-	 * TODO link to method
+	 * The queries are answered by RBTree::precedes() in O(1). This requires one
+	 * 64-bit label per node, and insertions take O(log n) amortized additional
+	 * time to keep the labels up to date.
 	 */
 	class ORDER_QUERIES {
 	};
+	/**
+	 * @brief RBTree / ZTree option: Support order statistics
+	 *
+	 * If this flag is set, every node stores the number of nodes in its subtree.
+	 * This allows to find the k-th element (see RBTree::select() and
+	 * ZTree::select()) and the position of an element (see RBTree::rank() and
+	 * ZTree::rank()) in O(log n). Also, iterators can be advanced by k steps and
+	 * the distance between two iterators can be computed in O(log n). This
+	 * requires one size_t per node and slows down insert and remove operations
+	 * slightly.
+	 */
+	class ORDER_STATISTICS {
+	};
 	/**
 	 * @brief RBTree / List option: support size() in O(1)
 	 *
@@ -56,6 +71,18 @@ public:
 	class CONSTANT_TIME_SIZE {
 	};
 
+	/**
+	 * @brief RBTree option: Read and write the links between nodes (and the root)
+	 * as relaxed atomics
+	 *
+	 * This is required by SeqLockRBTree, whose readers follow the links while a
+	 * writer changes them. On most platforms, relaxed atomic accesses compile to
+	 * plain loads and stores, but they keep the compiler from merging or
+	 * splitting them. Can not be combined with INDEX_LINKS.
+	 */
+	class ATOMIC_LINKS {
+	};
+
 	/**
 	 * @brief RBTree option: Indicates that color information should be compressed
 	 * into the parent pointer
@@ -67,6 +94,33 @@ public:
 	class COMPRESS_COLOR {
 	};
 
+	/**
+	 * @brief RBTree / ZTree option: Store the links between nodes as 32-bit
+	 * indices
+	 *
+	 * By default, every node stores pointers to its parent and children. If this
+	 * flag is set, these links are instead stored as 32-bit indices into a
+	 * contiguous array of nodes, and the color of red-black tree nodes is packed
+	 * into the parent index. On 64-bit systems, this halves the space needed for
+	 * the links, which improves cache efficiency for small nodes.
+	 *
+	 * All nodes that are ever inserted into the tree must be part of the same
+	 * array, and only the first 2^31 - 1 nodes of that array can be inserted.
+	 * The topmost bit of every index is used for the color. Linking a node that
+	 * lies outside this range is caught by an assertion in debug builds, and
+	 * corrupts the tree otherwise.
+	 *
+	 * @tparam Pool A class that provides the node array via a static method
+	 * Node * get_base(), which returns a pointer to the first node of the array.
+	 * The array must not move while any of its nodes are in a tree. Pool may be
+	 * an incomplete type at the point where the options are declared.
+	 */
+	template <class Pool>
+	class INDEX_LINKS {
+	public:
+		using pool = Pool;
+	};
+
 	/**
 	 * @brief Zip Tree Option: Indicates that nodes' ranks should be derived from
 	 * a std::hash hash of the node.
@@ -94,6 +148,23 @@ public:
 		using type = T;
 	};
 
+	/**
+	 * @brief Zip Tree Option: Draw random ranks from a fast per-tree generator
+	 *
+	 * By default, random ranks are drawn from std::rand() whenever a node is
+	 * constructed. std::rand() may take a global lock, which serializes threads
+	 * that create nodes concurrently. If this flag is set, the rank of a node is
+	 * instead drawn when the node is inserted into a ZTree, from a small
+	 * generator (wyrand) owned by that tree. A rank takes a single 64-bit draw.
+	 * The generators of different trees are seeded differently. Use
+	 * ZTree::seed_ranks() to get reproducible tree shapes.
+	 *
+	 * @warning This requires ZTREE_RANK_TYPE to be set and ZTREE_USE_HASH to be
+	 * unset.
+	 */
+	class ZTREE_FAST_RANDOM {
+	};
+
 	/**
 	 * @brief Zip Tree Option: Apply universal hashing to compute node ranks. This
 	 * sets the coefficient.
@@ -140,6 +211,76 @@ public:
 	public:
 		constexpr static size_t value = modul_in;
 	};
+
+	/**
+	 * @brief Caches a small key inside the nodes
+	 *
+	 * If comparing two nodes requires reading data outside of the node (e.g., a
+	 * string key stored somewhere else), every comparison during a lookup is an
+	 * additional cache miss. With this option, RBTree and ZTree store a small
+	 * key (e.g., a fixed-size prefix of the string) inside the node base class,
+	 * right next to the links, and compare these first. The tree's Compare is
+	 * only asked if the cached keys are equal.
+	 *
+	 * The Extractor must provide a static method get_cached_key(const Node &)
+	 * returning a T. T must be comparable via operator<(), and the cached keys
+	 * must be consistent with Compare: If the cached key of a is smaller than
+	 * the cached key of b, then a must go before b. If the Extractor also
+	 * provides get_cached_key() for a query type, lookups with that type
+	 * compare cached keys as well. Otherwise, they use the full Compare.
+	 *
+	 * The cached key is computed when a node is inserted.
+	 *
+	 * @warning Changing the key of a node while it is in a tree is undefined
+	 * behavior anyways, but with this option, it is not even noticed.
+	 *
+	 * @tparam Extractor  The class computing the cached keys
+	 * @tparam T          The type of the cached keys
+	 */
+	template <class Extractor, class T>
+	class CACHED_KEY {
+	public:
+		using extractor = Extractor;
+		using type = T;
+	};
+
+	/**
+	 * @brief B-Tree Option: Sets the size of the B-Tree's pages in bytes
+	 *
+	 * The capacities of the inner pages and the leaves of a BTree are chosen such
+	 * that each page takes (about) this many bytes. Multiples of the cache line
+	 * size between 256 and 512 usually work best. Defaults to 256.
+	 *
+	 * @tparam bytes_in The desired page size in bytes
+	 */
+	template <size_t bytes_in>
+	class BTREE_PAGE_SIZE {
+	public:
+		constexpr static size_t value = bytes_in;
+	};
+
+	/**
+	 * @brief IntervalTree option: Keep the smallest lower bound of every subtree
+	 *
+	 * If this flag is set, every node of an IntervalTree stores the smallest
+	 * lower interval bound in its subtree, in addition to the largest upper
+	 * bound. Queries then skip subtrees that only contain intervals starting
+	 * after the query ends, instead of descending into them. This requires one
+	 * additional key per node.
+	 */
+	class ITREE_MIN_LOWER {
+	};
+
+	/**
+	 * @brief IntervalTree option: Keep the smallest upper bound of every subtree
+	 *
+	 * If this flag is set, every node of an IntervalTree stores the smallest
+	 * upper interval bound in its subtree. Together with the subtree sizes of
+	 * ORDER_STATISTICS, this allows IntervalTree::count_overlaps() to count
+	 * whole subtrees at once. This requires one additional key per node.
+	 */
+	class ITREE_COUNT_OVERLAPS {
+	};
 };
 
 /**
@@ -168,6 +309,7 @@ private:
 	static constexpr size_t ztree_universalize_modul_default =
 	    std::numeric_limits<size_t>::max();
 	static constexpr size_t ztree_universalize_coefficient_default = 1103515245;
+	static constexpr size_t btree_page_size_default = 256;
 
 public:
 	/// @cond INTERNAL
@@ -175,13 +317,36 @@ public:
 	    rbtree_internal::pack_contains<TreeFlags::MULTIPLE, Opts...>();
 	static constexpr bool order_queries =
 	    rbtree_internal::pack_contains<TreeFlags::ORDER_QUERIES, Opts...>();
+	static constexpr bool order_statistics =
+	    rbtree_internal::pack_contains<TreeFlags::ORDER_STATISTICS, Opts...>();
 	static constexpr bool constant_time_size =
 	    rbtree_internal::pack_contains<TreeFlags::CONSTANT_TIME_SIZE, Opts...>();
 	static constexpr bool compress_color =
 	    rbtree_internal::pack_contains<TreeFlags::COMPRESS_COLOR, Opts...>();
+	static constexpr bool itree_min_lower =
+	    rbtree_internal::pack_contains<TreeFlags::ITREE_MIN_LOWER, Opts...>();
+	static constexpr bool itree_count_overlaps =
+	    rbtree_internal::pack_contains<TreeFlags::ITREE_COUNT_OVERLAPS,
+	                                   Opts...>();
+	static constexpr bool atomic_links =
+	    rbtree_internal::pack_contains<TreeFlags::ATOMIC_LINKS, Opts...>();
+
+	using index_links =
+	    typename utilities::get_type_if_present<TreeFlags::INDEX_LINKS, bool,
+	                                            Opts...>::type;
+	static constexpr bool use_index_links =
+	    !std::is_same<index_links, bool>::value;
+
+	using cached_key =
+	    typename utilities::get_type_if_present<TreeFlags::CACHED_KEY, bool,
+	                                            Opts...>::type;
+	static constexpr bool use_cached_key =
+	    !std::is_same<cached_key, bool>::value;
 
 	static constexpr bool ztree_use_hash =
 	    rbtree_internal::pack_contains<TreeFlags::ZTREE_USE_HASH, Opts...>();
+	static constexpr bool ztree_fast_random =
+	    rbtree_internal::pack_contains<TreeFlags::ZTREE_FAST_RANDOM, Opts...>();
 
 	using ztree_rank_type =
 	    typename utilities::get_type_if_present<TreeFlags::ZTREE_RANK_TYPE, bool,
@@ -206,6 +371,10 @@ public:
 	        TreeFlags::ZTREE_RANK_HASH_UNIVERSALIZE_COEFFICIENT,
 	        ztree_universalize_coefficient_default, Opts...>::value;
 
+	static constexpr size_t btree_page_size =
+	    utilities::get_value_if_present_else_default<
+	        TreeFlags::BTREE_PAGE_SIZE, btree_page_size_default, Opts...>::value;
+
 	/// @endcond
 private:
 	TreeOptions(); // Instantiation not allowed
@@ -111,9 +111,68 @@ ColorParentStorage<Node, false>::swap_parent_with(
 	std::swap(this->parent, other.parent);
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, bool compress_color, class Pool>
+void
+ColorParentStorage<Node, compress_color,
+                   TreeFlags::INDEX_LINKS<Pool>>::set_color(Color new_color)
+{
+	this->parent.set_flag(new_color == Color::RED);
+}
+
+template <class Node, bool compress_color, class Pool>
+ygg::rbtree_internal::Color
+ColorParentStorage<Node, compress_color, TreeFlags::INDEX_LINKS<Pool>>::get_color()
+    const
+{
+	if (this->parent.get_flag()) {
+		return Color::RED;
+	} else {
+		return Color::BLACK;
+	}
+}
+
+template <class Node, bool compress_color, class Pool>
+void
+ColorParentStorage<Node, compress_color,
+                   TreeFlags::INDEX_LINKS<Pool>>::set_parent(Node * new_parent)
+{
+	// Assigning a node keeps the flag, i.e., the color
+	this->parent = new_parent;
+}
+
+template <class Node, bool compress_color, class Pool>
+Node *
+ColorParentStorage<Node, compress_color,
+                   TreeFlags::INDEX_LINKS<Pool>>::get_parent() const
+{
+	return this->parent;
+}
+
+template <class Node, bool compress_color, class Pool>
+void
+ColorParentStorage<Node, compress_color, TreeFlags::INDEX_LINKS<Pool>>::
+    swap_color_with(ColorParentStorage & other)
+{
+	bool tmp = other.parent.get_flag();
+	other.parent.set_flag(this->parent.get_flag());
+	this->parent.set_flag(tmp);
+}
+
+template <class Node, bool compress_color, class Pool>
+void
+ColorParentStorage<Node, compress_color, TreeFlags::INDEX_LINKS<Pool>>::
+    swap_parent_with(ColorParentStorage & other)
+{
+	Node * tmp = other.get_parent();
+	other.set_parent(this->get_parent());
+	this->set_parent(tmp);
+}
+
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 size_t
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_depth() const noexcept
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::get_depth() const noexcept
 {
 	size_t depth = 0;
 	const Node * n = (const Node *)this;
@@ -126,62 +185,271 @@ RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_depth() const noexcept
 	return depth;
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 void
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::set_color(Color new_color)
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::set_color(Color new_color)
 {
 	this->_color_and_parent.set_color(new_color);
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 Color
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_color() const
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::get_color() const
 {
 	return this->_color_and_parent.get_color();
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 Node *
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_parent() const
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::get_parent() const
 {
 	return this->_color_and_parent.get_parent();
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 Node *
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_left() const
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::get_left() const
 {
 	return this->_rbt_left;
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 Node *
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::get_right() const
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::get_right() const
 {
 	return this->_rbt_right;
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 void
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::set_parent(Node * new_parent)
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::set_parent(Node * new_parent)
 {
 	this->_color_and_parent.set_parent(new_parent);
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 void
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::swap_color_with(Node * other)
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::swap_color_with(Node * other)
 {
 	this->_color_and_parent.swap_color_with(other->_color_and_parent);
 }
 
-template <class Node, class Tag, bool compress_color>
+template <class Node, class Tag, bool compress_color, class Links,
+          bool atomic_links>
 void
-RBTreeNodeBaseImpl<Node, Tag, compress_color>::swap_parent_with(Node * other)
+RBTreeNodeBaseImpl<Node, Tag, compress_color, Links,
+                   atomic_links>::swap_parent_with(Node * other)
 {
 	this->_color_and_parent.swap_parent_with(other->_color_and_parent);
 }
 
+template <class Node, class NB>
+Node *
+OrderTags<Node, NB, true>::prev(Node * n) noexcept
+{
+	if (n->NB::_rbt_left != nullptr) {
+		n = n->NB::_rbt_left;
+		while (n->NB::_rbt_right != nullptr) {
+			n = n->NB::_rbt_right;
+		}
+		return n;
+	}
+
+	while ((n->NB::get_parent() != nullptr) &&
+	       (n->NB::get_parent()->NB::_rbt_left == n)) {
+		n = n->NB::get_parent();
+	}
+	return n->NB::get_parent();
+}
+
+template <class Node, class NB>
+Node *
+OrderTags<Node, NB, true>::next(Node * n) noexcept
+{
+	if (n->NB::_rbt_right != nullptr) {
+		n = n->NB::_rbt_right;
+		while (n->NB::_rbt_left != nullptr) {
+			n = n->NB::_rbt_left;
+		}
+		return n;
+	}
+
+	while ((n->NB::get_parent() != nullptr) &&
+	       (n->NB::get_parent()->NB::_rbt_right == n)) {
+		n = n->NB::get_parent();
+	}
+	return n->NB::get_parent();
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::spread(Node * first, size_t count, uint64_t lo,
+                                  uint64_t width) noexcept
+{
+	uint64_t spacing = width / count;
+	uint64_t tag = lo + spacing / 2;
+
+	Node * cur = first;
+	for (size_t i = 0; i < count; ++i) {
+		cur->NB::_rbt_order_tag = tag;
+		tag += spacing;
+		cur = next(cur);
+	}
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::inserted(Node * n) noexcept
+{
+	inserted_run(n, n, 1);
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::inserted_run(Node * first, Node * last,
+                                        size_t count) noexcept
+{
+	Node * before = prev(first);
+	Node * after = next(last);
+
+	uint64_t lower = 0;
+	if (before != nullptr) {
+		lower = before->NB::_rbt_order_tag + 1;
+	}
+	uint64_t upper = UNIVERSE;
+	if (after != nullptr) {
+		upper = after->NB::_rbt_order_tag;
+	}
+
+	if ((lower < upper) && (upper - lower >= count)) {
+		spread(first, count, lower, upper - lower);
+	} else {
+		relabel_around(first, last, count,
+		               (before != nullptr) ? before->NB::_rbt_order_tag
+		                                   : after->NB::_rbt_order_tag);
+	}
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::label_unlabeled(Node * n) noexcept
+{
+	if (n->NB::_rbt_order_tag != UNLABELED) {
+		return;
+	}
+
+	Node * last = n;
+	size_t count = 1;
+	for (Node * cur = next(n);
+	     (cur != nullptr) && (cur->NB::_rbt_order_tag == UNLABELED);
+	     cur = next(cur)) {
+		last = cur;
+		count++;
+	}
+
+	inserted_run(n, last, count);
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::relabel_around(Node * first, Node * last,
+                                          size_t count, uint64_t anchor) noexcept
+{
+	// The <count> nodes in [first, last] must be relabeled. Their labels are
+	// meaningless, but they lie at <anchor> with respect to their neighbors.
+	double max_count = 1;
+	for (unsigned int i = 1; i <= UNIVERSE_BITS; ++i) {
+		uint64_t width = static_cast<uint64_t>(1) << i;
+		uint64_t lo = anchor & ~(width - 1);
+		uint64_t hi = lo + width;
+
+		// Extend [first, last] to all nodes with labels in [lo, hi)
+		Node * candidate = prev(first);
+		while ((candidate != nullptr) && (candidate->NB::_rbt_order_tag >= lo)) {
+			first = candidate;
+			count++;
+			candidate = prev(first);
+		}
+		candidate = next(last);
+		while ((candidate != nullptr) && (candidate->NB::_rbt_order_tag < hi)) {
+			last = candidate;
+			count++;
+			candidate = next(last);
+		}
+
+		max_count *= DENSITY_BASE;
+		if ((static_cast<double>(count) < max_count) || (i == UNIVERSE_BITS)) {
+			spread(first, count, lo, width);
+			return;
+		}
+	}
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::appended(Node * last, Node * first_after) noexcept
+{
+	if (last->NB::_rbt_order_tag < first_after->NB::_rbt_order_tag) {
+		return;
+	}
+
+	// Label the appended nodes as if they had been inserted after <last>. If
+	// they do not fit above <last>, they are relabeled together with a not too
+	// dense range that ends at <last>.
+	size_t count = 1;
+	Node * tail = first_after;
+	for (Node * cur = next(tail); cur != nullptr; cur = next(cur)) {
+		tail = cur;
+		count++;
+	}
+
+	inserted_run(first_after, tail, count);
+}
+
+template <class Node, class NB>
+void
+OrderTags<Node, NB, true>::rebuilt(Node * n) noexcept
+{
+	while (n->NB::get_parent() != nullptr) {
+		n = n->NB::get_parent();
+	}
+	while (n->NB::_rbt_left != nullptr) {
+		n = n->NB::_rbt_left;
+	}
+
+	size_t count = 0;
+	for (Node * cur = n; cur != nullptr; cur = next(cur)) {
+		count++;
+	}
+
+	spread(n, count, 0, UNIVERSE);
+}
+
+template <class Node, class NB>
+bool
+OrderTags<Node, NB, true>::verify(const Node * prev_node,
+                                  const Node * n) noexcept
+{
+	if (n->NB::_rbt_order_tag >= UNIVERSE) {
+		return false;
+	}
+	return (prev_node == nullptr) || precedes(prev_node, n);
+}
+
 } // namespace rbtree_internal
 
 template <class Node, class NodeTraits, class Options, class Tag, class Compare>
@@ -233,6 +501,7 @@ void
 RBTree<Node, NodeTraits, Options, Tag, Compare>::insert_leaf_base(Node & node,
                                                                   Node * start)
 {
+	CachedKeys::fill(node);
 	node.NB::_rbt_right = nullptr;
 	node.NB::_rbt_left = nullptr;
 
@@ -263,6 +532,8 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::insert_leaf_base(Node & node,
 		node.NB::set_parent(nullptr);
 		node.NB::set_color(rbtree_internal::Color::BLACK);
 		this->root = &node;
+		SubtreeSizes::fix(&node);
+		OrderTags::inserted(&node);
 		NodeTraits::leaf_inserted(node, *this);
 	} else {
 		node.NB::set_parent(parent);
@@ -288,6 +559,10 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::insert_leaf_base(Node & node,
 			}
 		}
 
+		SubtreeSizes::fix(&node);
+		SubtreeSizes::add_on_path(parent);
+		OrderTags::inserted(&node);
+
 		NodeTraits::leaf_inserted(node, *this);
 		this->fixup_after_insert(&node);
 	}
@@ -322,6 +597,9 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::rotate_left(Node * parent)
 
 	parent->NB::set_parent(right_child);
 
+	SubtreeSizes::fix(parent);
+	SubtreeSizes::fix(right_child);
+
 	NodeTraits::rotated_left(*parent, *this);
 }
 
@@ -352,11 +630,17 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::rotate_right(Node * parent)
 
 	parent->NB::set_parent(left_child);
 
+	SubtreeSizes::fix(parent);
+	SubtreeSizes::fix(left_child);
+
 	NodeTraits::rotated_right(*parent, *this);
 }
 
+/*
+ * Returns true if the black height of the tree has increased.
+ */
 template <class Node, class NodeTraits, class Options, class Tag, class Compare>
-void
+bool
 RBTree<Node, NodeTraits, Options, Tag, Compare>::fixup_after_insert(Node * node)
 {
 	// Does not happen: We only call this if we are not the root.
@@ -384,13 +668,13 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::fixup_after_insert(Node * node)
 		} else {
 			// Don't recurse into the root; don't color it red. We could immediately
 			// re-color it black.
-			return;
+			return true;
 		}
 	}
 
 	if (node->NB::get_parent()->NB::get_color() ==
 	    rbtree_internal::Color::BLACK) {
-		return;
+		return false;
 	}
 
 	Node * parent = node->NB::get_parent();
@@ -420,6 +704,8 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::fixup_after_insert(Node * node)
 	}
 
 	grandparent->NB::set_color(rbtree_internal::Color::RED);
+
+	return false;
 }
 
 template <class Node, class NodeTraits, class Options, class Tag, class Compare>
@@ -453,6 +739,8 @@ void
 RBTree<Node, NodeTraits, Options, Tag, Compare>::insert(Node & node,
                                                         Node & hint)
 {
+	CachedKeys::fill(node);
+
 	// find parent
 	Node * parent = &hint;
 
@@ -503,6 +791,706 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::insert(
 	}
 }
 
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class InputIt>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::build_from_sorted(
+    InputIt begin, InputIt end)
+{
+	size_t count = (size_t)std::distance(begin, end);
+
+	this->root = nullptr;
+	this->s.set(count);
+
+	if (count == 0) {
+		return;
+	}
+
+	// Splitting evenly yields a tree in which all levels but the deepest one are
+	// full. Coloring exactly the deepest level red makes all black-paths equally
+	// long.
+	size_t red_depth = 0;
+	while ((count >> (red_depth + 1)) != 0) {
+		red_depth++;
+	}
+
+	this->root = this->build_subtree(begin, count, 0, red_depth);
+	this->root->NB::set_parent(nullptr);
+	this->root->NB::set_color(rbtree_internal::Color::BLACK);
+
+	OrderTags::rebuilt(this->root);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class InputIt>
+Node *
+RBTree<Node, NodeTraits, Options, Tag, Compare>::build_subtree(
+    InputIt & it, size_t count, size_t depth, size_t red_depth)
+{
+	if (count == 0) {
+		return nullptr;
+	}
+
+	size_t left_count = (count - 1) / 2;
+	Node * left = this->build_subtree(it, left_count, depth + 1, red_depth);
+
+	Node & node = utilities::deref_node<Node>(*it);
+	CachedKeys::fill(node);
+	++it;
+
+	Node * right =
+	    this->build_subtree(it, count - left_count - 1, depth + 1, red_depth);
+
+	node.NB::_rbt_left = left;
+	node.NB::_rbt_right = right;
+	if (left != nullptr) {
+		left->NB::set_parent(&node);
+	}
+	if (right != nullptr) {
+		right->NB::set_parent(&node);
+	}
+
+	if (depth == red_depth) {
+		node.NB::set_color(rbtree_internal::Color::RED);
+	} else {
+		node.NB::set_color(rbtree_internal::Color::BLACK);
+	}
+
+	SubtreeSizes::fix(&node);
+	NodeTraits::rebuilt(node, *this);
+
+	return &node;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class InputIt>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::insert_batch(InputIt begin,
+                                                              InputIt end)
+{
+	size_t count = (size_t)std::distance(begin, end);
+
+	// TODO constexpr - if
+	if (Options::use_cached_key) {
+		// The batch is compared to the tree before its nodes are inserted
+		for (InputIt it = begin; it != end; ++it) {
+			CachedKeys::fill(utilities::deref_node<Node>(*it));
+		}
+	}
+
+	// Below this, inserting from the finger is cheaper than splitting and
+	// joining the tree at the batch's nodes.
+	if (count >= this->get_size_lower_bound(
+	                 std::integral_constant<bool, Options::constant_time_size>{}) /
+	                 4) {
+		size_t merged_height;
+		size_t inserted = 0;
+		this->root = this->merge_subtree(this->root, this->get_black_height(),
+		                                 begin, count, merged_height, inserted);
+		this->s.add(inserted);
+
+		// TODO constexpr - if
+		if (Options::order_queries) {
+			for (InputIt it = begin; it != end; ++it) {
+				OrderTags::label_unlabeled(&utilities::deref_node<Node>(*it));
+			}
+		}
+		return;
+	}
+
+	Node * finger = nullptr;
+	for (InputIt it = begin; it != end; ++it) {
+		Node & node = utilities::deref_node<Node>(*it);
+		if (this->insert_after_finger(node, finger)) {
+			this->s.add(1);
+			finger = &node;
+		}
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+RBTree<Node, NodeTraits, Options, Tag, Compare>::insert_after_finger(
+    Node & node, Node * finger)
+{
+	Node * cur;
+
+	if (finger == nullptr) {
+		cur = this->root;
+	} else {
+		/* The finger goes before (or equally to) the node. We need to walk up until
+		 * we find a subtree that is bounded from above by an ancestor that goes
+		 * after the node. Since we insert right-leaning, the position of the node
+		 * must be within that subtree.
+		 */
+		cur = finger;
+		while (cur->NB::get_parent() != nullptr) {
+			Node * parent = cur->NB::get_parent();
+			if ((parent->NB::_rbt_left == cur) && this->cmp(node, *parent)) {
+				break;
+			}
+			cur = parent;
+		}
+	}
+
+	// Find the leaf position, remembering the largest node not going after
+	// the new node to be able to detect equal nodes.
+	Node * parent = cur;
+	Node * not_after = nullptr;
+	while (cur != nullptr) {
+		parent = cur;
+		if (this->cmp(node, *cur)) {
+			cur = cur->NB::_rbt_left;
+		} else {
+			not_after = cur;
+			cur = cur->NB::_rbt_right;
+		}
+	}
+
+	// TODO constexpr - if
+	if (!Options::multiple && (not_after != nullptr) &&
+	    !this->cmp(*not_after, node)) {
+		return false;
+	}
+
+	this->insert_leaf_base<false>(node, parent);
+	return true;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+size_t
+RBTree<Node, NodeTraits, Options, Tag, Compare>::get_size_lower_bound(
+    std::true_type) const
+{
+	return this->s.get();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+size_t
+RBTree<Node, NodeTraits, Options, Tag, Compare>::get_size_lower_bound(
+    std::false_type) const
+{
+	// A tree with black height h contains at least 2^h - 1 nodes
+	size_t height = this->get_black_height();
+	if (height >= static_cast<size_t>(std::numeric_limits<size_t>::digits)) {
+		return std::numeric_limits<size_t>::max();
+	}
+	return (static_cast<size_t>(1) << height) - 1;
+}
+
+/*
+ * Merges the <count> sorted nodes starting at <begin> into the tree rooted at
+ * <sub_root> (with black height <height>) and returns the new root. Batch
+ * nodes go after equal nodes of the tree. Uses this->root as scratch space.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class InputIt>
+Node *
+RBTree<Node, NodeTraits, Options, Tag, Compare>::merge_subtree(
+    Node * sub_root, size_t height, InputIt begin, size_t count,
+    size_t & merged_height, size_t & inserted)
+{
+	if (count == 0) {
+		merged_height = height;
+		return sub_root;
+	}
+
+	// TODO constexpr - if
+	if ((sub_root == nullptr) && Options::multiple) {
+		// Nothing left to merge with, the rest of the batch forms a tree of its
+		// own.
+		InputIt it = begin;
+		for (size_t i = 0; i < count; ++i, ++it) {
+			OrderTags::unlabel(&utilities::deref_node<Node>(*it));
+		}
+		inserted += count;
+
+		size_t red_depth = 0;
+		while ((count >> (red_depth + 1)) != 0) {
+			red_depth++;
+		}
+		it = begin;
+		merged_height = red_depth;
+		return this->detach_subtree(this->build_subtree(it, count, 0, red_depth),
+		                            merged_height);
+	}
+
+	size_t left_count = count / 2;
+	InputIt pivot_it = std::next(begin, static_cast<ptrdiff_t>(left_count));
+	Node & pivot = utilities::deref_node<Node>(*pivot_it);
+	InputIt right_begin = std::next(pivot_it);
+	size_t right_count = count - left_count - 1;
+
+	// TODO constexpr - if
+	if (!Options::multiple) {
+		// Batch nodes equal to the pivot would duplicate it
+		while ((right_count > 0) &&
+		       !this->cmp(pivot, utilities::deref_node<Node>(*right_begin))) {
+			++right_begin;
+			right_count--;
+		}
+	}
+
+	Node * left;
+	size_t left_height;
+	Node * right;
+	size_t right_height;
+	this->split_subtree<true>(sub_root, height, pivot, left, left_height, right,
+	                          right_height);
+
+	left = this->merge_subtree(left, left_height, begin, left_count, left_height,
+	                           inserted);
+	right = this->merge_subtree(right, right_height, right_begin, right_count,
+	                            right_height, inserted);
+
+	// TODO constexpr - if
+	if (!Options::multiple && (left != nullptr)) {
+		Node * largest = left;
+		while (largest->NB::_rbt_right != nullptr) {
+			largest = largest->NB::_rbt_right;
+		}
+		if (!this->cmp(*largest, pivot)) {
+			// An equal node is already in the tree
+			return this->join_subtrees(left, left_height, right, right_height,
+			                           merged_height);
+		}
+	}
+
+	OrderTags::unlabel(&pivot);
+	inserted++;
+	return this->join_with_pivot(left, left_height, pivot, right, right_height,
+	                             merged_height);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+size_t
+RBTree<Node, NodeTraits, Options, Tag, Compare>::get_black_height() const
+{
+	size_t height = 0;
+	Node * cur = this->root;
+	while (cur != nullptr) {
+		if (cur->NB::get_color() == rbtree_internal::Color::BLACK) {
+			height++;
+		}
+		cur = cur->NB::_rbt_left;
+	}
+
+	return height;
+}
+
+/*
+ * Joins the trees rooted at <left> and <right> (with the respective black
+ * heights) with <pivot> in between. All nodes in <left> must go before <pivot>,
+ * all nodes in <right> after it. Returns the new root. Uses this->root as
+ * scratch space.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+Node *
+RBTree<Node, NodeTraits, Options, Tag, Compare>::join_with_pivot(
+    Node * left, size_t left_height, Node & pivot, Node * right,
+    size_t right_height, size_t & joined_height)
+{
+	Node * parent = nullptr;
+	Node * cur;
+
+	if (left_height >= right_height) {
+		// Walk down the right spine of the left tree until we find a black node
+		// (or leaf) of the same black height as the right tree.
+		this->root = left;
+		cur = left;
+		size_t height = left_height;
+		while ((cur != nullptr) &&
+		       ((height != right_height) ||
+		        (cur->NB::get_color() == rbtree_internal::Color::RED))) {
+			if (cur->NB::get_color() == rbtree_internal::Color::BLACK) {
+				height--;
+			}
+			parent = cur;
+			cur = cur->NB::_rbt_right;
+		}
+
+		pivot.NB::_rbt_left = cur;
+		pivot.NB::_rbt_right = right;
+		if (parent != nullptr) {
+			parent->NB::_rbt_right = &pivot;
+		}
+		joined_height = left_height;
+	} else {
+		// Symmetric: Walk down the left spine of the right tree
+		this->root = right;
+		cur = right;
+		size_t height = right_height;
+		while ((cur != nullptr) &&
+		       ((height != left_height) ||
+		        (cur->NB::get_color() == rbtree_internal::Color::RED))) {
+			if (cur->NB::get_color() == rbtree_internal::Color::BLACK) {
+				height--;
+			}
+			parent = cur;
+			cur = cur->NB::_rbt_left;
+		}
+
+		pivot.NB::_rbt_left = left;
+		pivot.NB::_rbt_right = cur;
+		if (parent != nullptr) {
+			parent->NB::_rbt_left = &pivot;
+		}
+		joined_height = right_height;
+	}
+
+	pivot.NB::set_parent(parent);
+	if (pivot.NB::_rbt_left != nullptr) {
+		pivot.NB::_rbt_left->NB::set_parent(&pivot);
+	}
+	if (pivot.NB::_rbt_right != nullptr) {
+		pivot.NB::_rbt_right->NB::set_parent(&pivot);
+	}
+
+	// Update augmentation bottom-up, before rotations happen
+	Node * update = &pivot;
+	while (update != nullptr) {
+		SubtreeSizes::fix(update);
+		NodeTraits::rebuilt(*update, *this);
+		update = update->NB::get_parent();
+	}
+
+	if (parent == nullptr) {
+		// Both trees had the same height
+		pivot.NB::set_color(rbtree_internal::Color::BLACK);
+		this->root = &pivot;
+		joined_height++;
+	} else {
+		pivot.NB::set_color(rbtree_internal::Color::RED);
+		if (this->fixup_after_insert(&pivot)) {
+			joined_height++;
+		}
+	}
+
+	return this->root;
+}
+
+/*
+ * Joins the trees rooted at <left> and <right> without a pivot. The smallest
+ * node of <right> is split off to become the pivot.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+Node *
+RBTree<Node, NodeTraits, Options, Tag, Compare>::join_subtrees(
+    Node * left, size_t left_height, Node * right, size_t right_height,
+    size_t & joined_height)
+{
+	if (right == nullptr) {
+		joined_height = left_height;
+		return left;
+	}
+
+	Node * smallest = right;
+	while (smallest->NB::_rbt_left != nullptr) {
+		smallest = smallest->NB::_rbt_left;
+	}
+
+	Node * single;
+	size_t single_height;
+	Node * rest;
+	size_t rest_height;
+	this->split_subtree<true>(right, right_height, *smallest, single,
+	                          single_height, rest, rest_height);
+
+	return this->join_with_pivot(left, left_height, *smallest, rest,
+	                             rest_height, joined_height);
+}
+
+/*
+ * Turns the subtree rooted at <sub_root> into a valid tree of its own.
+ * <height> must be the black height of <sub_root> and is updated.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+Node *
+RBTree<Node, NodeTraits, Options, Tag, Compare>::detach_subtree(
+    Node * sub_root, size_t & height)
+{
+	if (sub_root != nullptr) {
+		sub_root->NB::set_parent(nullptr);
+		if (sub_root->NB::get_color() == rbtree_internal::Color::RED) {
+			sub_root->NB::set_color(rbtree_internal::Color::BLACK);
+			height++;
+		}
+	}
+
+	return sub_root;
+}
+
+/*
+ * Splits the tree rooted at <sub_root> into the nodes going before <key> and
+ * the rest. If <equal_goes_left> is set, the nodes comparing equally to <key>
+ * go to the left, too.
+ */
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <bool equal_goes_left, class Comparable>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::split_subtree(
+    Node * sub_root, size_t height, const Comparable & key, Node *& left,
+    size_t & left_height, Node *& right, size_t & right_height)
+{
+	if (sub_root == nullptr) {
+		left = nullptr;
+		left_height = 0;
+		right = nullptr;
+		right_height = 0;
+		return;
+	}
+
+	size_t child_height = height;
+	if (sub_root->NB::get_color() == rbtree_internal::Color::BLACK) {
+		child_height--;
+	}
+
+	size_t left_child_height = child_height;
+	Node * left_child =
+	    this->detach_subtree(sub_root->NB::_rbt_left, left_child_height);
+	size_t right_child_height = child_height;
+	Node * right_child =
+	    this->detach_subtree(sub_root->NB::_rbt_right, right_child_height);
+
+	Node * part;
+	size_t part_height;
+	// TODO constexpr - if
+	bool goes_left =
+	    equal_goes_left ? !this->cmp(key, *sub_root) : this->cmp(*sub_root, key);
+	if (goes_left) {
+		// sub_root and its left subtree go to the left
+		this->split_subtree<equal_goes_left>(right_child, right_child_height, key,
+		                                     part, part_height, right,
+		                                     right_height);
+		left = this->join_with_pivot(left_child, left_child_height, *sub_root,
+		                             part, part_height, left_height);
+	} else {
+		// sub_root and its right subtree go to the right
+		this->split_subtree<equal_goes_left>(left_child, left_child_height, key,
+		                                     left, left_height, part,
+		                                     part_height);
+		right = this->join_with_pivot(part, part_height, *sub_root, right_child,
+		                              right_child_height, right_height);
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::split(const Comparable & key,
+                                                       MyClass & right)
+{
+	this->split_uncounted(key, right);
+
+	this->count_after_split(
+	    right, std::integral_constant<bool, Options::constant_time_size>{});
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::split_uncounted(
+    const Comparable & key, MyClass & right)
+{
+	Node * left_root;
+	size_t left_height;
+	Node * right_root;
+	size_t right_height;
+
+	this->split_subtree<false>(this->root, this->get_black_height(),
+	                           CachedKeys::query(key), left_root, left_height,
+	                           right_root, right_height);
+
+	this->root = left_root;
+	right.root = right_root;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable1, class Comparable2>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::detach_range(
+    const Comparable1 & lower, const Comparable2 & upper, MyClass & range)
+{
+	// Counting after the splits would take time linear in the size of the
+	// smaller part. The caller fixes the size instead.
+	MyClass right;
+	this->split_uncounted(lower, range);
+	range.split_uncounted(upper, right);
+	this->join(right);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable1, class Comparable2>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::erase_range(
+    const Comparable1 & lower, const Comparable2 & upper)
+{
+	auto size_before = this->s;
+	MyClass range;
+	this->detach_range(lower, upper, range);
+
+	size_t count = 0;
+	for (auto it = range.begin(); it != range.end(); ++it) {
+		count++;
+	}
+	this->s = size_before;
+	this->s.reduce(count);
+	range.clear();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable1, class Comparable2, class OutList>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::extract_range(
+    const Comparable1 & lower, const Comparable2 & upper, OutList & out)
+{
+	auto size_before = this->s;
+	MyClass range;
+	this->detach_range(lower, upper, range);
+
+	size_t count = 0;
+	for (auto it = range.begin(); it != range.end(); ++it) {
+		out.insert(nullptr, &*it);
+		count++;
+	}
+	this->s = size_before;
+	this->s.reduce(count);
+	range.clear();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::count_after_split(
+    MyClass & right, std::true_type)
+{
+	// TODO constexpr - if
+	if (Options::order_statistics) {
+		this->s.set(SubtreeSizes::get(this->root));
+		right.s.set(SubtreeSizes::get(right.root));
+		return;
+	}
+
+	// Count the smaller tree only
+	size_t total = this->s.get();
+	size_t count = 0;
+	auto left_it = this->begin();
+	auto right_it = right.begin();
+	while ((left_it != this->end()) && (right_it != right.end())) {
+		++left_it;
+		++right_it;
+		count++;
+	}
+
+	if (left_it == this->end()) {
+		this->s.set(count);
+		right.s.set(total - count);
+	} else {
+		right.s.set(count);
+		this->s.set(total - count);
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::count_after_split(
+    MyClass & right, std::false_type)
+{
+	(void)right;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::join(MyClass & other)
+{
+	if (other.root == nullptr) {
+		return;
+	}
+
+	if (this->root == nullptr) {
+		this->root = other.root;
+		this->s = other.s;
+		other.clear();
+		return;
+	}
+
+	// The smallest node of the other tree becomes the pivot
+	Node * pivot = other.get_smallest();
+	other.remove(*pivot);
+	Node * last = this->get_largest();
+
+	size_t joined_height;
+	this->join_with_pivot(this->root, this->get_black_height(), *pivot,
+	                      other.root, other.get_black_height(), joined_height);
+	OrderTags::appended(last, pivot);
+
+	this->s.add(other.s);
+	this->s.add(1);
+	other.clear();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+bool
+RBTree<Node, NodeTraits, Options, Tag, Compare>::precedes(const Node & a,
+                                                          const Node & b) const
+{
+	static_assert(Options::order_queries,
+	              "precedes() requires ORDER_QUERIES to be set.");
+
+	return OrderTags::precedes(&a, &b);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+typename RBTree<Node, NodeTraits, Options, Tag, Compare>::template iterator<
+    false>
+RBTree<Node, NodeTraits, Options, Tag, Compare>::select(size_t k)
+{
+	static_assert(Options::order_statistics,
+	              "select() requires ORDER_STATISTICS to be set.");
+
+	Node * cur = this->root;
+	while (cur != nullptr) {
+		size_t left_size = SubtreeSizes::get(cur->NB::_rbt_left);
+		if (k < left_size) {
+			cur = cur->NB::_rbt_left;
+		} else if (k == left_size) {
+			break;
+		} else {
+			k -= left_size + 1;
+			cur = cur->NB::_rbt_right;
+		}
+	}
+
+	return iterator<false>(cur);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+typename RBTree<Node, NodeTraits, Options, Tag, Compare>::template const_iterator<
+    false>
+RBTree<Node, NodeTraits, Options, Tag, Compare>::select(size_t k) const
+{
+	return const_iterator<false>(const_cast<MyClass *>(this)->select(k));
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+size_t
+RBTree<Node, NodeTraits, Options, Tag, Compare>::rank(const Node & node) const
+{
+	static_assert(Options::order_statistics,
+	              "rank() requires ORDER_STATISTICS to be set.");
+
+	const Node * cur = &node;
+	size_t position = SubtreeSizes::get(cur->NB::_rbt_left);
+	while (cur->NB::get_parent() != nullptr) {
+		const Node * parent = cur->NB::get_parent();
+		if (parent->NB::_rbt_right == cur) {
+			position += SubtreeSizes::get(parent->NB::_rbt_left) + 1;
+		}
+		cur = parent;
+	}
+
+	return position;
+}
+
 template <class Node, class NodeTraits, class Options, class Tag, class Compare>
 void
 RBTree<Node, NodeTraits, Options, Tag, Compare>::clear()
@@ -638,6 +1626,7 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::verify_tree() const
 	}
 
 	std::set<Node *> seen;
+	Node * prev = nullptr;
 
 	while (cur != nullptr) {
 		if (seen.find(cur) != seen.end()) {
@@ -668,6 +1657,17 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::verify_tree() const
 			}
 		}
 
+		if (!SubtreeSizes::verify(cur)) {
+			assert(false);
+			return false;
+		}
+
+		if (!OrderTags::verify(prev, cur)) {
+			assert(false);
+			return false;
+		}
+		prev = cur;
+
 		/*
 		 * Begin: find the next-largest vertex
 		 */
@@ -819,6 +1819,9 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::swap_nodes(Node * n1,
 		n1->swap_color_with(n2);
 	}
 
+	// Subtree sizes belong to the positions, not to the nodes
+	SubtreeSizes::swap(n1, n2);
+
 	NodeTraits::swapped(*n1, *n2, *this);
 }
 
@@ -988,6 +1991,7 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::remove_to_leaf(Node & node)
 		    nullptr; // this stored the node to be deleted…
 		             // TODO null the pointers in node?
 		             //}
+		SubtreeSizes::reduce_on_path(right_child);
 
 		NodeTraits::deleted_below(*right_child, *this);
 
@@ -1005,6 +2009,7 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::remove_to_leaf(Node & node)
 		} else {
 			node.NB::get_parent()->NB::_rbt_right = nullptr;
 		}
+		SubtreeSizes::reduce_on_path(node.NB::get_parent());
 
 		NodeTraits::deleted_below(*node.NB::get_parent(), *this);
 	} else {
@@ -1310,14 +2315,15 @@ typename RBTree<Node, NodeTraits, Options, Tag,
 RBTree<Node, NodeTraits, Options, Tag, Compare>::find(const Comparable & query,
                                                       Callbacks * cbs)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	cbs->init_root(cur);
 
 	while (cur != nullptr) {
-		if (this->cmp(*cur, query)) {
+		if (this->cmp(*cur, q)) {
 			cur = cur->NB::_rbt_right;
 			cbs->descend_right(cur);
-		} else if (this->cmp(query, *cur)) {
+		} else if (this->cmp(q, *cur)) {
 			cur = cur->NB::_rbt_left;
 			cbs->descend_left(cur);
 		} else {
@@ -1336,11 +2342,12 @@ typename RBTree<Node, NodeTraits, Options, Tag,
                 Compare>::template iterator<false>
 RBTree<Node, NodeTraits, Options, Tag, Compare>::find(const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(*cur, query)) {
+		if (this->cmp(*cur, q)) {
 			cur = cur->NB::_rbt_right;
 		} else {
 			last_left = cur;
@@ -1348,7 +2355,7 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::find(const Comparable & query)
 		}
 	}
 
-	if ((last_left != nullptr) && (!this->cmp(query, *last_left))) {
+	if ((last_left != nullptr) && (!this->cmp(q, *last_left))) {
 		return iterator<false>(last_left);
 	} else {
 		return this->end();
@@ -1372,11 +2379,12 @@ typename RBTree<Node, NodeTraits, Options, Tag,
 RBTree<Node, NodeTraits, Options, Tag, Compare>::lower_bound(
     const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(*cur, query)) {
+		if (this->cmp(*cur, q)) {
 			cur = cur->NB::_rbt_right;
 		} else {
 			last_left = cur;
@@ -1391,6 +2399,83 @@ RBTree<Node, NodeTraits, Options, Tag, Compare>::lower_bound(
 	}
 }
 
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <bool exact, class ForwardIt, class OutputIt>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::search_batch(
+    ForwardIt queries_begin, ForwardIt queries_end, OutputIt results)
+{
+	ForwardIt queries[BATCH_WIDTH];
+	Node * cur[BATCH_WIDTH];
+	Node * last_left[BATCH_WIDTH];
+
+	ForwardIt next_query = queries_begin;
+	while (next_query != queries_end) {
+		size_t width = 0;
+		while ((width < BATCH_WIDTH) && (next_query != queries_end)) {
+			queries[width] = next_query;
+			cur[width] = this->root;
+			last_left[width] = nullptr;
+			++width;
+			++next_query;
+		}
+
+		// Advance all lookups by one level per round. The prefetch for a lookup
+		// has the rest of the round to complete.
+		bool active = true;
+		while (active) {
+			active = false;
+			for (size_t i = 0; i < width; ++i) {
+				if (cur[i] == nullptr) {
+					continue;
+				}
+
+				if (this->cmp(*cur[i], CachedKeys::query(*queries[i]))) {
+					cur[i] = cur[i]->NB::_rbt_right;
+				} else {
+					last_left[i] = cur[i];
+					cur[i] = cur[i]->NB::_rbt_left;
+				}
+
+				if (cur[i] != nullptr) {
+					__builtin_prefetch(cur[i]);
+					active = true;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < width; ++i) {
+			// TODO constexpr - if
+			if ((last_left[i] == nullptr) ||
+			    (exact &&
+			     this->cmp(CachedKeys::query(*queries[i]), *last_left[i]))) {
+				*results = this->end();
+			} else {
+				*results = iterator<false>(last_left[i]);
+			}
+			++results;
+		}
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class ForwardIt, class OutputIt>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::find_batch(
+    ForwardIt queries_begin, ForwardIt queries_end, OutputIt results)
+{
+	this->search_batch<true>(queries_begin, queries_end, results);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class ForwardIt, class OutputIt>
+void
+RBTree<Node, NodeTraits, Options, Tag, Compare>::lower_bound_batch(
+    ForwardIt queries_begin, ForwardIt queries_end, OutputIt results)
+{
+	this->search_batch<false>(queries_begin, queries_end, results);
+}
+
 template <class Node, class NodeTraits, class Options, class Tag, class Compare>
 template <class Comparable>
 typename RBTree<Node, NodeTraits, Options, Tag,
@@ -1398,11 +2483,12 @@ typename RBTree<Node, NodeTraits, Options, Tag,
 RBTree<Node, NodeTraits, Options, Tag, Compare>::upper_bound(
     const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(query, *cur)) {
+		if (this->cmp(q, *cur)) {
 			last_left = cur;
 			cur = cur->_rbt_left;
 		} else {
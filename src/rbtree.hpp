@@ -3,9 +3,15 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <set>
 #include <type_traits>
+#include <utility>
 
+#include "cached_key.hpp"
+#include "index_link.hpp"
 #include "options.hpp"
 #include "size_holder.hpp"
 #include "tree_iterator.hpp"
@@ -24,7 +30,7 @@ enum class Color
 	BLACK
 };
 
-template <class Node, bool compress_color>
+template <class Node, bool compress_color, class Links = bool>
 class ColorParentStorage;
 
 template <class Node>
@@ -58,13 +64,33 @@ private:
 	Color color;
 };
 
-template <class Node, class Tag, bool compress_color>
+// With index links, the color is always packed into the parent index
+template <class Node, bool compress_color, class Pool>
+class ColorParentStorage<Node, compress_color, TreeFlags::INDEX_LINKS<Pool>> {
+public:
+	void set_color(Color new_color);
+	Color get_color() const;
+	void set_parent(Node * new_parent);
+	Node * get_parent() const;
+
+	void swap_parent_with(ColorParentStorage & other);
+	void swap_color_with(ColorParentStorage & other);
+
+private:
+	internal::IndexLink<Node, Pool> parent;
+};
+
+template <class Node, class Tag, bool compress_color, class Links = bool,
+          bool atomic_links = false>
 class RBTreeNodeBaseImpl {
 public:
-	Node * _rbt_left = nullptr;
-	Node * _rbt_right = nullptr;
+	using Link =
+	    typename internal::LinkTypeSelector<Node, Links, atomic_links>::type;
+
+	Link _rbt_left = nullptr;
+	Link _rbt_right = nullptr;
 
-	ColorParentStorage<Node, compress_color> _color_and_parent;
+	ColorParentStorage<Node, compress_color, Links> _color_and_parent;
 
 	// TODO namespaceing!
 	void set_color(Color new_color);
@@ -82,6 +108,245 @@ public:
 	size_t get_depth() const noexcept;
 };
 
+/*
+ * Storage for the subtree sizes if TreeFlags::ORDER_STATISTICS is set. The tag
+ * keeps the bases of nodes that live in multiple trees apart.
+ */
+template <class Tag, bool enable>
+class SubtreeSizeStorage {
+};
+
+template <class Tag>
+class SubtreeSizeStorage<Tag, true> {
+public:
+	size_t _rbt_size = 1;
+};
+
+/*
+ * Maintenance of the subtree sizes. All of these are no-ops if
+ * TreeFlags::ORDER_STATISTICS is not set.
+ */
+template <class Node, class NB, bool enable>
+struct SubtreeSizes;
+
+template <class Node, class NB>
+struct SubtreeSizes<Node, NB, true>
+{
+	static size_t
+	get(const Node * n) noexcept
+	{
+		return (n == nullptr) ? 0 : n->NB::_rbt_size;
+	}
+
+	static void
+	fix(Node * n) noexcept
+	{
+		n->NB::_rbt_size = 1 + get(n->NB::_rbt_left) + get(n->NB::_rbt_right);
+	}
+
+	static void
+	add_on_path(Node * n) noexcept
+	{
+		while (n != nullptr) {
+			n->NB::_rbt_size++;
+			n = n->NB::get_parent();
+		}
+	}
+
+	static void
+	reduce_on_path(Node * n) noexcept
+	{
+		while (n != nullptr) {
+			n->NB::_rbt_size--;
+			n = n->NB::get_parent();
+		}
+	}
+
+	static void
+	swap(Node * n1, Node * n2) noexcept
+	{
+		std::swap(n1->NB::_rbt_size, n2->NB::_rbt_size);
+	}
+
+	static bool
+	verify(const Node * n) noexcept
+	{
+		return get(n) == 1 + get(n->NB::_rbt_left) + get(n->NB::_rbt_right);
+	}
+};
+
+template <class Node, class NB>
+struct SubtreeSizes<Node, NB, false>
+{
+	static size_t
+	get(const Node * n) noexcept
+	{
+		(void)n;
+		return 0;
+	}
+
+	static void
+	fix(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	add_on_path(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	reduce_on_path(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	swap(Node * n1, Node * n2) noexcept
+	{
+		(void)n1;
+		(void)n2;
+	}
+
+	static bool
+	verify(const Node * n) noexcept
+	{
+		(void)n;
+		return true;
+	}
+};
+
+/*
+ * Storage for the order labels if TreeFlags::ORDER_QUERIES is set.
+ */
+template <class Tag, bool enable>
+class OrderTagStorage {
+};
+
+template <class Tag>
+class OrderTagStorage<Tag, true> {
+public:
+	uint64_t _rbt_order_tag = 0;
+};
+
+/*
+ * Maintenance of the order labels, a variant of the order-maintenance
+ * structure by Bender et al. ("Two Simplified Algorithms for Maintaining Order
+ * in a List"). Every node carries a label such that the labels increase along
+ * the in-order of the tree, so comparing two labels answers order queries in
+ * O(1). A new node gets a label in the middle between its neighbors' labels. If
+ * there is no room, the smallest enclosing aligned label range that is not too
+ * dense is relabeled evenly, which takes O(log n) amortized time. Removing
+ * nodes never requires relabeling. Appended nodes are labeled like a run of
+ * insertions after the previously last node, i.e., only the appended nodes
+ * and a dense range before them are relabeled.
+ *
+ * All of these are no-ops if TreeFlags::ORDER_QUERIES is not set.
+ */
+template <class Node, class NB, bool enable>
+struct OrderTags;
+
+template <class Node, class NB>
+struct OrderTags<Node, NB, true>
+{
+	static bool
+	precedes(const Node * a, const Node * b) noexcept
+	{
+		return a->NB::_rbt_order_tag < b->NB::_rbt_order_tag;
+	}
+
+	// <n> has just been linked into the tree
+	static void inserted(Node * n) noexcept;
+	// The nodes starting at <first_after> have been appended after <last>
+	static void appended(Node * last, Node * first_after) noexcept;
+	// Relabels the whole tree that <n> is in
+	static void rebuilt(Node * n) noexcept;
+
+	// Marks <n> as linked into the tree without a label. Must be followed by
+	// label_unlabeled() for every marked node before the labels are used.
+	static void
+	unlabel(Node * n) noexcept
+	{
+		n->NB::_rbt_order_tag = UNLABELED;
+	}
+	// If <n> is marked as unlabeled, labels it together with all consecutive
+	// marked nodes after it
+	static void label_unlabeled(Node * n) noexcept;
+
+	static bool verify(const Node * prev, const Node * n) noexcept;
+
+private:
+	// Labels are in [0, UNIVERSE)
+	static constexpr uint64_t UNIVERSE = static_cast<uint64_t>(1) << 63;
+	static constexpr unsigned int UNIVERSE_BITS = 63;
+	static constexpr uint64_t UNLABELED = UNIVERSE;
+	// A label range of size 2^i may hold at most DENSITY_BASE^i nodes.
+	static constexpr double DENSITY_BASE = 1.6;
+
+	// The <count> nodes in [first, last] have just been linked into the tree
+	static void inserted_run(Node * first, Node * last, size_t count) noexcept;
+	static void relabel_around(Node * first, Node * last, size_t count,
+	                           uint64_t anchor) noexcept;
+	static void spread(Node * first, size_t count, uint64_t lo,
+	                   uint64_t width) noexcept;
+
+	static Node * prev(Node * n) noexcept;
+	static Node * next(Node * n) noexcept;
+};
+
+template <class Node, class NB>
+struct OrderTags<Node, NB, false>
+{
+	static bool
+	precedes(const Node * a, const Node * b) noexcept
+	{
+		(void)a;
+		(void)b;
+		return false;
+	}
+
+	static void
+	inserted(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	appended(Node * last, Node * first_after) noexcept
+	{
+		(void)last;
+		(void)first_after;
+	}
+
+	static void
+	rebuilt(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	unlabel(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	label_unlabeled(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static bool
+	verify(const Node * prev, const Node * n) noexcept
+	{
+		(void)prev;
+		(void)n;
+		return true;
+	}
+};
+
 /// @endcond
 } // namespace rbtree_internal
 
@@ -131,8 +396,14 @@ public:
  */
 template <class Node, class Options = DefaultOptions, class Tag = int>
 class RBTreeNodeBase
-    : public rbtree_internal::RBTreeNodeBaseImpl<Node, Tag,
-                                                 Options::compress_color> {
+    : public rbtree_internal::RBTreeNodeBaseImpl<
+          Node, Tag, Options::compress_color, typename Options::index_links,
+          Options::atomic_links>,
+      public cached_key_internal::CachedKeyStorage<
+          RBTreeNodeBase<Node, Options, Tag>, typename Options::cached_key>,
+      public rbtree_internal::SubtreeSizeStorage<Tag,
+                                                 Options::order_statistics>,
+      public rbtree_internal::OrderTagStorage<Tag, Options::order_queries> {
 };
 
 /**
@@ -193,6 +464,23 @@ public:
 		(void)old_descendant;
 		(void)t;
 	}
+
+	/**
+	 * @brief Called for every node whose subtree has been linked wholesale
+	 *
+	 * This is called by bulk operations (e.g. RBTree::build_from_sorted()) that
+	 * link nodes directly instead of inserting them one by one. It is called
+	 * bottom-up, i.e., when it is called on a node, it has already been called
+	 * on all nodes in that node's subtree. Augmented trees should recompute
+	 * their node's information from its children here.
+	 */
+	template <class Node, class Tree>
+	static void
+	rebuilt(Node & node, Tree & t)
+	{
+		(void)node;
+		(void)t;
+	}
 };
 
 /**
@@ -219,9 +507,9 @@ template <class Node, class NodeTraits, class Options = DefaultOptions,
 class RBTree {
 public:
 	using MyClass = RBTree<Node, NodeTraits, Options, Tag, Compare>;
-	using Base =
-	    rbtree_internal::RBTreeNodeBaseImpl<Node, Tag,
-	                                        Options::compress_color>; // TODO
+	using Base = rbtree_internal::RBTreeNodeBaseImpl<
+	    Node, Tag, Options::compress_color, typename Options::index_links,
+	    Options::atomic_links>; // TODO
 	// rename
 
 	/**
@@ -265,10 +553,27 @@ public:
 	static_assert(std::is_base_of<NB, Node>::value,
 	              "Node class not properly derived from RBTreeNodeBase");
 
-	// Class to tell the abstract search tree iterator how to handle our nodes
 private:
+	using SubtreeSizes =
+	    rbtree_internal::SubtreeSizes<Node, NB, Options::order_statistics>;
+	using OrderTags =
+	    rbtree_internal::OrderTags<Node, NB, Options::order_queries>;
+	using CachedKeys =
+	    cached_key_internal::CachedKeys<Node, NB, typename Options::cached_key,
+	                                    Compare>;
+
+public:
+	// Class to tell the abstract search tree iterator how to handle our nodes
 	class NodeInterface {
 	public:
+		static constexpr bool subtree_sizes = Options::order_statistics;
+
+		static size_t
+		get_subtree_size(const Node * n)
+		{
+			return SubtreeSizes::get(n);
+		}
+
 		static Node *
 		get_parent(Node * n)
 		{
@@ -364,6 +669,59 @@ public:
 	void insert_left_leaning(Node & node);
 	void insert_right_leaning(Node & node);
 
+	/**
+	 * @brief Builds the tree from a sorted range of nodes in O(n)
+	 *
+	 * Replaces the contents of the tree by the nodes in [begin, end). Instead of
+	 * inserting the nodes one by one, the nodes are linked directly into a
+	 * balanced shape and colored accordingly. Any nodes that were in the tree
+	 * before are discarded, as if clear() had been called.
+	 *
+	 * The iterators may either dereference to Node & or to Node *. Since the
+	 * range is only traversed once (after determining its length), forward
+	 * iterators are sufficient.
+	 *
+	 * Instead of the leaf_inserted() / rotated_*() hooks, NodeTraits::rebuilt()
+	 * is called on every node, bottom-up.
+	 *
+	 * @warning The range must be sorted with respect to Compare. If MULTIPLE is
+	 * not set, it must not contain elements that compare equally.
+	 *
+	 * @param begin   Iterator to the first node to be put into the tree
+	 * @param end     Iterator past the last node to be put into the tree
+	 */
+	template <class InputIt>
+	void build_from_sorted(InputIt begin, InputIt end);
+
+	/**
+	 * @brief Inserts a sorted range of nodes into the tree
+	 *
+	 * Inserts all nodes in [begin, end) into the tree. As with
+	 * build_from_sorted(), the iterators may either dereference to Node & or to
+	 * Node *, and forward iterators are sufficient.
+	 *
+	 * Since the range is sorted, every node is inserted starting from the
+	 * position of the previously inserted node instead of from the root. If the
+	 * batch is large compared to the tree, the batch is instead merged into the
+	 * tree by splits and joins (see split() and join()): The middle node of the
+	 * batch splits the tree, the two halves of the batch are merged into the two
+	 * parts recursively, and the parts are joined again with the middle node in
+	 * between. For m batch nodes, this takes O(m log(n / m + 1)) time and no
+	 * extra memory. Without CONSTANT_TIME_SIZE, the size of the tree is
+	 * estimated from its black height for this decision.
+	 *
+	 * Nodes from the batch that compare equally to nodes already in the tree
+	 * are placed after these nodes. If MULTIPLE is not set, such nodes are not
+	 * inserted.
+	 *
+	 * @warning The range must be sorted with respect to Compare.
+	 *
+	 * @param begin   Iterator to the first node to be inserted
+	 * @param end     Iterator past the last node to be inserted
+	 */
+	template <class InputIt>
+	void insert_batch(InputIt begin, InputIt end);
+
 	/**
 	 * @brief Finds an element in the tree
 	 *
@@ -447,6 +805,51 @@ public:
 	template <class Comparable>
 	iterator<false> lower_bound(const Comparable & query);
 
+	/**
+	 * @brief Finds many elements at once
+	 *
+	 * Does the same as calling find() for every query in [<queries_begin>,
+	 * <queries_end>), but advances groups of BATCH_WIDTH lookups in lock-step.
+	 * Every lookup prefetches the next node it is going to visit, and the
+	 * other lookups of the group are advanced while that node is being loaded.
+	 * Thus, the cache misses of the lookups overlap instead of adding up. This
+	 * pays off if the tree is much larger than the cache.
+	 *
+	 * @warning Not available for explicitly ordered trees
+	 *
+	 * @param queries_begin   Iterator to the first query
+	 * @param queries_end     Iterator past the last query
+	 * @param results         Output iterator that receives one iterator<false>
+	 * per query, in the order of the queries. See find() for the values.
+	 */
+	template <class ForwardIt, class OutputIt>
+	void find_batch(ForwardIt queries_begin, ForwardIt queries_end,
+	                OutputIt results);
+
+	/**
+	 * @brief Lower-bounds many elements at once
+	 *
+	 * Does the same as calling lower_bound() for every query in
+	 * [<queries_begin>, <queries_end>). See find_batch() for how the lookups are
+	 * interleaved.
+	 *
+	 * @warning Not available for explicitly ordered trees
+	 *
+	 * @param queries_begin   Iterator to the first query
+	 * @param queries_end     Iterator past the last query
+	 * @param results         Output iterator that receives one iterator<false>
+	 * per query, in the order of the queries. See lower_bound() for the values.
+	 */
+	template <class ForwardIt, class OutputIt>
+	void lower_bound_batch(ForwardIt queries_begin, ForwardIt queries_end,
+	                       OutputIt results);
+
+	/**
+	 * The number of lookups that find_batch() and lower_bound_batch() advance
+	 * in lock-step.
+	 */
+	static constexpr size_t BATCH_WIDTH = 16;
+
 	/**
 	 * @brief Removes <node> from the tree
 	 *
@@ -456,6 +859,136 @@ public:
 	 */
 	void remove(Node & node);
 
+	/**
+	 * @brief Returns the k-th element in the tree
+	 *
+	 * Returns an iterator to the element at (zero-based) position <k> in the
+	 * tree, or end() if there are at most <k> elements in the tree. Runs in
+	 * O(log n).
+	 *
+	 * @warning This method is only available if ORDER_STATISTICS is set as
+	 * option!
+	 *
+	 * @param k   The position of the element to be returned
+	 * @returns An iterator to the k-th element, or end()
+	 */
+	const_iterator<false> select(size_t k) const;
+	iterator<false> select(size_t k);
+
+	/**
+	 * @brief Returns the position of a node in the tree
+	 *
+	 * Returns the number of elements that come before <node> in the tree, i.e.,
+	 * the (zero-based) position of <node>. Runs in O(log n).
+	 *
+	 * @warning This method is only available if ORDER_STATISTICS is set as
+	 * option!
+	 *
+	 * @param node  The node whose position should be returned. Must be in the
+	 * tree.
+	 * @returns The position of <node>
+	 */
+	size_t rank(const Node & node) const;
+
+	/**
+	 * @brief Returns whether one node comes before another node in the tree
+	 *
+	 * Returns true if <a> comes before <b> in the tree, i.e., if an in-order
+	 * traversal would visit <a> before <b>. This is mostly useful for elements
+	 * that compare equally, whose order is determined by the order (and the
+	 * hints) of their insertion. Runs in O(1).
+	 *
+	 * Insertions and joins maintain a label for every node, which takes O(log n)
+	 * amortized time per insertion. build_from_sorted() labels all nodes in
+	 * O(n). A join may need to relabel the appended nodes, taking time linear in
+	 * their number, see join().
+	 *
+	 * @warning This method is only available if ORDER_QUERIES is set as option!
+	 *
+	 * @param a   A node in the tree
+	 * @param b   Another node in the tree
+	 * @returns true if <a> comes before <b>, false otherwise
+	 */
+	bool precedes(const Node & a, const Node & b) const;
+
+	/**
+	 * @brief Splits the tree at <key>
+	 *
+	 * Moves all elements that do not compare less than <key> (i.e., the range
+	 * [lower_bound(key), end()) ) into <right>. Any elements that were in
+	 * <right> before are discarded, as if clear() had been called on it.
+	 *
+	 * The split runs in O(log n), calling the NodeTraits' rebuilt() and
+	 * rotated_*() hooks on the nodes whose subtrees change. If ORDER_QUERIES is
+	 * set, the labels of both halves stay valid and are not touched.
+	 *
+	 * @warning If CONSTANT_TIME_SIZE is set but ORDER_STATISTICS is not, the
+	 * sizes of the two resulting trees must be recounted by walking the smaller
+	 * one, and the split takes O(log n + min(|L|, |R|)) for the resulting trees
+	 * L and R. Set ORDER_STATISTICS as well to read the sizes off the subtree
+	 * sizes, keeping the split at O(log n).
+	 *
+	 * @param key     An object comparable to Node at which to split the tree
+	 * @param right   The tree that receives the elements from <key> onwards
+	 */
+	template <class Comparable>
+	void split(const Comparable & key, MyClass & right);
+
+	/**
+	 * @brief Appends another tree to this tree
+	 *
+	 * Moves all elements from <other> into this tree. Afterwards, <other> is
+	 * empty. The join runs in O(log n), calling the NodeTraits' rebuilt() and
+	 * rotated_*() hooks on the nodes whose subtrees change.
+	 *
+	 * @warning If ORDER_QUERIES is set, the m elements of <other> usually must
+	 * be relabeled to follow this tree's labels, which makes the join linear in
+	 * m. If they do not fit above this tree's largest label, a range of this
+	 * tree's elements before the join point is relabeled as well, just as for m
+	 * insertions at the end of the tree, taking amortized O(m log n) time. Only
+	 * re-joining two trees that resulted from a split() stays at O(log n).
+	 *
+	 * @warning No element in <other> may compare less than any element in this
+	 * tree. If MULTIPLE is not set, the largest element in this tree must
+	 * compare less than the smallest element in <other>.
+	 *
+	 * @param other   The tree whose elements should go after this tree's
+	 * elements
+	 */
+	void join(MyClass & other);
+
+	/**
+	 * @brief Removes all elements in a range of keys
+	 *
+	 * Removes all elements that do not compare less than <lower>, but compare
+	 * less than <upper>, i.e., the range [lower_bound(lower),
+	 * lower_bound(upper)). Instead of removing the elements one by one, the
+	 * range is cut out of the tree by two splits and a join, see split() and
+	 * join(). Thus, this takes O(log n + k) time for k removed elements.
+	 *
+	 * @param lower   An object comparable to Node at which the range starts
+	 * @param upper   An object comparable to Node before which the range ends.
+	 * Must not compare less than <lower>.
+	 */
+	template <class Comparable1, class Comparable2>
+	void erase_range(const Comparable1 & lower, const Comparable2 & upper);
+
+	/**
+	 * @brief Removes all elements in a range of keys and hands them out
+	 *
+	 * Does the same as erase_range(), but appends the removed elements, in
+	 * order, to <out>. This allows e.g. to reuse the nodes.
+	 *
+	 * @param lower   An object comparable to Node at which the range starts
+	 * @param upper   An object comparable to Node before which the range ends.
+	 * Must not compare less than <lower>.
+	 * @param out     A ygg::List over the nodes that receives the removed
+	 * elements
+	 */
+	template <class Comparable1, class Comparable2, class OutList>
+	void extract_range(const Comparable1 & lower, const Comparable2 & upper,
+	                   OutList & out);
+
 	/**
 	 * @brief Removes all elements from the tree.
 	 *
@@ -562,7 +1095,8 @@ public:
 	void dbg_verify() const noexcept {};
 
 protected:
-	Node * root;
+	typename internal::LinkTypeSelector<Node, bool, Options::atomic_links>::type
+	    root;
 
 	template <class NodeNameGetter>
 	void dump_to_dot_base(const std::string & filename,
@@ -583,7 +1117,42 @@ protected:
 	template <bool on_equality_prefer_left>
 	void insert_leaf_base(Node & node, Node * start);
 
-	void fixup_after_insert(Node * node);
+	bool fixup_after_insert(Node * node);
+
+	template <class InputIt>
+	Node * build_subtree(InputIt & it, size_t count, size_t depth,
+	                     size_t red_depth);
+
+	size_t get_black_height() const;
+
+	template <bool exact, class ForwardIt, class OutputIt>
+	void search_batch(ForwardIt queries_begin, ForwardIt queries_end,
+	                  OutputIt results);
+	Node * join_with_pivot(Node * left, size_t left_height, Node & pivot,
+	                       Node * right, size_t right_height,
+	                       size_t & joined_height);
+	Node * join_subtrees(Node * left, size_t left_height, Node * right,
+	                     size_t right_height, size_t & joined_height);
+	Node * detach_subtree(Node * sub_root, size_t & height);
+	template <bool equal_goes_left, class Comparable>
+	void split_subtree(Node * sub_root, size_t height, const Comparable & key,
+	                   Node *& left, size_t & left_height, Node *& right,
+	                   size_t & right_height);
+	template <class Comparable>
+	void split_uncounted(const Comparable & key, MyClass & right);
+	template <class Comparable1, class Comparable2>
+	void detach_range(const Comparable1 & lower, const Comparable2 & upper,
+	                  MyClass & range);
+	void count_after_split(MyClass & right, std::true_type);
+	void count_after_split(MyClass & right, std::false_type);
+
+	bool insert_after_finger(Node & node, Node * finger);
+	size_t get_size_lower_bound(std::true_type) const;
+	size_t get_size_lower_bound(std::false_type) const;
+	template <class InputIt>
+	Node * merge_subtree(Node * sub_root, size_t height, InputIt begin,
+	                     size_t count, size_t & merged_height, size_t & inserted);
+
 	void rotate_left(Node * parent);
 	void rotate_right(Node * parent);
 
@@ -600,7 +1169,7 @@ protected:
 	bool verify_tree() const;
 	bool verify_order() const;
 
-	Compare cmp;
+	typename CachedKeys::Compare cmp;
 
 	SizeHolder<Options::constant_time_size> s;
 };
@@ -0,0 +1,168 @@
+#ifndef YGG_SEARCH_SNAPSHOT_CPP
+#define YGG_SEARCH_SNAPSHOT_CPP
+
+#include <iterator>
+
+#include "search_snapshot.hpp"
+
+namespace ygg {
+
+template <class Node, class KeyOf, class Compare>
+SearchSnapshot<Node, KeyOf, Compare>::SearchSnapshot() : cmp()
+{}
+
+template <class Node, class KeyOf, class Compare>
+template <class Tree>
+SearchSnapshot<Node, KeyOf, Compare>::SearchSnapshot(Tree & tree) : cmp()
+{
+	this->rebuild(tree);
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class Tree>
+void
+SearchSnapshot<Node, KeyOf, Compare>::rebuild(Tree & tree)
+{
+	this->build(tree.begin(), tree.end());
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class ForwardIt>
+void
+SearchSnapshot<Node, KeyOf, Compare>::build(ForwardIt begin, ForwardIt end)
+{
+	size_t count = static_cast<size_t>(std::distance(begin, end));
+
+	// Index 0 is unused, this keeps the index arithmetic simple.
+	this->nodes.assign(count + 1, nullptr);
+	this->keys.clear();
+	this->keys.reserve(count + 1);
+	this->keys.resize(1);
+
+	ForwardIt it = begin;
+	this->fill(1, it);
+
+	for (size_t k = 1; k <= count; ++k) {
+		this->keys.push_back(Storage::store(*this->nodes[k]));
+	}
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class ForwardIt>
+void
+SearchSnapshot<Node, KeyOf, Compare>::fill(size_t k, ForwardIt & it)
+{
+	// In-order traversal of the implicit tree
+	if (k < this->nodes.size()) {
+		this->fill(2 * k, it);
+		this->nodes[k] = &utilities::deref_node<Node>(*it);
+		++it;
+		this->fill(2 * k + 1, it);
+	}
+}
+
+template <class Node, class KeyOf, class Compare>
+void
+SearchSnapshot<Node, KeyOf, Compare>::prefetch(size_t k) const noexcept
+{
+	// The 16 descendants four levels below k are adjacent in the array. For
+	// small keys, they share a cache line.
+	constexpr size_t descendants = 16;
+	if (k * descendants < this->keys.size()) {
+		__builtin_prefetch(this->keys.data() + k * descendants);
+	}
+}
+
+template <class Node, class KeyOf, class Compare>
+size_t
+SearchSnapshot<Node, KeyOf, Compare>::last_left_turn(size_t k) const noexcept
+{
+	// The path to k is encoded in its bits, with a 1 meaning "went right". Going
+	// left for the last time happened above the lowest zero bit. If we never
+	// went left, this results in 0.
+	return k >> __builtin_ffsl(static_cast<long>(~k));
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class Comparable>
+size_t
+SearchSnapshot<Node, KeyOf, Compare>::lower_bound_index(
+    const Comparable & query) const
+{
+	size_t n = this->keys.size();
+	size_t k = 1;
+	while (k < n) {
+		this->prefetch(k);
+		k = 2 * k +
+		    static_cast<size_t>(this->cmp(Storage::view(this->keys[k]), query));
+	}
+
+	return this->last_left_turn(k);
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class Comparable>
+Node *
+SearchSnapshot<Node, KeyOf, Compare>::lower_bound(
+    const Comparable & query) const
+{
+	if (this->empty()) {
+		return nullptr;
+	}
+	return this->nodes[this->lower_bound_index(query)];
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class Comparable>
+Node *
+SearchSnapshot<Node, KeyOf, Compare>::upper_bound(
+    const Comparable & query) const
+{
+	if (this->empty()) {
+		return nullptr;
+	}
+
+	size_t n = this->keys.size();
+	size_t k = 1;
+	while (k < n) {
+		this->prefetch(k);
+		k = 2 * k +
+		    static_cast<size_t>(!this->cmp(query, Storage::view(this->keys[k])));
+	}
+
+	return this->nodes[this->last_left_turn(k)];
+}
+
+template <class Node, class KeyOf, class Compare>
+template <class Comparable>
+Node *
+SearchSnapshot<Node, KeyOf, Compare>::find(const Comparable & query) const
+{
+	if (this->empty()) {
+		return nullptr;
+	}
+
+	size_t k = this->lower_bound_index(query);
+	if ((k != 0) && !this->cmp(query, Storage::view(this->keys[k]))) {
+		return this->nodes[k];
+	}
+	return nullptr;
+}
+
+template <class Node, class KeyOf, class Compare>
+size_t
+SearchSnapshot<Node, KeyOf, Compare>::size() const noexcept
+{
+	return this->keys.empty() ? 0 : this->keys.size() - 1;
+}
+
+template <class Node, class KeyOf, class Compare>
+bool
+SearchSnapshot<Node, KeyOf, Compare>::empty() const noexcept
+{
+	return this->size() == 0;
+}
+
+} // namespace ygg
+
+#endif // YGG_SEARCH_SNAPSHOT_CPP
@@ -0,0 +1,196 @@
+#ifndef YGG_SEARCH_SNAPSHOT_HPP
+#define YGG_SEARCH_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util.hpp"
+
+namespace ygg {
+
+namespace snapshot_internal {
+/// @cond INTERNAL
+
+/*
+ * Decides what is stored in the search array. By default, pointers to the
+ * nodes are stored and dereferenced for every comparison. With a KeyOf class,
+ * copies of the keys are stored.
+ */
+template <class Node, class KeyOf>
+struct KeyStorage
+{
+	using stored_type =
+	    typename std::decay<decltype(KeyOf::get_key(std::declval<Node &>()))>::type;
+
+	static stored_type
+	store(Node & n)
+	{
+		return KeyOf::get_key(n);
+	}
+
+	static const stored_type &
+	view(const stored_type & k)
+	{
+		return k;
+	}
+};
+
+template <class Node>
+struct KeyStorage<Node, void>
+{
+	using stored_type = Node *;
+
+	static stored_type
+	store(Node & n)
+	{
+		return &n;
+	}
+
+	static const Node &
+	view(const stored_type & k)
+	{
+		return *k;
+	}
+};
+
+/// @endcond
+} // namespace snapshot_internal
+
+/**
+ * @brief A read-only, cache-friendly search structure over the nodes of a tree
+ *
+ * A SearchSnapshot freezes the current contents of an RBTree or ZTree (or any
+ * sorted range of nodes) into an array in Eytzinger (i.e., BFS) layout. No
+ * child pointers are stored. The searches descend the implicit tree without
+ * branching on the comparison results and prefetch the array a few levels
+ * ahead, which is usually a lot faster than searching the tree itself.
+ *
+ * The results are pointers to the nodes in the tree. The snapshot does not
+ * notice changes to the tree. After modifying the tree, call rebuild(). Any
+ * node that is removed from the tree must not be accessed via the snapshot
+ * anymore.
+ *
+ * @tparam Node     The node class
+ * @tparam KeyOf    If void (the default), the snapshot stores pointers to the
+ * nodes and compares the nodes themselves. Otherwise, KeyOf must provide a
+ * static method get_key(const Node &). The snapshot then stores copies of the
+ * keys, which is more cache-friendly for small keys. Compare must be able to
+ * compare the keys to all your Comparable types in both directions.
+ * @tparam Compare  A compare class. See RBTree for details.
+ */
+template <class Node, class KeyOf = void,
+          class Compare = ygg::rbtree_internal::flexible_less>
+class SearchSnapshot {
+public:
+	/**
+	 * @brief Creates an empty snapshot
+	 */
+	SearchSnapshot();
+
+	/**
+	 * @brief Creates a snapshot of the current contents of <tree>
+	 *
+	 * @param tree  The tree to be frozen. Anything that can be iterated in
+	 * sorted order works, e.g. an RBTree or a ZTree.
+	 */
+	template <class Tree>
+	explicit SearchSnapshot(Tree & tree);
+
+	/**
+	 * @brief Replaces the contents of the snapshot with the contents of <tree>
+	 *
+	 * Runs in O(n).
+	 *
+	 * @param tree  The tree to be frozen
+	 */
+	template <class Tree>
+	void rebuild(Tree & tree);
+
+	/**
+	 * @brief Replaces the contents of the snapshot with a range of nodes
+	 *
+	 * The range can either contain nodes or pointers to nodes. It must be sorted
+	 * with respect to Compare. Runs in O(n).
+	 *
+	 * @param begin   Iterator to the first node (or node pointer)
+	 * @param end     Iterator past the last node (or node pointer)
+	 */
+	template <class ForwardIt>
+	void build(ForwardIt begin, ForwardIt end);
+
+	/**
+	 * @brief Finds an element
+	 *
+	 * Returns a pointer to the first element that compares equally to <query>.
+	 * See RBTree::find() for the requirements on Comparable.
+	 *
+	 * @param query An object comparing equally to the element that should be
+	 * found.
+	 * @returns A pointer to the found node, or nullptr if no such node exists
+	 */
+	template <class Comparable>
+	Node * find(const Comparable & query) const;
+
+	/**
+	 * @brief Lower-bounds an element
+	 *
+	 * Returns a pointer to the first element that does not compare less than
+	 * <query>. See RBTree::lower_bound() for details.
+	 *
+	 * @param query An object comparable to Node that should be lower-bounded
+	 * @returns A pointer to the first node not less than <query>, or nullptr if
+	 * no such node exists
+	 */
+	template <class Comparable>
+	Node * lower_bound(const Comparable & query) const;
+
+	/**
+	 * @brief Upper-bounds an element
+	 *
+	 * Returns a pointer to the first element that compares greater than <query>.
+	 * See RBTree::upper_bound() for details.
+	 *
+	 * @param query An object comparable to Node that should be upper-bounded
+	 * @returns A pointer to the first node greater than <query>, or nullptr if no
+	 * such node exists
+	 */
+	template <class Comparable>
+	Node * upper_bound(const Comparable & query) const;
+
+	/**
+	 * Returns the number of nodes in the snapshot.
+	 */
+	size_t size() const noexcept;
+
+	/**
+	 * Returns whether the snapshot is empty.
+	 */
+	bool empty() const noexcept;
+
+private:
+	using Storage = snapshot_internal::KeyStorage<Node, KeyOf>;
+	using Key = typename Storage::stored_type;
+
+	// Both arrays are in Eytzinger order, starting at index 1.
+	std::vector<Key> keys;
+	std::vector<Node *> nodes;
+
+	Compare cmp;
+
+	template <class ForwardIt>
+	void fill(size_t k, ForwardIt & it);
+
+	void prefetch(size_t k) const noexcept;
+	size_t last_left_turn(size_t k) const noexcept;
+
+	template <class Comparable>
+	size_t lower_bound_index(const Comparable & query) const;
+};
+
+} // namespace ygg
+
+#include "search_snapshot.cpp"
+
+#endif // YGG_SEARCH_SNAPSHOT_HPP
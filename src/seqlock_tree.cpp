@@ -0,0 +1,194 @@
+#ifndef YGG_SEQLOCK_TREE_CPP
+#define YGG_SEQLOCK_TREE_CPP
+
+#include <thread>
+
+#include "seqlock_tree.hpp"
+
+namespace ygg {
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::SeqLockRBTree()
+    : version(0), t(), cmp()
+{}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::begin_write() noexcept
+{
+	// An odd version tells readers that a write is in progress
+	this->version.store(this->version.load(std::memory_order_relaxed) + 1,
+	                    std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::end_write() noexcept
+{
+	this->version.store(this->version.load(std::memory_order_relaxed) + 1,
+	                    std::memory_order_release);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::insert(Node & node)
+{
+	std::lock_guard<std::mutex> guard(this->write_mutex);
+	this->begin_write();
+	this->t.insert(node);
+	this->end_write();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+void
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::remove(Node & node)
+{
+	std::lock_guard<std::mutex> guard(this->write_mutex);
+	this->begin_write();
+	this->t.remove(node);
+	this->end_write();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Func>
+void
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::modify(Func && f)
+{
+	std::lock_guard<std::mutex> guard(this->write_mutex);
+	this->begin_write();
+	f(this->t);
+	this->end_write();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Traversal>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::read(
+    Traversal && traversal) const
+{
+	while (true) {
+		uint64_t before = this->version.load(std::memory_order_acquire);
+		if ((before & 1) != 0) {
+			// A writer is active, the traversal would be wasted.
+			std::this_thread::yield();
+			continue;
+		}
+
+		bool ok = true;
+		Node * result = traversal(ok);
+
+		// Nothing read during the traversal may be reordered after this.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (ok && (this->version.load(std::memory_order_relaxed) == before)) {
+			return result;
+		}
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::
+    lower_bound_unsynchronized(const Comparable & query, bool & ok) const
+{
+	// With ATOMIC_LINKS, the root and the child links are read as relaxed
+	// atomics, since a writer may be changing them concurrently.
+	Node * cur = this->t.get_root();
+	Node * result = nullptr;
+
+	size_t depth = 0;
+	while (cur != nullptr) {
+		if (++depth > MAX_DEPTH) {
+			// Only possible while a writer is restructuring the tree
+			ok = false;
+			return nullptr;
+		}
+
+		if (this->cmp(*cur, query)) {
+			cur = Tree::get_right_child(cur);
+		} else {
+			result = cur;
+			cur = Tree::get_left_child(cur);
+		}
+	}
+
+	return result;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::
+    upper_bound_unsynchronized(const Comparable & query, bool & ok) const
+{
+	Node * cur = this->t.get_root();
+	Node * result = nullptr;
+
+	size_t depth = 0;
+	while (cur != nullptr) {
+		if (++depth > MAX_DEPTH) {
+			// Only possible while a writer is restructuring the tree
+			ok = false;
+			return nullptr;
+		}
+
+		if (this->cmp(query, *cur)) {
+			result = cur;
+			cur = Tree::get_left_child(cur);
+		} else {
+			cur = Tree::get_right_child(cur);
+		}
+	}
+
+	return result;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::lower_bound(
+    const Comparable & query) const
+{
+	return this->read([&](bool & ok) {
+		return this->lower_bound_unsynchronized(query, ok);
+	});
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::upper_bound(
+    const Comparable & query) const
+{
+	return this->read([&](bool & ok) {
+		return this->upper_bound_unsynchronized(query, ok);
+	});
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+template <class Comparable>
+Node *
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::find(
+    const Comparable & query) const
+{
+	return this->read([&](bool & ok) -> Node * {
+		Node * candidate = this->lower_bound_unsynchronized(query, ok);
+		// The comparison must happen before validating, too.
+		if ((candidate != nullptr) && !this->cmp(query, *candidate)) {
+			return candidate;
+		}
+		return nullptr;
+	});
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare>
+typename SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::Tree &
+SeqLockRBTree<Node, NodeTraits, Options, Tag, Compare>::get_unsynchronized()
+{
+	return this->t;
+}
+
+} // namespace ygg
+
+#endif // YGG_SEQLOCK_TREE_CPP
@@ -0,0 +1,161 @@
+#ifndef YGG_SEQLOCK_TREE_HPP
+#define YGG_SEQLOCK_TREE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "options.hpp"
+#include "rbtree.hpp"
+
+namespace ygg {
+
+/**
+ * @brief A red-black tree that can be read by many threads without locking
+ *
+ * This wraps an RBTree with a sequence lock. Writers (insert(), remove(),
+ * modify()) are serialized by a mutex and increment a version counter before
+ * and after changing the tree. Readers (find(), lower_bound(), upper_bound())
+ * take no lock at all. They traverse the tree optimistically and validate
+ * against the version counter afterwards, retrying the traversal if a writer
+ * was active in the meantime. Thus, readers never write to shared memory and
+ * do not slow each other down. Since readers follow the links while a writer
+ * changes them, the tree must use TreeFlags::ATOMIC_LINKS.
+ *
+ * The results are pointers to the nodes in the tree. They are only guaranteed
+ * to be in the tree at the time the read was validated.
+ *
+ * @warning Readers may still be looking at a node while it is being removed.
+ * A removed node may be re-inserted right away, but it must not be destroyed
+ * (or have its key changed) until all reads that were running during the
+ * removal have returned.
+ *
+ * @tparam Node         The node class. See RBTree.
+ * @tparam NodeTraits   The node traits. See RBTree.
+ * @tparam Options      The TreeOptions class. See RBTree. Must contain
+ * TreeFlags::ATOMIC_LINKS, and so must the options of the node base class.
+ * @tparam Tag          The tag identifying the tree. See RBTree.
+ * @tparam Compare      The compare class. See RBTree.
+ */
+template <class Node, class NodeTraits,
+          class Options = TreeOptions<TreeFlags::ATOMIC_LINKS>, class Tag = int,
+          class Compare = ygg::rbtree_internal::flexible_less>
+class SeqLockRBTree {
+public:
+	static_assert(Options::atomic_links,
+	              "SeqLockRBTree requires ATOMIC_LINKS to be set.");
+
+	using Tree = RBTree<Node, NodeTraits, Options, Tag, Compare>;
+
+	SeqLockRBTree();
+
+	/**
+	 * @brief Inserts <node> into the tree
+	 *
+	 * See RBTree::insert(). Blocks other writers, and makes concurrent readers
+	 * retry.
+	 *
+	 * @param node  The node to be inserted
+	 */
+	void insert(Node & node);
+
+	/**
+	 * @brief Removes <node> from the tree
+	 *
+	 * See RBTree::remove(). Blocks other writers, and makes concurrent readers
+	 * retry. See the class documentation for when the node may be destroyed.
+	 *
+	 * @param node  The node to be removed
+	 */
+	void remove(Node & node);
+
+	/**
+	 * @brief Runs an arbitrary modification of the tree as one write
+	 *
+	 * Calls <f> with a reference to the underlying RBTree while holding the
+	 * write lock. Concurrent readers see either the state before or after the
+	 * whole modification. Use this e.g. to remove and re-insert a node whose key
+	 * changes, or to insert a batch.
+	 *
+	 * @param f   A callable taking a Tree &
+	 */
+	template <class Func>
+	void modify(Func && f);
+
+	/**
+	 * @brief Finds an element without locking
+	 *
+	 * See RBTree::find(). Safe to call concurrently with writers and other
+	 * readers.
+	 *
+	 * @param query An object comparing equally to the element that should be
+	 * found.
+	 * @returns A pointer to the first element comparing equally to <query>, or
+	 * nullptr if no such element exists
+	 */
+	template <class Comparable>
+	Node * find(const Comparable & query) const;
+
+	/**
+	 * @brief Lower-bounds an element without locking
+	 *
+	 * See RBTree::lower_bound(). Safe to call concurrently with writers and
+	 * other readers.
+	 *
+	 * @param query An object comparable to Node that should be lower-bounded
+	 * @returns A pointer to the first element not less than <query>, or nullptr
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	Node * lower_bound(const Comparable & query) const;
+
+	/**
+	 * @brief Upper-bounds an element without locking
+	 *
+	 * See RBTree::upper_bound(). Safe to call concurrently with writers and
+	 * other readers.
+	 *
+	 * @param query An object comparable to Node that should be upper-bounded
+	 * @returns A pointer to the first element greater than <query>, or nullptr
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	Node * upper_bound(const Comparable & query) const;
+
+	/**
+	 * @brief Returns the underlying tree
+	 *
+	 * Accessing the tree directly is not synchronized at all. Only do so while
+	 * no other thread uses this object.
+	 */
+	Tree & get_unsynchronized();
+
+private:
+	// An RBTree with n nodes is at most 2 * log2(n + 1) deep. Longer paths can
+	// only be seen during a concurrent write.
+	static constexpr size_t MAX_DEPTH = 2 * 64;
+
+	alignas(64) std::atomic<uint64_t> version;
+	std::mutex write_mutex;
+
+	Tree t;
+	Compare cmp;
+
+	void begin_write() noexcept;
+	void end_write() noexcept;
+
+	template <class Traversal>
+	Node * read(Traversal && traversal) const;
+
+	template <class Comparable>
+	Node * lower_bound_unsynchronized(const Comparable & query, bool & ok) const;
+	template <class Comparable>
+	Node * upper_bound_unsynchronized(const Comparable & query, bool & ok) const;
+};
+
+} // namespace ygg
+
+#include "seqlock_tree.cpp"
+
+#endif // YGG_SEQLOCK_TREE_HPP
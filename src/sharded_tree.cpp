@@ -0,0 +1,318 @@
+#ifndef YGG_SHARDED_TREE_CPP
+#define YGG_SHARDED_TREE_CPP
+
+#include "sharded_tree.hpp"
+
+namespace ygg {
+
+template <class Tree, size_t Shards, class KeyOf>
+ShardedTree<Tree, Shards, KeyOf>::ShardedTree(const Splitters & splitters_in)
+    : splitters(splitters_in), cmp()
+{
+	for (size_t i = 0; i + 1 < Shards; ++i) {
+		this->shards[i].upper = splitters_in[i];
+		this->shards[i + 1].lower = splitters_in[i];
+	}
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Comparable>
+size_t
+ShardedTree<Tree, Shards, KeyOf>::route(const Comparable & query)
+{
+	std::shared_lock<std::shared_timed_mutex> guard(this->routing_mutex);
+
+	// The number of splitters not greater than query
+	size_t lo = 0;
+	size_t hi = Shards - 1;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (this->cmp(query, this->splitters[mid])) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return lo;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Comparable>
+bool
+ShardedTree<Tree, Shards, KeyOf>::contains(size_t i,
+                                           const Comparable & query) const
+{
+	const Shard & shard = this->shards[i];
+	if ((i > 0) && this->cmp(query, shard.lower)) {
+		return false;
+	}
+	if ((i + 1 < Shards) && !this->cmp(query, shard.upper)) {
+		return false;
+	}
+	return true;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Comparable>
+size_t
+ShardedTree<Tree, Shards, KeyOf>::lock_shard_for(
+    const Comparable & query, std::unique_lock<std::mutex> & lock)
+{
+	while (true) {
+		size_t i = this->route(query);
+		lock = std::unique_lock<std::mutex>(this->shards[i].mutex);
+
+		// The splitter might have been moved between routing and locking. The
+		// bounds of the locked shard are authoritative.
+		if (this->contains(i, query)) {
+			return i;
+		}
+		lock.unlock();
+	}
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+void
+ShardedTree<Tree, Shards, KeyOf>::insert(Node & node)
+{
+	std::unique_lock<std::mutex> lock;
+	size_t i = this->lock_shard_for(node, lock);
+
+	this->shards[i].t.insert(node);
+	this->shards[i].count++;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+void
+ShardedTree<Tree, Shards, KeyOf>::remove(Node & node)
+{
+	std::unique_lock<std::mutex> lock;
+	size_t i = this->lock_shard_for(node, lock);
+
+	this->shards[i].t.remove(node);
+	this->shards[i].count--;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Comparable>
+typename ShardedTree<Tree, Shards, KeyOf>::Node *
+ShardedTree<Tree, Shards, KeyOf>::find(const Comparable & query)
+{
+	std::unique_lock<std::mutex> lock;
+	size_t i = this->lock_shard_for(query, lock);
+
+	auto it = this->shards[i].t.find(query);
+	if (it == this->shards[i].t.end()) {
+		return nullptr;
+	}
+	return &*it;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Comparable>
+typename ShardedTree<Tree, Shards, KeyOf>::Node *
+ShardedTree<Tree, Shards, KeyOf>::lower_bound(const Comparable & query)
+{
+	Key next;
+	{
+		std::unique_lock<std::mutex> lock;
+		size_t i = this->lock_shard_for(query, lock);
+
+		auto it = this->shards[i].t.lower_bound(query);
+		if (it != this->shards[i].t.end()) {
+			return &*it;
+		}
+		if (i + 1 == Shards) {
+			return nullptr;
+		}
+
+		// Everything in [query, upper) is absent, continue at upper.
+		next = this->shards[i].upper;
+	}
+
+	return this->lower_bound(next);
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Func>
+void
+ShardedTree<Tree, Shards, KeyOf>::for_each(Func && f)
+{
+	// The first shard has no lower bound and thus always holds the smallest
+	// elements.
+	std::unique_lock<std::mutex> lock(this->shards[0].mutex);
+	for (auto & n : this->shards[0].t) {
+		f(n);
+	}
+	if (Shards == 1) {
+		return;
+	}
+	Key resume = this->shards[0].upper;
+	lock.unlock();
+
+	// Every step visits [resume, upper) of one shard. Since these ranges are
+	// consecutive, no element is visited twice, no matter how the splitters
+	// move in between.
+	while (true) {
+		size_t i = this->lock_shard_for(resume, lock);
+		Tree & t = this->shards[i].t;
+		for (auto it = t.lower_bound(resume); it != t.end(); ++it) {
+			f(*it);
+		}
+
+		if (i + 1 == Shards) {
+			return;
+		}
+		resume = this->shards[i].upper;
+		lock.unlock();
+	}
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+template <class Target>
+void
+ShardedTree<Tree, Shards, KeyOf>::shift(size_t i, Target && get_target)
+{
+	assert(i + 1 < Shards);
+
+	Shard & left = this->shards[i];
+	Shard & right = this->shards[i + 1];
+
+	// Always lock from left to right
+	std::unique_lock<std::mutex> left_lock(left.mutex);
+	std::unique_lock<std::mutex> right_lock(right.mutex);
+
+	size_t target = std::min(get_target(left.count, right.count),
+	                         left.count + right.count);
+	Key split_key;
+	size_t moved = 0;
+
+	if (left.count > target) {
+		// Move the largest elements of the left shard to the right. Find the
+		// first element to move by walking backwards from the end.
+		auto it = left.t.rbegin();
+		for (size_t skip = 1; skip < left.count - target; ++skip) {
+			++it;
+		}
+		split_key = KeyOf::get_key(*it);
+
+		// Elements equal to split_key before it move as well
+		for (auto lb = left.t.lower_bound(split_key); lb != left.t.end(); ++lb) {
+			moved++;
+		}
+		if (moved == left.count) {
+			// Can't move the splitter below the smallest key
+			return;
+		}
+
+		Tree moving;
+		left.t.split(split_key, moving);
+		moving.join(right.t);
+		right.t.join(moving);
+
+		left.count -= moved;
+		right.count += moved;
+	} else if (left.count < target) {
+		// Move the smallest elements of the right shard to the left. Find the
+		// first element to keep by walking forward from the beginning. At least
+		// one element must be kept to serve as new splitter.
+		size_t wanted = std::min(target - left.count, right.count - 1);
+		auto it = right.t.begin();
+		for (size_t skip = 0; skip < wanted; ++skip) {
+			++it;
+		}
+		split_key = KeyOf::get_key(*it);
+
+		// Elements equal to split_key before it are kept as well
+		for (auto lb = right.t.begin();
+		     (lb != right.t.end()) && this->cmp(*lb, split_key); ++lb) {
+			moved++;
+		}
+		if (moved == 0) {
+			return;
+		}
+
+		Tree rest;
+		right.t.split(split_key, rest);
+		left.t.join(right.t);
+		right.t.join(rest);
+
+		left.count += moved;
+		right.count -= moved;
+	} else {
+		return;
+	}
+
+	left.upper = split_key;
+	right.lower = split_key;
+
+	// Operations that routed with the old splitter will notice the changed
+	// bounds and retry.
+	std::unique_lock<std::shared_timed_mutex> routing_lock(this->routing_mutex);
+	this->splitters[i] = split_key;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+void
+ShardedTree<Tree, Shards, KeyOf>::rebalance(size_t i)
+{
+	this->shift(i, [](size_t left_count, size_t right_count) {
+		return (left_count + right_count) / 2;
+	});
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+void
+ShardedTree<Tree, Shards, KeyOf>::rebalance()
+{
+	size_t average = this->size() / Shards;
+
+	// The first sweep pushes surplus elements to the right, the second one
+	// pushes them to the left. Afterwards, every shard holds about the average
+	// number of elements (unless there were concurrent modifications).
+	for (size_t i = 0; i + 1 < Shards; ++i) {
+		this->shift(i, [&](size_t left_count, size_t right_count) {
+			(void)left_count;
+			(void)right_count;
+			return average;
+		});
+	}
+	for (size_t i = Shards - 1; i > 0; --i) {
+		this->shift(i - 1, [&](size_t left_count, size_t right_count) {
+			size_t pair_count = left_count + right_count;
+			return (pair_count > average) ? pair_count - average : 0;
+		});
+	}
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+size_t
+ShardedTree<Tree, Shards, KeyOf>::shard_size(size_t i)
+{
+	std::lock_guard<std::mutex> guard(this->shards[i].mutex);
+	return this->shards[i].count;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+size_t
+ShardedTree<Tree, Shards, KeyOf>::size()
+{
+	size_t sum = 0;
+	for (size_t i = 0; i < Shards; ++i) {
+		sum += this->shard_size(i);
+	}
+	return sum;
+}
+
+template <class Tree, size_t Shards, class KeyOf>
+typename ShardedTree<Tree, Shards, KeyOf>::Splitters
+ShardedTree<Tree, Shards, KeyOf>::get_splitters()
+{
+	std::shared_lock<std::shared_timed_mutex> guard(this->routing_mutex);
+	return this->splitters;
+}
+
+} // namespace ygg
+
+#endif // YGG_SHARDED_TREE_CPP
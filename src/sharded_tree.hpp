@@ -0,0 +1,238 @@
+#ifndef YGG_SHARDED_TREE_HPP
+#define YGG_SHARDED_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+#include "rbtree.hpp"
+#include "ziptree.hpp"
+
+namespace ygg {
+
+namespace sharded_internal {
+/// @cond INTERNAL
+
+/*
+ * Extracts the node and compare classes from the supported tree classes.
+ */
+template <class Tree>
+struct TreeTypes;
+
+template <class Node_, class NodeTraits, class Options, class Tag,
+          class Compare_>
+struct TreeTypes<RBTree<Node_, NodeTraits, Options, Tag, Compare_>>
+{
+	using Node = Node_;
+	using Compare = Compare_;
+};
+
+template <class Node_, class NodeTraits, class Options, class Tag,
+          class Compare_, class RankGetter>
+struct TreeTypes<ZTree<Node_, NodeTraits, Options, Tag, Compare_, RankGetter>>
+{
+	using Node = Node_;
+	using Compare = Compare_;
+};
+
+/// @endcond
+} // namespace sharded_internal
+
+/**
+ * @brief An ordered container that partitions its elements across multiple
+ * independently locked trees
+ *
+ * The key space is partitioned into <Shards> consecutive ranges by
+ * <Shards> - 1 splitter keys. Every range is stored in its own tree (a
+ * "shard"), which is protected by its own mutex. Operations on different
+ * shards do not block each other, so this scales with the number of threads as
+ * long as the accesses are spread over the key space.
+ *
+ * Elements can be iterated in order across all shards via for_each(), and
+ * lower_bound() continues into the following shards if necessary.
+ *
+ * If the shards become unbalanced, rebalance() moves key ranges between
+ * neighboring shards using the trees' split() and join(). Only the two shards
+ * involved are locked while doing so. All other shards remain fully usable.
+ *
+ * @warning Nodes are not copied. As for the underlying trees, nodes may not
+ * move in memory while they are in the container. Pointers returned by
+ * find() and lower_bound() may be invalidated by concurrent removals.
+ *
+ * @tparam Tree     The tree class used for the shards. Must be an RBTree or a
+ * ZTree.
+ * @tparam Shards   The number of shards
+ * @tparam KeyOf    A class providing a static method get_key(const Node &),
+ * which returns the key of a node. The splitters are stored as keys. The
+ * tree's Compare must be able to compare keys to nodes and to other keys.
+ */
+template <class Tree, size_t Shards, class KeyOf>
+class ShardedTree {
+public:
+	static_assert(Shards > 0, "At least one shard is needed.");
+
+	using Node = typename sharded_internal::TreeTypes<Tree>::Node;
+	using Compare = typename sharded_internal::TreeTypes<Tree>::Compare;
+	using Key = typename std::decay<decltype(
+	    KeyOf::get_key(std::declval<const Node &>()))>::type;
+	using Splitters = std::array<Key, Shards - 1>;
+
+	/**
+	 * @brief Creates an empty container with the given initial splitters
+	 *
+	 * Shard i holds the elements that are not less than splitters[i - 1] and
+	 * less than splitters[i].
+	 *
+	 * @param splitters   The splitter keys, sorted ascendingly
+	 */
+	explicit ShardedTree(const Splitters & splitters);
+
+	/**
+	 * @brief Inserts <node>
+	 *
+	 * Locks only the shard that <node> belongs to.
+	 *
+	 * @param node  The node to be inserted
+	 */
+	void insert(Node & node);
+
+	/**
+	 * @brief Removes <node>
+	 *
+	 * Locks only the shard that <node> belongs to.
+	 *
+	 * @param node  The node to be removed. Must be in the container.
+	 */
+	void remove(Node & node);
+
+	/**
+	 * @brief Finds an element
+	 *
+	 * See RBTree::find(). The Compare class must be able to compare <query> to
+	 * keys as well.
+	 *
+	 * @param query An object comparing equally to the element that should be
+	 * found.
+	 * @returns A pointer to the found element, or nullptr if no such element
+	 * exists
+	 */
+	template <class Comparable>
+	Node * find(const Comparable & query);
+
+	/**
+	 * @brief Lower-bounds an element across all shards
+	 *
+	 * See RBTree::lower_bound(). If the shard that <query> belongs to contains
+	 * no element that is not less than <query>, the following shards are
+	 * searched. The Compare class must be able to compare <query> to keys as
+	 * well.
+	 *
+	 * @param query An object comparable to Node that should be lower-bounded
+	 * @returns A pointer to the first element not less than <query>, or nullptr
+	 * if no such element exists
+	 */
+	template <class Comparable>
+	Node * lower_bound(const Comparable & query);
+
+	/**
+	 * @brief Calls <f> on every element, in order
+	 *
+	 * Only one shard is locked at any time. Elements are visited in ascending
+	 * order, and every element that is in the container during the whole
+	 * iteration is visited exactly once, even if key ranges are moved between
+	 * shards concurrently.
+	 *
+	 * @warning <f> is called while a shard is locked. It must not access this
+	 * container.
+	 *
+	 * @param f   A callable taking a Node &
+	 */
+	template <class Func>
+	void for_each(Func && f);
+
+	/**
+	 * @brief Evens out the sizes of all shards
+	 *
+	 * Sweeps over all pairs of neighboring shards twice (left to right and
+	 * right to left), moving key ranges such that every shard ends up with
+	 * about the average number of elements. Only two shards are locked at any
+	 * time, see rebalance(size_t).
+	 */
+	void rebalance();
+
+	/**
+	 * @brief Evens out the sizes of shards <i> and <i> + 1
+	 *
+	 * Moves the splitter between the two shards such that both contain (about)
+	 * the same number of elements. The elements are moved by splitting one tree
+	 * and joining the split-off part to the other tree. Both shards are locked
+	 * during this, which takes time linear in the number of moved elements
+	 * (which need to be counted). If the shards' trees have CONSTANT_TIME_SIZE
+	 * but not ORDER_STATISTICS set, the split additionally recounts the smaller
+	 * of the two halves, see RBTree::split(). Elements comparing equally are
+	 * never separated.
+	 *
+	 * @param i   The index of the left one of the two shards
+	 */
+	void rebalance(size_t i);
+
+	/**
+	 * Returns the number of elements in shard <i>.
+	 */
+	size_t shard_size(size_t i);
+
+	/**
+	 * Returns the number of elements in all shards.
+	 */
+	size_t size();
+
+	/**
+	 * Returns the current splitter keys.
+	 */
+	Splitters get_splitters();
+
+private:
+	struct alignas(64) Shard
+	{
+		std::mutex mutex;
+		Tree t;
+		size_t count = 0;
+		// Authoritative bounds of this shard. Only valid if the shard has a
+		// predecessor / successor.
+		Key lower;
+		Key upper;
+	};
+
+	std::array<Shard, Shards> shards;
+
+	// The routing table is only a hint. A stale routing table causes a retry.
+	Splitters splitters;
+	std::shared_timed_mutex routing_mutex;
+
+	Compare cmp;
+
+	template <class Comparable>
+	size_t route(const Comparable & query);
+	template <class Comparable>
+	bool contains(size_t i, const Comparable & query) const;
+	template <class Comparable>
+	size_t lock_shard_for(const Comparable & query,
+	                      std::unique_lock<std::mutex> & lock);
+
+	// Moves elements between shards <i> and <i> + 1 such that shard <i> holds
+	// (about) get_target(left_count, right_count) elements.
+	template <class Target>
+	void shift(size_t i, Target && get_target);
+
+};
+
+} // namespace ygg
+
+#include "sharded_tree.cpp"
+
+#endif // YGG_SHARDED_TREE_HPP
@@ -20,6 +20,12 @@ public:
     this->n += i;
   }
 
+  void
+  add(const SizeHolder<true> & other)
+  {
+    this->n += other.n;
+  }
+
   void
   reduce(size_t i)
   {
@@ -51,6 +57,12 @@ public:
     (void)i;
   }
 
+  void
+  add(const SizeHolder<false> & other)
+  {
+    (void)other;
+  }
+
   void
   reduce(size_t i)
   {
@@ -70,6 +70,129 @@ IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::step_back()
   }
 }
 
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+void
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::advance(
+    size_t steps, bool forward, std::false_type)
+{
+  for (size_t i = 0; i < steps; ++i) {
+    if (forward) {
+      this->step_forward();
+    } else {
+      this->step_back();
+    }
+  }
+}
+
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+void
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::advance(
+    size_t steps, bool forward, std::true_type)
+{
+  if (forward) {
+    this->jump_forward(steps);
+  } else {
+    this->jump_back(steps);
+  }
+}
+
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+void
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::descend_to_index(
+    size_t index)
+{
+  // Find the node at position <index> within the subtree below this->n
+  while (true) {
+    size_t left_size =
+        NodeInterface::get_subtree_size(NodeInterface::get_left(this->n));
+    if (index < left_size) {
+      this->n = NodeInterface::get_left(this->n);
+    } else if (index == left_size) {
+      return;
+    } else {
+      index -= left_size + 1;
+      this->n = NodeInterface::get_right(this->n);
+    }
+  }
+}
+
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+void
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::jump_forward(
+    size_t steps)
+{
+  while ((steps > 0) && (this->n != nullptr)) {
+    size_t right_size =
+        NodeInterface::get_subtree_size(NodeInterface::get_right(this->n));
+    if (steps <= right_size) {
+      // target is in the right subtree
+      this->n = NodeInterface::get_right(this->n);
+      this->descend_to_index(steps - 1);
+      return;
+    }
+
+    // skip the right subtree and go up to the next larger node
+    steps -= right_size + 1;
+    while ((NodeInterface::get_parent(this->n) != nullptr) &&
+           (NodeInterface::get_right(NodeInterface::get_parent(this->n)) ==
+            this->n)) {
+      this->n = NodeInterface::get_parent(this->n);
+    }
+    this->n = NodeInterface::get_parent(this->n);
+  }
+}
+
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+void
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::jump_back(
+    size_t steps)
+{
+  while ((steps > 0) && (this->n != nullptr)) {
+    size_t left_size =
+        NodeInterface::get_subtree_size(NodeInterface::get_left(this->n));
+    if (steps <= left_size) {
+      // target is in the left subtree
+      this->n = NodeInterface::get_left(this->n);
+      this->descend_to_index(left_size - steps);
+      return;
+    }
+
+    // skip the left subtree and go up to the next smaller node
+    steps -= left_size + 1;
+    while ((NodeInterface::get_parent(this->n) != nullptr) &&
+           (NodeInterface::get_left(NodeInterface::get_parent(this->n)) ==
+            this->n)) {
+      this->n = NodeInterface::get_parent(this->n);
+    }
+    this->n = NodeInterface::get_parent(this->n);
+  }
+}
+
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+size_t
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::get_position()
+    const
+{
+  // Position in key order
+  size_t rank = NodeInterface::get_subtree_size(NodeInterface::get_left(this->n));
+  Node * cur = this->n;
+  while (NodeInterface::get_parent(cur) != nullptr) {
+    if (NodeInterface::get_right(NodeInterface::get_parent(cur)) == cur) {
+      rank += NodeInterface::get_subtree_size(
+                  NodeInterface::get_left(NodeInterface::get_parent(cur))) +
+              1;
+    }
+    cur = NodeInterface::get_parent(cur);
+  }
+
+  // TODO constexpr - if
+  if (reverse) {
+    return NodeInterface::get_subtree_size(cur) - 1 - rank;
+  } else {
+    return rank;
+  }
+}
+
 template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
 IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::IteratorBase()
     : n(nullptr)
@@ -164,9 +287,8 @@ ConcreteIterator &
 IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::
 operator+=(size_t steps)
 {
-  for (size_t i = 0; i < steps; ++i) {
-    this->operator++();
-  }
+  this->advance(steps, !reverse,
+                std::integral_constant<bool, NodeInterface::subtree_sizes>{});
 
   return (*(static_cast<ConcreteIterator *>(this)));
 }
@@ -186,9 +308,8 @@ ConcreteIterator &
 IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::
 operator-=(size_t steps)
 {
-  for (size_t i = 0; i < steps; ++i) {
-    this->operator--();
-  }
+  this->advance(steps, reverse,
+                std::integral_constant<bool, NodeInterface::subtree_sizes>{});
 
   return (*(static_cast<ConcreteIterator *>(this)));
 }
@@ -203,6 +324,42 @@ operator-(size_t steps) const
   return cpy;
 }
 
+template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
+typename IteratorBase<ConcreteIterator, Node, NodeInterface,
+                      reverse>::difference_type
+IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::
+operator-(const ConcreteIterator & other) const
+{
+  static_assert(NodeInterface::subtree_sizes,
+                "Iterator distances require subtree sizes.");
+
+  if (this->n == other.n) {
+    return 0;
+  }
+
+  // The end() iterator is at the position after the last element, which
+  // is the size of the tree
+  if (this->n == nullptr) {
+    const Node * root = other.n;
+    while (NodeInterface::get_parent(root) != nullptr) {
+      root = NodeInterface::get_parent(root);
+    }
+    return static_cast<difference_type>(
+        NodeInterface::get_subtree_size(root) - other.get_position());
+  }
+  if (other.n == nullptr) {
+    const Node * root = this->n;
+    while (NodeInterface::get_parent(root) != nullptr) {
+      root = NodeInterface::get_parent(root);
+    }
+    return -static_cast<difference_type>(
+        NodeInterface::get_subtree_size(root) - this->get_position());
+  }
+
+  return static_cast<difference_type>(this->get_position()) -
+         static_cast<difference_type>(other.get_position());
+}
+
 template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
 typename IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::reference
     IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>::
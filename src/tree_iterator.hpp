@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <iterator>
+#include <type_traits>
 
 namespace ygg {
 namespace internal {
@@ -17,6 +18,11 @@ namespace internal {
  *
  * *Warning*: For efficiency reasons, it is currently not possible to
  * decrement the end() iterator!
+ *
+ * If the tree maintains subtree sizes (i.e., NodeInterface::subtree_sizes is
+ * true), advancing the iterator by k steps as well as computing the distance
+ * between two iterators takes O(log n) time. Otherwise, advancing by k steps
+ * takes O(k) time and the distance between two iterators is not available.
  */
 template <class ConcreteIterator, class Node, class NodeInterface, bool reverse>
 class IteratorBase {
@@ -47,6 +53,7 @@ public:
   ConcreteIterator operator--(int);
   ConcreteIterator & operator-=(size_t steps);
   ConcreteIterator operator-(size_t steps) const;
+  difference_type operator-(const ConcreteIterator & other) const;
 
   reference operator*() const;
   pointer operator->() const;
@@ -90,6 +97,22 @@ protected:
   void step_forward();
   void step_back();
 
+  /*
+   * Going forwards / backwards by multiple steps. If the nodes know their
+   * subtree sizes, this is done in O(log n), otherwise by stepping repeatedly.
+   */
+  void advance(size_t steps, bool forward, std::true_type);
+  void advance(size_t steps, bool forward, std::false_type);
+  void jump_forward(size_t steps);
+  void jump_back(size_t steps);
+  void descend_to_index(size_t index);
+
+  /*
+   * Position of the iterator in iteration order, with end() being at
+   * position n. Requires subtree sizes.
+   */
+  size_t get_position() const;
+
   Node * n;
 
   using my_type = IteratorBase<ConcreteIterator, Node, NodeInterface, reverse>;
@@ -96,14 +96,14 @@ public:
 	constexpr static std::size_t value = found ? type::value : DEFAULT;
 };
 
-template <template <class> class TMPL, class Default>
+template <template <class...> class TMPL, class Default>
 constexpr auto
 get_type_if_present_func()
 {
 	return TypeHolder<Default>{};
 }
 
-template <template <class> class TMPL, class Default, class T, class... Rest>
+template <template <class...> class TMPL, class Default, class T, class... Rest>
 constexpr auto get_type_if_present_func(
     typename std::enable_if<is_specialization<T, TMPL>{}, bool>::type dummy =
         true)
@@ -112,7 +112,7 @@ constexpr auto get_type_if_present_func(
 	return TypeHolder<T>{};
 }
 
-template <template <class> class TMPL, class Default, class T, class... Rest>
+template <template <class...> class TMPL, class Default, class T, class... Rest>
 constexpr auto get_type_if_present_func(
     typename std::enable_if<!is_specialization<T, TMPL>{}, bool>::type dummy =
         true)
@@ -121,7 +121,7 @@ constexpr auto get_type_if_present_func(
 	return get_type_if_present_func<TMPL, Default, Rest...>();
 }
 
-template <template <class> class TMPL, class Default, class... Ts>
+template <template <class...> class TMPL, class Default, class... Ts>
 class get_type_if_present {
 public:
 	using type =
@@ -146,6 +146,24 @@ any_of()
 	return false;
 }
 
+/* @brief Dereferences either a node or a pointer to a node
+ *
+ * Bulk operations accept ranges of nodes as well as ranges of node pointers.
+ */
+template <class Node>
+Node &
+deref_node(Node & n)
+{
+	return n;
+}
+
+template <class Node>
+Node &
+deref_node(Node * n)
+{
+	return *n;
+}
+
 /* @brief A class providing an iterator over the integers 1, 2, … <n>
  */
 // TODO this does not uphold the multipass guarantee (point 1). Check how boost
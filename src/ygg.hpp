@@ -1,7 +1,15 @@
+#include "async_search.hpp"
+#include "btree.hpp"
+#include "concurrent_ziptree.hpp"
 #include "dynamic_segment_tree.hpp"
+#include "interval_snapshot.hpp"
 #include "intervalmap.hpp"
 #include "intervaltree.hpp"
 #include "list.hpp"
+#include "node_pool.hpp"
 #include "options.hpp"
 #include "rbtree.hpp"
+#include "search_snapshot.hpp"
+#include "seqlock_tree.hpp"
+#include "sharded_tree.hpp"
 #include "ziptree.hpp"
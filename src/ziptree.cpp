@@ -38,6 +38,7 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::ZTree(
 	this->root = other.root;
 	other.root = nullptr;
 	this->s = other.s;
+	this->rank_source = other.rank_source;
 }
 
 template <class Node, class NodeTraits, class Options, class Tag, class Compare,
@@ -49,6 +50,7 @@ operator=(MyClass && other)
 	this->root = other.root;
 	other.root = nullptr;
 	this->s = other.s;
+	this->rank_source = other.rank_source;
 }
 
 template <class Node, class NodeTraits, class Options, class Tag, class Compare,
@@ -90,6 +92,9 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::insert(
 	node._zt_left = nullptr;
 	node._zt_right = nullptr;
 
+	this->rank_source.assign(node);
+	CachedKeys::fill(node);
+
 	// First, search for insertion position.
 	auto node_rank = RankGetter::get_rank(node);
 	this->s.add(1);
@@ -97,6 +102,7 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::insert(
 	// TODO this should be handled by the code below
 	if (this->root == nullptr) {
 		this->root = &node;
+		SubtreeSizes::fix(&node);
 		return;
 	}
 
@@ -149,12 +155,85 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::insert(
 			current->_zt_right = &node;
 		}
 
+		SubtreeSizes::add_on_path(current);
 		if (old_node != nullptr) {
 			this->unzip(*old_node, node);
+		} else {
+			SubtreeSizes::fix(&node);
 		}
 	}
 }
 
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class InputIt>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::build_from_sorted(
+    InputIt begin, InputIt end) noexcept
+{
+	NodeTraits traits;
+
+	this->root = nullptr;
+	this->s.set(0);
+
+	// This is the stack-based construction of a cartesian tree. The stack is
+	// always the right spine of the tree built so far, thus we can walk it via
+	// the parent pointers instead of storing it explicitly.
+	Node * last = nullptr;
+	for (InputIt it = begin; it != end; ++it) {
+		Node & node = utilities::deref_node<Node>(*it);
+		CachedKeys::fill(node);
+		// TODO constexpr - if
+		if (Options::ztree_fast_random) {
+			size_t min_rank = 0;
+			if ((last != nullptr) && !this->cmp(*last, node)) {
+				// Equal elements must be sorted by ascending rank
+				min_rank = RankGetter::get_rank(*last);
+			}
+			this->rank_source.assign(node, min_rank);
+		}
+		auto node_rank = RankGetter::get_rank(node);
+		this->s.add(1);
+
+		assert((last == nullptr) || !this->cmp(node, *last));
+		assert((last == nullptr) || this->cmp(*last, node) ||
+		       (RankGetter::get_rank(*last) <= node_rank));
+
+		// Everything on the spine that ranks at most as high as the new node
+		// becomes the new node's left subtree. These nodes are done.
+		Node * cur = last;
+		Node * below = nullptr;
+		while ((cur != nullptr) && (RankGetter::get_rank(*cur) <= node_rank)) {
+			SubtreeSizes::fix(cur);
+			traits.rebuilt(cur);
+			below = cur;
+			cur = cur->NB::_zt_parent;
+		}
+
+		node.NB::_zt_left = below;
+		node.NB::_zt_right = nullptr;
+		if (below != nullptr) {
+			below->NB::_zt_parent = &node;
+		}
+
+		node.NB::_zt_parent = cur;
+		if (cur != nullptr) {
+			cur->NB::_zt_right = &node;
+		} else {
+			this->root = &node;
+		}
+
+		last = &node;
+	}
+
+	// Whatever is left on the spine is done now.
+	while (last != nullptr) {
+		SubtreeSizes::fix(last);
+		traits.rebuilt(last);
+		last = last->NB::_zt_parent;
+	}
+}
+
 template <class Node, class NodeTraits, class Options, class Tag, class Compare,
           class RankGetter>
 void
@@ -388,6 +467,11 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::unzip(
 		right_head->_zt_right = nullptr;
 	}
 
+	// The nodes on both spines have lost parts of their subtrees
+	SubtreeSizes::fix_path(left_head, &newn);
+	SubtreeSizes::fix_path(right_head, &newn);
+	SubtreeSizes::fix(&newn);
+
 	traits.unzip_done(&newn, left_head, right_head);
 } // namespace ygg
 
@@ -415,6 +499,8 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::zip(
 
 	Node * cur = old_root._zt_parent;
 
+	SubtreeSizes::reduce_on_path(cur);
+
 	bool last_from_left;
 
 	// First one is special.
@@ -558,16 +644,296 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::zip(
 	if (cur == nullptr) {
 		cur = new_head;
 	}
+
+	// All nodes on the zipped path have received new subtrees
+	SubtreeSizes::fix_path(cur, new_head->_zt_parent);
+
 	traits.zipping_done(new_head, cur);
 }
 
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class Comparable>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::split(
+    const Comparable & key, MyClass & right) noexcept
+{
+	this->split_uncounted(key, right);
+
+	this->count_after_split(
+	    right, std::integral_constant<bool, Options::constant_time_size>{});
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class Comparable>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::split_uncounted(
+    const Comparable & key, MyClass & right) noexcept
+{
+	right.clear();
+
+	// Find the largest node that stays in this tree
+	const auto & q = CachedKeys::query(key);
+	Node * pivot = nullptr;
+	Node * cur = this->root;
+	while (cur != nullptr) {
+		if (this->cmp(*cur, q)) {
+			pivot = cur;
+			cur = cur->NB::_zt_right;
+		} else {
+			cur = cur->NB::_zt_left;
+		}
+	}
+
+	if (pivot == nullptr) {
+		// Everything moves to the right
+		right.root = this->root;
+		right.s = this->s;
+		this->clear();
+		return;
+	}
+
+	this->remove(*pivot);
+
+	if (this->root != nullptr) {
+		// Unzip the tree at the pivot as if it was inserted as new root
+		pivot->NB::_zt_parent = nullptr;
+		pivot->NB::_zt_left = nullptr;
+		pivot->NB::_zt_right = nullptr;
+		this->unzip(*this->root, *pivot);
+
+		Node * left_root = pivot->NB::_zt_left;
+		Node * right_root = pivot->NB::_zt_right;
+		if (left_root != nullptr) {
+			left_root->NB::_zt_parent = nullptr;
+		}
+		if (right_root != nullptr) {
+			right_root->NB::_zt_parent = nullptr;
+		}
+
+		this->root = left_root;
+		right.root = right_root;
+	}
+
+	this->insert(*pivot);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class Comparable1, class Comparable2>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::detach_range(
+    const Comparable1 & lower, const Comparable2 & upper,
+    MyClass & range) noexcept
+{
+	// Counting after the splits would take time linear in the size of the
+	// smaller part. The caller fixes the size instead.
+	MyClass right;
+	this->split_uncounted(lower, range);
+	range.split_uncounted(upper, right);
+	this->join(right);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class Comparable1, class Comparable2>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::erase_range(
+    const Comparable1 & lower, const Comparable2 & upper) noexcept
+{
+	auto size_before = this->s;
+	MyClass range;
+	this->detach_range(lower, upper, range);
+
+	size_t count = 0;
+	for (auto it = range.begin(); it != range.end(); ++it) {
+		count++;
+	}
+	this->s = size_before;
+	this->s.reduce(count);
+	range.clear();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+template <class Comparable1, class Comparable2, class OutList>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::extract_range(
+    const Comparable1 & lower, const Comparable2 & upper,
+    OutList & out) noexcept
+{
+	auto size_before = this->s;
+	MyClass range;
+	this->detach_range(lower, upper, range);
+
+	size_t count = 0;
+	for (auto it = range.begin(); it != range.end(); ++it) {
+		out.insert(nullptr, &*it);
+		count++;
+	}
+	this->s = size_before;
+	this->s.reduce(count);
+	range.clear();
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::count_after_split(
+    MyClass & right, std::true_type) noexcept
+{
+	// TODO constexpr - if
+	if (Options::order_statistics) {
+		this->s.set(SubtreeSizes::get(this->root));
+		right.s.set(SubtreeSizes::get(right.root));
+		return;
+	}
+
+	// Count the smaller tree only. Before counting, the total may be stored in
+	// either tree.
+	size_t total = this->s.get() + right.s.get();
+	size_t count = 0;
+	auto left_it = this->begin();
+	auto right_it = right.begin();
+	while ((left_it != this->end()) && (right_it != right.end())) {
+		++left_it;
+		++right_it;
+		count++;
+	}
+
+	if (left_it == this->end()) {
+		this->s.set(count);
+		right.s.set(total - count);
+	} else {
+		right.s.set(count);
+		this->s.set(total - count);
+	}
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::count_after_split(
+    MyClass & right, std::false_type) noexcept
+{
+	(void)right;
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::join(
+    MyClass & other) noexcept
+{
+	if (other.root == nullptr) {
+		return;
+	}
+
+	if (this->root == nullptr) {
+		this->root = other.root;
+		this->s = other.s;
+		other.clear();
+		return;
+	}
+
+	Node * pivot = other.get_smallest();
+	other.remove(*pivot);
+
+	// Hang both trees below the pivot, then zip them by removing the pivot
+	pivot->NB::_zt_parent = nullptr;
+	pivot->NB::_zt_left = this->root;
+	pivot->NB::_zt_right = other.root;
+	this->root->NB::_zt_parent = pivot;
+	if (other.root != nullptr) {
+		other.root->NB::_zt_parent = pivot;
+	}
+	this->root = pivot;
+
+	this->zip(*pivot);
+
+	this->s.add(other.s);
+	other.clear();
+
+	this->insert(*pivot);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+void
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::seed_ranks(
+    uint64_t seed) noexcept
+{
+	static_assert(Options::ztree_fast_random,
+	              "seed_ranks() requires ZTREE_FAST_RANDOM to be set.");
+
+	this->rank_source.seed(seed);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+typename ZTree<Node, NodeTraits, Options, Tag, Compare,
+               RankGetter>::template iterator<false>
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::select(size_t k)
+{
+	static_assert(Options::order_statistics,
+	              "select() requires ORDER_STATISTICS to be set.");
+
+	Node * cur = this->root;
+	while (cur != nullptr) {
+		size_t left_size = SubtreeSizes::get(cur->NB::_zt_left);
+		if (k < left_size) {
+			cur = cur->NB::_zt_left;
+		} else if (k == left_size) {
+			break;
+		} else {
+			k -= left_size + 1;
+			cur = cur->NB::_zt_right;
+		}
+	}
+
+	return iterator<false>(cur);
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+typename ZTree<Node, NodeTraits, Options, Tag, Compare,
+               RankGetter>::template const_iterator<false>
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::select(
+    size_t k) const
+{
+	return const_iterator<false>(const_cast<MyClass *>(this)->select(k));
+}
+
+template <class Node, class NodeTraits, class Options, class Tag, class Compare,
+          class RankGetter>
+size_t
+ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::rank(
+    const Node & node) const
+{
+	static_assert(Options::order_statistics,
+	              "rank() requires ORDER_STATISTICS to be set.");
+
+	const Node * cur = &node;
+	size_t position = SubtreeSizes::get(cur->NB::_zt_left);
+	while (cur->NB::_zt_parent != nullptr) {
+		const Node * parent = cur->NB::_zt_parent;
+		if (parent->NB::_zt_right == cur) {
+			position += SubtreeSizes::get(parent->NB::_zt_left) + 1;
+		}
+		cur = parent;
+	}
+
+	return position;
+}
+
 template <class Node, class NodeTraits, class Options, class Tag, class Compare,
           class RankGetter>
 void
 ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::dbg_verify() const
 {
 	if (this->root != nullptr) {
-		assert(this->root->get_parent() == nullptr);
+		assert(this->root->NB::get_parent() == nullptr);
 	}
 
 	this->dbg_verify_consistency(this->root, nullptr, nullptr);
@@ -612,6 +978,7 @@ ZTree<Node, NodeTraits, Options, Tag, Compare,
 	}
 
 	assert(sub_root->_zt_parent != sub_root);
+	assert(SubtreeSizes::verify(sub_root));
 
 	if (lower_bound_node != nullptr) {
 		assert(this->cmp(*lower_bound_node, *sub_root));
@@ -712,11 +1079,12 @@ typename ZTree<Node, NodeTraits, Options, Tag, Compare,
 ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::lower_bound(
     const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(*cur, query)) {
+		if (this->cmp(*cur, q)) {
 			cur = cur->NB::_zt_right;
 		} else {
 			last_left = cur;
@@ -739,11 +1107,12 @@ typename ZTree<Node, NodeTraits, Options, Tag, Compare,
 ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::upper_bound(
     const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(query, *cur)) {
+		if (this->cmp(q, *cur)) {
 			last_left = cur;
 			cur = cur->_zt_left;
 		} else {
@@ -794,11 +1163,12 @@ typename ZTree<Node, NodeTraits, Options, Tag, Compare,
 ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::find(
     const Comparable & query)
 {
+	const auto & q = CachedKeys::query(query);
 	Node * cur = this->root;
 	Node * last_left = nullptr;
 
 	while (cur != nullptr) {
-		if (this->cmp(*cur, query)) {
+		if (this->cmp(*cur, q)) {
 			cur = cur->NB::_zt_right;
 		} else {
 			last_left = cur;
@@ -806,7 +1176,7 @@ ZTree<Node, NodeTraits, Options, Tag, Compare, RankGetter>::find(
 		}
 	}
 
-	if ((last_left != nullptr) && (!this->cmp(query, *last_left))) {
+	if ((last_left != nullptr) && (!this->cmp(q, *last_left))) {
 		return iterator<false>(last_left);
 	} else {
 		return this->end();
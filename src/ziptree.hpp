@@ -1,12 +1,17 @@
 #ifndef YGG_ZIPTREE_H
 #define YGG_ZIPTREE_H
 
+#include "cached_key.hpp"
+#include "index_link.hpp"
 #include "options.hpp"
 #include "size_holder.hpp"
 #include "tree_iterator.hpp"
 
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <functional>
+#include <limits>
 
 namespace ygg {
 
@@ -48,6 +53,175 @@ struct dbg_verify_size_helper<Tree, false>
 	}
 };
 
+/*
+ * Storage for the subtree sizes if TreeFlags::ORDER_STATISTICS is set. The tag
+ * keeps the bases of nodes that live in multiple trees apart.
+ */
+template <class Tag, bool enable>
+class ZTreeSubtreeSizeStorage {
+};
+
+template <class Tag>
+class ZTreeSubtreeSizeStorage<Tag, true> {
+public:
+	size_t _zt_size = 1;
+};
+
+/*
+ * Maintenance of the subtree sizes. All of these are no-ops if
+ * TreeFlags::ORDER_STATISTICS is not set.
+ */
+template <class Node, class NB, bool enable>
+struct ZTreeSubtreeSizes;
+
+template <class Node, class NB>
+struct ZTreeSubtreeSizes<Node, NB, true>
+{
+	static size_t
+	get(const Node * n) noexcept
+	{
+		return (n == nullptr) ? 0 : n->NB::_zt_size;
+	}
+
+	static void
+	fix(Node * n) noexcept
+	{
+		n->NB::_zt_size = 1 + get(n->NB::_zt_left) + get(n->NB::_zt_right);
+	}
+
+	// Fixes all nodes on the path from <bottom> up to, but excluding, <top>
+	static void
+	fix_path(Node * bottom, const Node * top) noexcept
+	{
+		while (bottom != top) {
+			fix(bottom);
+			bottom = bottom->NB::_zt_parent;
+		}
+	}
+
+	static void
+	add_on_path(Node * n) noexcept
+	{
+		while (n != nullptr) {
+			n->NB::_zt_size++;
+			n = n->NB::_zt_parent;
+		}
+	}
+
+	static void
+	reduce_on_path(Node * n) noexcept
+	{
+		while (n != nullptr) {
+			n->NB::_zt_size--;
+			n = n->NB::_zt_parent;
+		}
+	}
+
+	static bool
+	verify(const Node * n) noexcept
+	{
+		return get(n) == 1 + get(n->NB::_zt_left) + get(n->NB::_zt_right);
+	}
+};
+
+template <class Node, class NB>
+struct ZTreeSubtreeSizes<Node, NB, false>
+{
+	static size_t
+	get(const Node * n) noexcept
+	{
+		(void)n;
+		return 0;
+	}
+
+	static void
+	fix(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	fix_path(Node * bottom, const Node * top) noexcept
+	{
+		(void)bottom;
+		(void)top;
+	}
+
+	static void
+	add_on_path(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static void
+	reduce_on_path(Node * n) noexcept
+	{
+		(void)n;
+	}
+
+	static bool
+	verify(const Node * n) noexcept
+	{
+		(void)n;
+		return true;
+	}
+};
+
+/*
+ * A small and fast pseudo-random generator (wyrand) that satisfies the
+ * UniformRandomBitGenerator requirements. Used if TreeFlags::ZTREE_FAST_RANDOM
+ * is set.
+ */
+class FastRankGenerator {
+public:
+	using result_type = uint64_t;
+
+	explicit FastRankGenerator(uint64_t seed_in) noexcept : state(seed_in) {}
+
+	void
+	seed(uint64_t seed_in) noexcept
+	{
+		this->state = seed_in;
+	}
+
+	static constexpr result_type
+	min() noexcept
+	{
+		return 0;
+	}
+
+	static constexpr result_type
+	max() noexcept
+	{
+		return std::numeric_limits<uint64_t>::max();
+	}
+
+	result_type
+	operator()() noexcept
+	{
+		this->state += 0xa0761d6478bd642full;
+		__uint128_t product = static_cast<__uint128_t>(this->state) *
+		                      (this->state ^ 0xe7037ed1a0b428dbull);
+		return static_cast<uint64_t>(product >> 64) ^
+		       static_cast<uint64_t>(product);
+	}
+
+	// Geometrically distributed, starting at 1 - the same distribution as
+	// __builtin_ffsl() of a random number.
+	unsigned int
+	draw_rank() noexcept
+	{
+		uint64_t val = (*this)();
+		if (val == 0) {
+			return 65;
+		}
+		return static_cast<unsigned int>(__builtin_ctzll(val)) + 1;
+	}
+
+private:
+	uint64_t state;
+};
+
 // TODO rename this - if use_hash is false, no hashing takes place!
 template <class Node, class Options, bool use_hash, bool store>
 class ZTreeRankFromHash;
@@ -120,8 +294,14 @@ class ZTreeRankFromHash<Node, Options, false, true> {
 public:
 	ZTreeRankFromHash()
 	{
-		auto rand_val = std::rand();
 		this->rank = 0;
+		// TODO if constexpr when switching to C++17
+		if (Options::ztree_fast_random) {
+			// The tree draws the rank upon insertion
+			return;
+		}
+
+		auto rand_val = std::rand();
 		while (rand_val == RAND_MAX) {
 			this->rank = (decltype(this->rank))(
 			    this->rank + (decltype(this->rank))std::log2(RAND_MAX));
@@ -148,6 +328,12 @@ public:
 		(void)node;
 	}
 
+	static void
+	set_rank(Node & node, size_t rank) noexcept
+	{
+		node._zt_rank.rank = (decltype(node._zt_rank.rank))rank;
+	}
+
 	static size_t
 	get_rank(const Node & node) noexcept
 	{
@@ -168,6 +354,71 @@ class ZTreeRankFromHash<Node, Options, false, false> {
 	static_assert(!std::is_class<Node>::value || std::is_class<Node>::value,
 	              "If rank-by-hash is not used, ranks must be stored.");
 };
+/*
+ * The per-tree source of random ranks if TreeFlags::ZTREE_FAST_RANDOM is set.
+ * Otherwise, nodes draw their ranks themselves.
+ */
+template <class Node, class Options, bool enable>
+class ZTreeRankSource;
+
+template <class Node, class Options>
+class ZTreeRankSource<Node, Options, true> {
+public:
+	ZTreeRankSource() noexcept : gen(fresh_seed()) {}
+
+	void
+	seed(uint64_t seed_in) noexcept
+	{
+		this->gen.seed(seed_in);
+	}
+
+	void
+	assign(Node & node, size_t min_rank = 0) noexcept
+	{
+		size_t rank = this->gen.draw_rank();
+		if (rank < min_rank) {
+			rank = min_rank;
+		}
+		ZTreeRankFromHash<Node, Options, false, true>::set_rank(node, rank);
+	}
+
+private:
+	// Every thread hands out its own sequence of seeds, without locking.
+	static uint64_t
+	fresh_seed() noexcept
+	{
+		thread_local FastRankGenerator seeder(0);
+		thread_local bool seeded = false;
+		if (!seeded) {
+			seeder.seed(
+			    static_cast<uint64_t>(
+			        std::chrono::high_resolution_clock::now().time_since_epoch().count()) ^
+			    static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&seeder)));
+			seeded = true;
+		}
+		return seeder();
+	}
+
+	FastRankGenerator gen;
+};
+
+template <class Node, class Options>
+class ZTreeRankSource<Node, Options, false> {
+public:
+	void
+	seed(uint64_t seed_in) noexcept
+	{
+		(void)seed_in;
+	}
+
+	void
+	assign(Node & node, size_t min_rank = 0) noexcept
+	{
+		(void)node;
+		(void)min_rank;
+	}
+};
+
 /// @endcond
 } // namespace ztree_internal
 
@@ -187,11 +438,17 @@ class ZTreeRankFromHash<Node, Options, false, false> {
  * be inserted into. See ZTree for details.
  */
 template <class Node, class Options, class Tag>
-class ZTreeNodeBase {
+class ZTreeNodeBase
+    : public cached_key_internal::CachedKeyStorage<
+          ZTreeNodeBase<Node, Options, Tag>, typename Options::cached_key>,
+      public ztree_internal::ZTreeSubtreeSizeStorage<Tag,
+                                                     Options::order_statistics> {
 public:
-	Node * _zt_parent = nullptr;
-	Node * _zt_left = nullptr;
-	Node * _zt_right = nullptr;
+	using Link = internal::LinkType<Node, Options>;
+
+	Link _zt_parent = nullptr;
+	Link _zt_left = nullptr;
+	Link _zt_right = nullptr;
 
 	Node *
 	get_parent() const noexcept
@@ -272,6 +529,12 @@ public:
     (void) left_spine_end;
     (void) right_spine_end;
   }
+
+  /*
+   * Callbacks for bulk operations. Called bottom-up for every node whose
+   * subtree has been linked wholesale.
+   */
+  void rebuilt(Node * n) const noexcept {(void)n;}
 	// clang-format on
 };
 
@@ -319,6 +582,10 @@ public:
 
 	static_assert(std::is_base_of<NB, Node>::value,
 	              "Node class not properly derived from node base!");
+	static_assert(!Options::ztree_fast_random ||
+	                  (Options::ztree_store_rank && !Options::ztree_use_hash),
+	              "ZTREE_FAST_RANDOM requires stored ranks that are not derived "
+	              "from hashes.");
 
 	/**
 	 * @brief Create a new Zip Tree from a different Zip Tree.
@@ -359,10 +626,25 @@ public:
 	MyClass & operator=(const MyClass & other);
 
 private:
+	using SubtreeSizes =
+	    ztree_internal::ZTreeSubtreeSizes<Node, NB, Options::order_statistics>;
+	using CachedKeys =
+	    cached_key_internal::CachedKeys<Node, NB, typename Options::cached_key,
+	                                    Compare>;
+
+public:
 	// Class to tell the abstract search tree iterator how to handle
 	// our nodes
 	class NodeInterface {
 	public:
+		static constexpr bool subtree_sizes = Options::order_statistics;
+
+		static size_t
+		get_subtree_size(const Node * n)
+		{
+			return SubtreeSizes::get(n);
+		}
+
 		static Node *
 		get_parent(Node * n)
 		{
@@ -453,6 +735,29 @@ public:
 	void insert(Node & node) noexcept;
 	void insert(Node & node, Node & hint) noexcept;
 
+	/**
+	 * @brief Builds the tree from a sorted range of nodes
+	 *
+	 * Replaces the contents of this tree with the nodes in [begin, end). The
+	 * range can either contain nodes or pointers to nodes. It must be sorted
+	 * with respect to Compare. Since elements comparing equally must form a left
+	 * path, nodes comparing equally must additionally be sorted by ascending
+	 * rank. This is automatically the case if ranks are computed from hashes.
+	 * If ZTREE_FAST_RANDOM is set, the ranks are drawn here accordingly.
+	 *
+	 * The resulting tree is the zip tree defined by the nodes' ranks. It is
+	 * constructed in O(n) time without allocating memory. The rebuilt() hook
+	 * of the NodeTraits is called once per node, bottom-up.
+	 *
+	 * The same warning as for insert() applies: The nodes may not move in memory
+	 * while they are part of the tree.
+	 *
+	 * @param begin   Iterator to the first node (or node pointer) to be added
+	 * @param end     Iterator past the last node (or node pointer) to be added
+	 */
+	template <class InputIt>
+	void build_from_sorted(InputIt begin, InputIt end) noexcept;
+
 	/**
 	 * @brief Upper-bounds an element
 	 *
@@ -624,6 +929,125 @@ public:
 
 	Node * get_root() const;
 
+	/**
+	 * @brief Returns the k-th element in the tree
+	 *
+	 * Returns an iterator to the element at (zero-based) position <k> in the
+	 * tree, or end() if there are at most <k> elements in the tree. Runs in
+	 * expected O(log n).
+	 *
+	 * @warning This method is only available if ORDER_STATISTICS is set as
+	 * option!
+	 *
+	 * @param k   The position of the element to be returned
+	 * @returns An iterator to the k-th element, or end()
+	 */
+	const_iterator<false> select(size_t k) const;
+	iterator<false> select(size_t k);
+
+	/**
+	 * @brief Returns the position of a node in the tree
+	 *
+	 * Returns the number of elements that come before <node> in the tree, i.e.,
+	 * the (zero-based) position of <node>. Runs in expected O(log n).
+	 *
+	 * @warning This method is only available if ORDER_STATISTICS is set as
+	 * option!
+	 *
+	 * @param node  The node whose position should be returned. Must be in the
+	 * tree.
+	 * @returns The position of <node>
+	 */
+	size_t rank(const Node & node) const;
+
+	/**
+	 * @brief Splits the tree at <key>
+	 *
+	 * Moves all elements that do not compare less than <key> (i.e., the range
+	 * [lower_bound(key), end()) ) into <right>. Any elements that were in
+	 * <right> before are discarded, as if clear() had been called on it.
+	 *
+	 * The split is performed by the same zipping and unzipping that insert() and
+	 * remove() use, thus the usual NodeTraits callbacks are called: The largest
+	 * element that stays in this tree is removed, unzipped into the root
+	 * position at which it separates the two halves, and then re-inserted into
+	 * the left half. This takes expected O(log n) time.
+	 *
+	 * @warning If CONSTANT_TIME_SIZE is set but ORDER_STATISTICS is not, the
+	 * sizes of the two resulting trees must be recounted by walking the smaller
+	 * one, and the split takes O(log n + min(|L|, |R|)) for the resulting trees
+	 * L and R. Set ORDER_STATISTICS as well to keep it logarithmic.
+	 *
+	 * @param key     An object comparable to Node at which to split the tree
+	 * @param right   The tree that receives the elements from <key> onwards
+	 */
+	template <class Comparable>
+	void split(const Comparable & key, MyClass & right) noexcept;
+
+	/**
+	 * @brief Appends another tree to this tree
+	 *
+	 * Moves all elements from <other> into this tree. Afterwards, <other> is
+	 * empty. The smallest element of <other> is removed from <other> and used
+	 * to hang both trees below it. Removing it again zips the right spine of this
+	 * tree with the left spine of <other>. Finally, it is re-inserted. This takes
+	 * expected O(log n) time, calling the usual NodeTraits callbacks.
+	 *
+	 * @warning No element in <other> may compare less than any element in this
+	 * tree.
+	 *
+	 * @param other   The tree whose elements should go after this tree's
+	 * elements
+	 */
+	void join(MyClass & other) noexcept;
+
+	/**
+	 * @brief Removes all elements in a range of keys
+	 *
+	 * Removes all elements that do not compare less than <lower>, but compare
+	 * less than <upper>, i.e., the range [lower_bound(lower),
+	 * lower_bound(upper)). Instead of removing the elements one by one, the
+	 * range is cut out of the tree by two splits and a join, see split() and
+	 * join(). Thus, this takes expected O(log n + k) time for k removed
+	 * elements.
+	 *
+	 * @param lower   An object comparable to Node at which the range starts
+	 * @param upper   An object comparable to Node before which the range ends.
+	 * Must not compare less than <lower>.
+	 */
+	template <class Comparable1, class Comparable2>
+	void erase_range(const Comparable1 & lower,
+	                 const Comparable2 & upper) noexcept;
+
+	/**
+	 * @brief Removes all elements in a range of keys and hands them out
+	 *
+	 * Does the same as erase_range(), but appends the removed elements, in
+	 * order, to <out>. This allows e.g. to reuse the nodes.
+	 *
+	 * @param lower   An object comparable to Node at which the range starts
+	 * @param upper   An object comparable to Node before which the range ends.
+	 * Must not compare less than <lower>.
+	 * @param out     A ygg::List over the nodes that receives the removed
+	 * elements
+	 */
+	template <class Comparable1, class Comparable2, class OutList>
+	void extract_range(const Comparable1 & lower, const Comparable2 & upper,
+	                   OutList & out) noexcept;
+
+	/**
+	 * @brief Seeds the generator that draws the ranks of inserted nodes
+	 *
+	 * Inserting the same sequence of nodes into two trees that have been seeded
+	 * equally results in the same tree shapes.
+	 *
+	 * @warning This method is only available if ZTREE_FAST_RANDOM is set as
+	 * option!
+	 *
+	 * @param seed  The seed
+	 */
+	void seed_ranks(uint64_t seed) noexcept;
+
 	/**
 	 * @brief Removes all elements from the tree.
 	 *
@@ -633,7 +1057,9 @@ public:
 
 private:
 	Node * root;
-	Compare cmp;
+	typename CachedKeys::Compare cmp;
+	ztree_internal::ZTreeRankSource<Node, Options, Options::ztree_fast_random>
+	    rank_source;
 
 	void unzip(Node & oldn, Node & newn) noexcept;
 	void zip(Node & old_root) noexcept;
@@ -641,6 +1067,14 @@ private:
 	Node * get_smallest() const;
 	Node * get_largest() const;
 
+	template <class Comparable>
+	void split_uncounted(const Comparable & key, MyClass & right) noexcept;
+	template <class Comparable1, class Comparable2>
+	void detach_range(const Comparable1 & lower, const Comparable2 & upper,
+	                  MyClass & range) noexcept;
+	void count_after_split(MyClass & right, std::true_type) noexcept;
+	void count_after_split(MyClass & right, std::false_type) noexcept;
+
 	// Debugging methods
 	void dbg_verify_consistency(Node * sub_root, Node * lower_bound,
 	                            Node * upper_bound) const;
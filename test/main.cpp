@@ -1,11 +1,19 @@
 #include <gtest/gtest.h>
 
+#include "test_async_search.hpp"
+#include "test_btree.hpp"
+#include "test_concurrent_ziptree.hpp"
 #include "test_dynamic_segment_tree.hpp"
+#include "test_interval_snapshot.hpp"
 #include "test_intervalmap.hpp"
 #include "test_intervaltree.hpp"
 #include "test_list.hpp"
 #include "test_multi_rbtree.hpp"
+#include "test_node_pool.hpp"
 #include "test_rbtree.hpp"
+#include "test_search_snapshot.hpp"
+#include "test_seqlock_tree.hpp"
+#include "test_sharded_tree.hpp"
 #include "test_ziptree.hpp"
 
 //#include "test_orderlist.hpp"
@@ -0,0 +1,206 @@
+#ifndef TEST_ASYNC_SEARCH_HPP
+#define TEST_ASYNC_SEARCH_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/async_search.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace async_search {
+
+using namespace ygg;
+
+constexpr int ASYNC_TESTSIZE = 2000;
+
+using AsyncZTreeOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::ZTREE_RANK_TYPE<int>>;
+
+class Node : public RBTreeNodeBase<Node, TreeOptions<TreeFlags::MULTIPLE>>,
+             public ZTreeNodeBase<Node, AsyncZTreeOptions> {
+public:
+	int data;
+	int rank;
+
+	Node() : data(0), rank(0){};
+	Node(int data_in, int rank_in) : data(data_in), rank(rank_in){};
+
+	bool
+	operator<(const Node & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const Node & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const Node & rhs)
+{
+	return lhs < rhs.data;
+}
+
+class RankGetter {
+public:
+	static int
+	get_rank(const Node & n)
+	{
+		return n.rank;
+	}
+};
+
+using Interval = std::pair<unsigned int, unsigned int>;
+
+template <class INode>
+class ITNodeTraits : public ITreeNodeTraits<INode> {
+public:
+	using key_type = unsigned int;
+
+	static unsigned int
+	get_lower(const INode & node)
+	{
+		return node.lower;
+	}
+	static unsigned int
+	get_upper(const INode & node)
+	{
+		return node.upper;
+	}
+	static unsigned int
+	get_lower(const Interval & i)
+	{
+		return std::get<0>(i);
+	}
+	static unsigned int
+	get_upper(const Interval & i)
+	{
+		return std::get<1>(i);
+	}
+};
+
+class ITNode : public ITreeNodeBase<ITNode, ITNodeTraits<ITNode>> {
+public:
+	unsigned int lower;
+	unsigned int upper;
+
+	ITNode() : lower(0), upper(0){};
+	ITNode(unsigned int lower_in, unsigned int upper_in)
+	    : lower(lower_in), upper(upper_in){};
+};
+
+using AsyncRBTree =
+    RBTree<Node, RBDefaultNodeTraits, TreeOptions<TreeFlags::MULTIPLE>>;
+using AsyncZTree = ZTree<Node, ZTreeDefaultNodeTraits<Node>, AsyncZTreeOptions,
+                         int, ygg::rbtree_internal::flexible_less, RankGetter>;
+using AsyncITree = IntervalTree<ITNode, ITNodeTraits<ITNode>>;
+
+TEST(AsyncSearchTest, EmptyTest)
+{
+	AsyncRBTree t;
+	int query = 5;
+	auto search = async_find(t, query);
+	ASSERT_TRUE(search.done());
+	ASSERT_FALSE(search.step());
+	ASSERT_EQ(search.get(), nullptr);
+}
+
+TEST(AsyncSearchTest, MixedTreesTest)
+{
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<int> rank_distr(0, 1000);
+
+	// Even values only, each one twice
+	std::vector<Node> nodes;
+	for (int i = 0; i < ASYNC_TESTSIZE; ++i) {
+		nodes.emplace_back(2 * (i / 2), rank_distr(rng));
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	std::vector<ITNode> intervals;
+	for (unsigned int i = 0; i < ASYNC_TESTSIZE; ++i) {
+		intervals.emplace_back(i / 4, i / 4 + i % 4);
+	}
+	std::shuffle(intervals.begin(), intervals.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	AsyncRBTree rbt;
+	AsyncZTree zt;
+	for (auto & n : nodes) {
+		rbt.insert(n);
+		zt.insert(n);
+	}
+	AsyncITree it;
+	for (auto & n : intervals) {
+		it.insert(n);
+	}
+
+	for (int q = -1; q < ASYNC_TESTSIZE + 1; ++q) {
+		Interval iq(static_cast<unsigned int>(q + 1) / 3,
+		            static_cast<unsigned int>(q + 1) / 3 + 1);
+
+		// Interleave lookups in all three trees
+		auto rb_find = async_find(rbt, q);
+		auto rb_lower = async_lower_bound(rbt, q);
+		auto z_find = async_find(zt, q);
+		auto z_lower = async_lower_bound(zt, q);
+		auto it_find = async_find(it, iq);
+		auto it_lower = async_lower_bound(it, iq);
+		run_interleaved(rb_find, rb_lower, z_find, z_lower, it_find, it_lower);
+
+		ASSERT_TRUE(rb_find.done());
+		ASSERT_TRUE(it_lower.done());
+
+		auto rb_expected = rbt.find(q);
+		ASSERT_EQ(rb_find.get(),
+		          (rb_expected == rbt.end()) ? nullptr : &*rb_expected);
+		auto rb_lower_expected = rbt.lower_bound(q);
+		ASSERT_EQ(rb_lower.get(), (rb_lower_expected == rbt.end())
+		                              ? nullptr
+		                              : &*rb_lower_expected);
+
+		auto z_expected = zt.find(q);
+		ASSERT_EQ(z_find.get(), (z_expected == zt.end()) ? nullptr : &*z_expected);
+		auto z_lower_expected = zt.lower_bound(q);
+		ASSERT_EQ(z_lower.get(),
+		          (z_lower_expected == zt.end()) ? nullptr : &*z_lower_expected);
+
+		auto it_expected = it.find(iq);
+		ASSERT_EQ(it_find.get(), (it_expected == it.end()) ? nullptr : &*it_expected);
+		auto it_lower_expected = it.lower_bound(iq);
+		ASSERT_EQ(it_lower.get(),
+		          (it_lower_expected == it.end()) ? nullptr : &*it_lower_expected);
+	}
+
+	// A range of lookups of the same type
+	std::vector<int> queries;
+	for (int q = -1; q < ASYNC_TESTSIZE + 1; ++q) {
+		queries.push_back(q);
+	}
+	std::vector<AsyncSearch<AsyncRBTree, int, false>> searches;
+	for (const int & q : queries) {
+		searches.push_back(async_lower_bound(rbt, q));
+	}
+	run_interleaved_range(searches.begin(), searches.end());
+	for (size_t i = 0; i < queries.size(); ++i) {
+		ASSERT_TRUE(searches[i].done());
+		auto expected = rbt.lower_bound(queries[i]);
+		ASSERT_EQ(searches[i].get(),
+		          (expected == rbt.end()) ? nullptr : &*expected);
+	}
+}
+
+} // namespace async_search
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_ASYNC_SEARCH_HPP
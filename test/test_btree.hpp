@@ -0,0 +1,257 @@
+#ifndef TEST_BTREE_HPP
+#define TEST_BTREE_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "../src/btree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace btree {
+
+using namespace ygg;
+
+constexpr int BTREE_TESTSIZE = 5000;
+
+class Node {
+public:
+	int data;
+
+	Node() : data(0){};
+	explicit Node(int data_in) : data(data_in){};
+};
+
+class KeyOf {
+public:
+	static int
+	get_key(const Node & n)
+	{
+		return n.data;
+	}
+};
+
+using UniqueTree =
+    BTree<Node, KeyOf, TreeOptions<TreeFlags::CONSTANT_TIME_SIZE>>;
+using MultiTree = BTree<Node, KeyOf>;
+// Tiny pages, i.e., lots of splits and merges
+using SmallPageTree =
+    BTree<Node, KeyOf,
+          TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                      TreeFlags::BTREE_PAGE_SIZE<64>>>;
+
+template <class Tree>
+void
+check_against_multiset(Tree & t, const std::multiset<int> & expected)
+{
+	ASSERT_TRUE(t.verify_integrity());
+	ASSERT_EQ(t.size(), expected.size());
+	ASSERT_EQ(t.empty(), expected.empty());
+
+	auto it = t.begin();
+	for (int val : expected) {
+		ASSERT_NE(it, t.end());
+		ASSERT_EQ(it->data, val);
+		it++;
+	}
+	ASSERT_EQ(it, t.end());
+
+	auto rit = t.rbegin();
+	for (auto eit = expected.rbegin(); eit != expected.rend(); ++eit) {
+		ASSERT_NE(rit, t.rend());
+		ASSERT_EQ(rit->data, *eit);
+		rit++;
+	}
+	ASSERT_EQ(rit, t.rend());
+}
+
+TEST(BTreeTest, InsertionAndDeletionTest)
+{
+	std::vector<Node> nodes;
+	for (int i = 0; i < BTREE_TESTSIZE; ++i) {
+		nodes.emplace_back(i);
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	UniqueTree t;
+	ASSERT_TRUE(t.empty());
+	ASSERT_EQ(t.find(0), t.end());
+	ASSERT_EQ(t.begin(), t.end());
+	ASSERT_EQ(t.rbegin(), t.rend());
+
+	std::multiset<int> expected;
+	for (auto & n : nodes) {
+		t.insert(n);
+		expected.insert(n.data);
+		ASSERT_TRUE(t.verify_integrity());
+	}
+	check_against_multiset(t, expected);
+
+	// Duplicates are rejected
+	Node duplicate(42);
+	t.insert(duplicate);
+	ASSERT_EQ(t.size(), (size_t)BTREE_TESTSIZE);
+	ASSERT_EQ(&*t.find(42), &*t.iterator_to(*std::find_if(
+	                            nodes.begin(), nodes.end(),
+	                            [](const Node & n) { return n.data == 42; })));
+	// Removing a node that is not in the tree does nothing
+	t.remove(duplicate);
+	ASSERT_EQ(t.size(), (size_t)BTREE_TESTSIZE);
+
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		t.remove(nodes[i]);
+		expected.erase(nodes[i].data);
+		ASSERT_TRUE(t.verify_integrity());
+	}
+	check_against_multiset(t, expected);
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		auto it = t.find(nodes[i].data);
+		if (i % 2 == 0) {
+			ASSERT_EQ(it, t.end());
+			ASSERT_EQ(t.iterator_to(nodes[i]), t.end());
+		} else {
+			ASSERT_EQ(&*it, &nodes[i]);
+			ASSERT_EQ(t.iterator_to(nodes[i]), it);
+		}
+	}
+
+	for (size_t i = 1; i < nodes.size(); i += 2) {
+		t.remove(nodes[i]);
+		ASSERT_TRUE(t.verify_integrity());
+	}
+	ASSERT_TRUE(t.empty());
+	ASSERT_EQ(t.size(), 0u);
+	ASSERT_EQ(t.begin(), t.end());
+}
+
+TEST(BTreeTest, BoundsTest)
+{
+	// Even values only
+	std::vector<Node> nodes;
+	for (int i = 0; i < BTREE_TESTSIZE; ++i) {
+		nodes.emplace_back(2 * i);
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	UniqueTree t;
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+
+	for (int q = -1; q < 2 * BTREE_TESTSIZE + 1; ++q) {
+		auto lower = t.lower_bound(q);
+		auto upper = t.upper_bound(q);
+		int expected_lower = (q < 0) ? 0 : ((q + 1) / 2) * 2;
+		int expected_upper = (q < 0) ? 0 : (q / 2 + 1) * 2;
+
+		if (expected_lower >= 2 * BTREE_TESTSIZE) {
+			ASSERT_EQ(lower, t.end());
+		} else {
+			ASSERT_EQ(lower->data, expected_lower);
+		}
+		if (expected_upper >= 2 * BTREE_TESTSIZE) {
+			ASSERT_EQ(upper, t.end());
+		} else {
+			ASSERT_EQ(upper->data, expected_upper);
+		}
+
+		const UniqueTree & ct = t;
+		ASSERT_EQ(UniqueTree::const_iterator<false>(lower), ct.lower_bound(q));
+		ASSERT_EQ(UniqueTree::const_iterator<false>(upper), ct.upper_bound(q));
+	}
+}
+
+template <class Tree>
+void
+run_multiple_test()
+{
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<int> distr(0, BTREE_TESTSIZE / 10);
+
+	std::vector<Node> nodes;
+	for (int i = 0; i < BTREE_TESTSIZE; ++i) {
+		nodes.emplace_back(distr(rng));
+	}
+
+	Tree t;
+	std::multiset<int> expected;
+	for (auto & n : nodes) {
+		t.insert(n);
+		expected.insert(n.data);
+	}
+	ASSERT_TRUE(t.verify_integrity());
+
+	// Equal elements are kept in insertion order
+	for (int val = 0; val <= BTREE_TESTSIZE / 10; ++val) {
+		auto it = t.find(val);
+		for (auto & n : nodes) {
+			if (n.data == val) {
+				ASSERT_EQ(&*it, &n);
+				it++;
+			}
+		}
+		ASSERT_EQ(it, t.upper_bound(val));
+	}
+
+	// Remove specific nodes, even if there are many equal ones
+	std::vector<size_t> order;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		order.push_back(i);
+	}
+	std::shuffle(order.begin(), order.end(), rng);
+	for (size_t i = 0; i < order.size() / 2; ++i) {
+		Node & n = nodes[order[i]];
+		ASSERT_EQ(&*t.iterator_to(n), &n);
+		t.remove(n);
+		ASSERT_EQ(t.iterator_to(n), t.end());
+		expected.erase(expected.find(n.data));
+	}
+	check_against_multiset(t, expected);
+
+	for (size_t i = order.size() / 2; i < order.size(); ++i) {
+		t.remove(nodes[order[i]]);
+	}
+	ASSERT_TRUE(t.empty());
+	ASSERT_TRUE(t.verify_integrity());
+}
+
+TEST(BTreeTest, MultipleTest) { run_multiple_test<MultiTree>(); }
+
+TEST(BTreeTest, SmallPagesTest) { run_multiple_test<SmallPageTree>(); }
+
+TEST(BTreeTest, MoveTest)
+{
+	std::vector<Node> nodes;
+	for (int i = 0; i < BTREE_TESTSIZE; ++i) {
+		nodes.emplace_back(i);
+	}
+
+	UniqueTree t;
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+
+	UniqueTree moved(std::move(t));
+	ASSERT_TRUE(t.empty());
+	ASSERT_EQ(moved.size(), (size_t)BTREE_TESTSIZE);
+	ASSERT_TRUE(moved.verify_integrity());
+
+	t = std::move(moved);
+	ASSERT_TRUE(moved.empty());
+	ASSERT_EQ(t.size(), (size_t)BTREE_TESTSIZE);
+	ASSERT_TRUE(t.verify_integrity());
+	ASSERT_EQ(&*t.find(17), &nodes[17]);
+}
+
+} // namespace btree
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_BTREE_HPP
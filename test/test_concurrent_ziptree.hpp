@@ -0,0 +1,288 @@
+#ifndef TEST_CONCURRENT_ZIPTREE_HPP
+#define TEST_CONCURRENT_ZIPTREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "../src/concurrent_ziptree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace concurrent_ziptree {
+
+using namespace ygg;
+
+constexpr int CZT_TESTSIZE = 5000;
+constexpr int CZT_THREADS = 4;
+
+class Node : public ConcurrentZTreeNodeBase<Node> {
+public:
+	int data;
+	std::atomic<int> reclaimed;
+
+	Node() : data(0), reclaimed(0){};
+	explicit Node(int data_in) : data(data_in), reclaimed(0){};
+	Node(const Node & other) : data(other.data), reclaimed(0){};
+
+	bool
+	operator<(const Node & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const Node & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const Node & rhs)
+{
+	return lhs < rhs.data;
+}
+
+class CountingTraits : public ConcurrentZTreeDefaultNodeTraits<Node> {
+public:
+	void
+	reclaim(Node * node) const noexcept
+	{
+		node->reclaimed++;
+	}
+};
+
+using Tree = ConcurrentZTree<Node, CountingTraits>;
+
+TEST(ConcurrentZTreeTest, SequentialTest)
+{
+	// Nodes are not movable, so the values are shuffled instead.
+	std::vector<int> values;
+	for (int i = 0; i < CZT_TESTSIZE; ++i) {
+		values.push_back(2 * i);
+	}
+	std::shuffle(values.begin(), values.end(),
+	             ygg::testing::utilities::Randomizer(4));
+	std::vector<Node> nodes;
+	nodes.reserve(values.size());
+	for (int val : values) {
+		nodes.emplace_back(val);
+	}
+
+	Tree t;
+	ASSERT_TRUE(t.empty());
+	{
+		Tree::Pin pin(t);
+		ASSERT_EQ(t.find(0, pin), nullptr);
+		ASSERT_EQ(t.lower_bound(0, pin), nullptr);
+	}
+
+	for (auto & n : nodes) {
+		ASSERT_TRUE(t.insert(n));
+	}
+	ASSERT_TRUE(t.verify_integrity());
+	ASSERT_FALSE(t.empty());
+
+	// Duplicates are rejected
+	Node duplicate(42);
+	ASSERT_FALSE(t.insert(duplicate));
+	ASSERT_TRUE(t.verify_integrity());
+
+	for (int i = 0; i < CZT_TESTSIZE; ++i) {
+		Tree::Pin pin(t);
+		Node * found = t.find(2 * i, pin);
+		ASSERT_NE(found, nullptr);
+		ASSERT_EQ(found->data, 2 * i);
+		ASSERT_EQ(t.find(2 * i + 1, pin), nullptr);
+		ASSERT_EQ(t.lower_bound(2 * i - 1, pin), found);
+	}
+	{
+		Tree::Pin pin(t);
+		ASSERT_EQ(t.lower_bound(2 * CZT_TESTSIZE, pin), nullptr);
+	}
+
+	// Remove every other node
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		ASSERT_TRUE(t.remove(nodes[i]));
+		ASSERT_FALSE(t.remove(nodes[i]));
+	}
+	ASSERT_TRUE(t.verify_integrity());
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		Tree::Pin pin(t);
+		Node * found = t.find(nodes[i].data, pin);
+		if (i % 2 == 0) {
+			ASSERT_EQ(found, nullptr);
+		} else {
+			ASSERT_EQ(found, &nodes[i]);
+		}
+	}
+
+	// Without concurrent operations or pins, everything removed gets
+	// reclaimed
+	t.collect();
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		ASSERT_EQ(nodes[i].reclaimed.load(), (i % 2 == 0) ? 1 : 0);
+	}
+
+	// Reclaimed nodes may be inserted again
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		ASSERT_TRUE(t.insert(nodes[i]));
+	}
+	ASSERT_TRUE(t.verify_integrity());
+	for (auto & n : nodes) {
+		Tree::Pin pin(t);
+		ASSERT_EQ(t.find(n.data, pin), &n);
+	}
+}
+
+TEST(ConcurrentZTreeTest, PinTest)
+{
+	Node node(42);
+	Tree t;
+	ASSERT_TRUE(t.insert(node));
+
+	{
+		Tree::Pin pin(t);
+		Node * found = t.find(42, pin);
+		ASSERT_EQ(found, &node);
+
+		// A node found through a living pin is not reclaimed
+		ASSERT_TRUE(t.remove(node));
+		t.collect();
+		t.collect();
+		ASSERT_EQ(node.reclaimed.load(), 0);
+		ASSERT_EQ(found->data, 42);
+		ASSERT_EQ(t.find(42, pin), nullptr);
+	}
+
+	t.collect();
+	ASSERT_EQ(node.reclaimed.load(), 1);
+}
+
+TEST(ConcurrentZTreeTest, ConcurrentTest)
+{
+	std::vector<int> values;
+	for (int i = 0; i < CZT_TESTSIZE; ++i) {
+		values.push_back(i);
+	}
+	std::shuffle(values.begin(), values.end(),
+	             ygg::testing::utilities::Randomizer(4));
+	std::vector<Node> nodes;
+	nodes.reserve(values.size());
+	for (int val : values) {
+		nodes.emplace_back(val);
+	}
+
+	{
+		Tree t;
+
+		// Nodes with odd values stay in the tree all the time
+		for (auto & n : nodes) {
+			if (n.data % 2 != 0) {
+				t.insert(n);
+			}
+		}
+
+		std::atomic<bool> done(false);
+		std::atomic<size_t> errors(0);
+		std::thread reader([&]() {
+			int key = 0;
+			while (!done.load()) {
+				key = (key + 7) % CZT_TESTSIZE;
+				int odd = key | 1;
+				if (odd >= CZT_TESTSIZE) {
+					continue;
+				}
+
+				Tree::Pin pin(t);
+				Node * found = t.find(odd, pin);
+				if ((found == nullptr) || (found->data != odd)) {
+					errors++;
+				}
+				// Either the even value itself or the odd one after it
+				Node * lower = t.lower_bound(odd - 1, pin);
+				if ((lower == nullptr) ||
+				    ((lower->data != odd - 1) && (lower->data != odd))) {
+					errors++;
+				}
+			}
+		});
+
+		// Several threads insert and remove the nodes with even values
+		for (int round = 0; round < 3; ++round) {
+			std::vector<std::thread> writers;
+			for (int w = 0; w < CZT_THREADS; ++w) {
+				writers.emplace_back([&, w]() {
+					for (size_t i = (size_t)w; i < nodes.size(); i += CZT_THREADS) {
+						if (nodes[i].data % 2 == 0) {
+							if (!t.insert(nodes[i])) {
+								errors++;
+							}
+						}
+					}
+				});
+			}
+			for (auto & writer : writers) {
+				writer.join();
+			}
+			ASSERT_TRUE(t.verify_integrity());
+			for (auto & n : nodes) {
+				Tree::Pin pin(t);
+				ASSERT_EQ(t.find(n.data, pin), &n);
+			}
+
+			writers.clear();
+			for (int w = 0; w < CZT_THREADS; ++w) {
+				writers.emplace_back([&, w]() {
+					for (size_t i = (size_t)w; i < nodes.size(); i += CZT_THREADS) {
+						if (nodes[i].data % 2 == 0) {
+							if (!t.remove(nodes[i])) {
+								errors++;
+							}
+						}
+					}
+				});
+			}
+			for (auto & writer : writers) {
+				writer.join();
+			}
+			ASSERT_TRUE(t.verify_integrity());
+
+			// A removed node may only be re-inserted after it was reclaimed.
+			// Spin until the reader's pinned epoch has been left behind.
+			bool all_reclaimed = false;
+			while (!all_reclaimed) {
+				t.collect();
+				all_reclaimed = true;
+				for (auto & n : nodes) {
+					if ((n.data % 2 == 0) && (n.reclaimed.load() != round + 1)) {
+						all_reclaimed = false;
+					}
+				}
+			}
+		}
+
+		done.store(true);
+		reader.join();
+		ASSERT_EQ(errors.load(), 0u);
+
+		for (auto & n : nodes) {
+			Tree::Pin pin(t);
+			if (n.data % 2 == 0) {
+				ASSERT_EQ(t.find(n.data, pin), nullptr);
+			} else {
+				ASSERT_EQ(t.find(n.data, pin), &n);
+			}
+		}
+	}
+}
+
+} // namespace concurrent_ziptree
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_CONCURRENT_ZIPTREE_HPP
@@ -0,0 +1,197 @@
+#ifndef TEST_INTERVAL_SNAPSHOT_HPP
+#define TEST_INTERVAL_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "../src/interval_snapshot.hpp"
+#include "../src/intervaltree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace interval_snapshot {
+
+using namespace ygg;
+
+constexpr unsigned int ISNAPSHOT_TESTSIZE = 3000;
+
+using Interval = std::pair<unsigned int, unsigned int>;
+
+class SnapshotITNode;
+
+class SnapshotITNodeTraits : public ITreeNodeTraits<SnapshotITNode> {
+public:
+	using key_type = unsigned int;
+
+	static unsigned int get_lower(const SnapshotITNode & node);
+	static unsigned int get_upper(const SnapshotITNode & node);
+
+	static unsigned int
+	get_lower(const Interval & i)
+	{
+		return std::get<0>(i);
+	}
+
+	static unsigned int
+	get_upper(const Interval & i)
+	{
+		return std::get<1>(i);
+	}
+};
+
+class SnapshotITNode
+    : public ITreeNodeBase<SnapshotITNode, SnapshotITNodeTraits> {
+public:
+	unsigned int lower;
+	unsigned int upper;
+
+	SnapshotITNode() : lower(0), upper(0){};
+	SnapshotITNode(unsigned int lower_in, unsigned int upper_in)
+	    : lower(lower_in), upper(upper_in){};
+};
+
+unsigned int
+SnapshotITNodeTraits::get_lower(const SnapshotITNode & node)
+{
+	return node.lower;
+}
+
+unsigned int
+SnapshotITNodeTraits::get_upper(const SnapshotITNode & node)
+{
+	return node.upper;
+}
+
+using Tree = IntervalTree<SnapshotITNode, SnapshotITNodeTraits>;
+using Snapshot = IntervalSnapshot<SnapshotITNode, SnapshotITNodeTraits>;
+
+std::vector<SnapshotITNode>
+make_nodes()
+{
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<unsigned int> lower_distr(
+	    0, 10 * ISNAPSHOT_TESTSIZE);
+	std::uniform_int_distribution<unsigned int> length_distr(0, 100);
+
+	std::vector<SnapshotITNode> nodes;
+	for (unsigned int i = 0; i < ISNAPSHOT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		if (i % 10 == 0) {
+			// Deeply nested intervals
+			for (unsigned int j = 0; j < 5; ++j) {
+				nodes.emplace_back(lower + j, lower + 500 - j);
+			}
+		} else if (i % 10 == 1) {
+			// Duplicates
+			nodes.emplace_back(lower, lower + 20);
+			nodes.emplace_back(lower, lower + 20);
+		} else {
+			nodes.emplace_back(lower, lower + length_distr(rng));
+		}
+	}
+
+	return nodes;
+}
+
+void
+check_against_tree(const Tree & tree, const Snapshot & snapshot)
+{
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<unsigned int> lower_distr(
+	    0, 11 * ISNAPSHOT_TESTSIZE);
+	std::uniform_int_distribution<unsigned int> length_distr(0, 200);
+
+	for (unsigned int i = 0; i < ISNAPSHOT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		// Every other query is a stabbing query
+		unsigned int upper = (i % 2 == 0) ? lower : lower + length_distr(rng);
+		Interval q(lower, upper);
+
+		std::vector<const SnapshotITNode *> expected;
+		for (const auto & n : tree.query(q)) {
+			expected.push_back(&n);
+		}
+
+		std::vector<const SnapshotITNode *> found;
+		snapshot.query(q, [&](SnapshotITNode & n) { found.push_back(&n); });
+
+		// Sorted by lower bound, longer intervals first
+		for (size_t j = 1; j < found.size(); ++j) {
+			ASSERT_LE(found[j - 1]->lower, found[j]->lower);
+			if (found[j - 1]->lower == found[j]->lower) {
+				ASSERT_GE(found[j - 1]->upper, found[j]->upper);
+			}
+		}
+
+		std::sort(expected.begin(), expected.end());
+		std::sort(found.begin(), found.end());
+		ASSERT_EQ(found, expected);
+
+		ASSERT_EQ(snapshot.count_overlaps(q), expected.size());
+		ASSERT_EQ(snapshot.any_overlap(q), !expected.empty());
+	}
+}
+
+TEST(IntervalSnapshotTest, QueryTest)
+{
+	auto nodes = make_nodes();
+
+	Tree tree;
+	for (auto & n : nodes) {
+		tree.insert(n);
+	}
+
+	Snapshot snapshot(tree);
+	ASSERT_EQ(snapshot.size(), nodes.size());
+	ASSERT_FALSE(snapshot.empty());
+	check_against_tree(tree, snapshot);
+
+	// Everything overlaps the whole range
+	ASSERT_EQ(snapshot.count_overlaps(Interval(0, 100 * ISNAPSHOT_TESTSIZE)),
+	          nodes.size());
+	ASSERT_FALSE(snapshot.any_overlap(
+	    Interval(100 * ISNAPSHOT_TESTSIZE, 100 * ISNAPSHOT_TESTSIZE)));
+}
+
+TEST(IntervalSnapshotTest, RebuildTest)
+{
+	auto nodes = make_nodes();
+
+	Tree tree;
+	for (auto & n : nodes) {
+		tree.insert(n);
+	}
+
+	Snapshot snapshot;
+	ASSERT_TRUE(snapshot.empty());
+	ASSERT_FALSE(snapshot.any_overlap(Interval(0, 10)));
+	ASSERT_EQ(snapshot.count_overlaps(Interval(0, 10)), 0u);
+
+	snapshot.rebuild(tree);
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		tree.remove(nodes[i]);
+	}
+	snapshot.rebuild(tree);
+	ASSERT_EQ(snapshot.size(), nodes.size() - (nodes.size() + 1) / 2);
+	check_against_tree(tree, snapshot);
+
+	// Build from node pointers, in any order
+	std::vector<SnapshotITNode *> pointers;
+	for (auto & n : tree) {
+		pointers.push_back(&n);
+	}
+	std::shuffle(pointers.begin(), pointers.end(),
+	             ygg::testing::utilities::Randomizer(4));
+	Snapshot from_pointers;
+	from_pointers.build(pointers.begin(), pointers.end());
+	check_against_tree(tree, from_pointers);
+}
+
+} // namespace interval_snapshot
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_INTERVAL_SNAPSHOT_HPP
@@ -167,6 +167,73 @@ TEST(ITreeTest, RandomInsertionRandomDeletionTest)
 	}
 }
 
+TEST(ITreeTest, BuildFromSortedTest)
+{
+	auto tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>();
+
+	std::vector<ITNode> nodes;
+	std::mt19937 rng(4); // chosen by fair xkcd
+
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		std::uniform_int_distribution<unsigned int> bounds_distr(
+		    0, std::numeric_limits<unsigned int>::max() / 2);
+		unsigned int lower = bounds_distr(rng);
+		unsigned int upper = lower + bounds_distr(rng);
+
+		nodes.push_back(ITNode(lower, upper, (int)i));
+	}
+
+	std::sort(nodes.begin(), nodes.end(),
+	          [](const ITNode & lhs, const ITNode & rhs) {
+		          return std::make_pair(lhs.lower, lhs.upper) <
+		                 std::make_pair(rhs.lower, rhs.upper);
+	          });
+
+	tree.build_from_sorted(nodes.begin(), nodes.end());
+	ASSERT_TRUE(tree.verify_integrity());
+
+	// Maxima must be maintained by subsequent modifications
+	for (unsigned int i = 0; i < IT_TESTSIZE; i += 2) {
+		tree.remove(nodes[i]);
+		ASSERT_TRUE(tree.verify_integrity());
+	}
+}
+
+TEST(ITreeTest, SplitJoinTest)
+{
+	using Tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>;
+	Tree tree;
+
+	ITNode nodes[IT_TESTSIZE];
+	std::mt19937 rng(4); // chosen by fair xkcd
+	std::uniform_int_distribution<unsigned int> bounds_distr(0, 10000);
+
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		unsigned int lower = bounds_distr(rng);
+		unsigned int upper = lower + bounds_distr(rng);
+
+		nodes[i] = ITNode(lower, upper, (int)i);
+		tree.insert(nodes[i]);
+	}
+
+	for (unsigned int split_at = 0; split_at < 10000; split_at += 499) {
+		Tree right;
+		tree.split(Interval(split_at, 0), right);
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_TRUE(right.verify_integrity());
+
+		for (auto & n : tree) {
+			ASSERT_LT(n.lower, split_at);
+		}
+		for (auto & n : right) {
+			ASSERT_GE(n.lower, split_at);
+		}
+
+		tree.join(right);
+		ASSERT_TRUE(tree.verify_integrity());
+	}
+}
+
 TEST(ITreeTest, TrivialQueryTest)
 {
 	auto tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>();
@@ -364,6 +431,209 @@ TEST(ITreeTest, ComprehensiveTest)
 	}
 }
 
+TEST(ITreeTest, BatchQueryTest)
+{
+	auto tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>();
+
+	ITNode nodes[IT_TESTSIZE];
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<unsigned int> lower_distr(0, 10 * IT_TESTSIZE);
+	std::uniform_int_distribution<unsigned int> length_distr(0, 100);
+
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		// Some intervals are very long
+		unsigned int length = (i % 50 == 0) ? 20 * length_distr(rng)
+		                                    : length_distr(rng);
+		nodes[i] = ITNode(lower, lower + length, (int)i);
+		tree.insert(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	std::vector<Interval> queries;
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		queries.emplace_back(lower, lower + length_distr(rng));
+	}
+	// Stabbing queries, and queries beyond all intervals
+	queries.emplace_back(500, 500);
+	queries.emplace_back(20 * IT_TESTSIZE, 20 * IT_TESTSIZE);
+	queries.emplace_back(100 * IT_TESTSIZE, 200 * IT_TESTSIZE);
+	std::sort(queries.begin(), queries.end());
+
+	std::vector<std::vector<const ITNode *>> results(queries.size());
+	tree.query_batch(queries.begin(), queries.end(),
+	                 [&](size_t index, const ITNode & node) {
+		                 results[index].push_back(&node);
+	                 });
+
+	size_t total = 0;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		std::vector<const ITNode *> expected;
+		for (const auto & node : tree.query(queries[i])) {
+			expected.push_back(&node);
+		}
+		ASSERT_EQ(results[i], expected);
+		total += expected.size();
+	}
+	ASSERT_GT(total, 0u);
+
+	// Empty batches and empty trees report nothing
+	size_t calls = 0;
+	auto count_calls = [&](size_t, const ITNode &) { calls++; };
+	tree.query_batch(queries.begin(), queries.begin(), count_calls);
+	auto empty_tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>();
+	empty_tree.query_batch(queries.begin(), queries.end(), count_calls);
+	ASSERT_EQ(calls, 0u);
+}
+
+using CountingOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::ORDER_STATISTICS,
+                TreeFlags::ITREE_COUNT_OVERLAPS>;
+
+class CountingITNode
+    : public ITreeNodeBase<CountingITNode, MyNodeTraits<CountingITNode>,
+                           CountingOptions> {
+public:
+	int data;
+	unsigned int lower;
+	unsigned int upper;
+
+	CountingITNode() : data(0), lower(0), upper(0){};
+	explicit CountingITNode(unsigned int lower_in, unsigned int upper_in,
+	                        int data_in)
+	    : data(data_in), lower(lower_in), upper(upper_in){};
+};
+
+TEST(ITreeTest, CountOverlapsTest)
+{
+	using Tree = IntervalTree<CountingITNode, MyNodeTraits<CountingITNode>,
+	                          CountingOptions>;
+	Tree tree;
+
+	CountingITNode nodes[IT_TESTSIZE];
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<unsigned int> lower_distr(0, 10 * IT_TESTSIZE);
+	std::uniform_int_distribution<unsigned int> length_distr(0, 200);
+
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		unsigned int length = (i % 20 == 0) ? 50 * length_distr(rng)
+		                                    : length_distr(rng);
+		nodes[i] = CountingITNode(lower, lower + length, (int)i);
+		tree.insert(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	auto check_queries = [&]() {
+		for (unsigned int i = 0; i < IT_TESTSIZE / 4; ++i) {
+			unsigned int lower = lower_distr(rng);
+			// Every other query is a stabbing query
+			unsigned int upper = (i % 2 == 0) ? lower : lower + length_distr(rng);
+			Interval q(lower, upper);
+
+			size_t expected = 0;
+			for (const auto & n : tree) {
+				if ((n.lower <= upper) && (n.upper >= lower)) {
+					expected++;
+				}
+			}
+
+			ASSERT_EQ(tree.count_overlaps(q), expected);
+			ASSERT_EQ(tree.any_overlap(q), expected > 0);
+		}
+	};
+	check_queries();
+
+	ASSERT_FALSE(tree.any_overlap(Interval(100 * IT_TESTSIZE, 100 * IT_TESTSIZE)));
+	ASSERT_EQ(tree.count_overlaps(Interval(100 * IT_TESTSIZE, 100 * IT_TESTSIZE)),
+	          0u);
+	ASSERT_EQ(tree.count_overlaps(Interval(0, 100 * IT_TESTSIZE)),
+	          (size_t)IT_TESTSIZE);
+
+	// The augmentation must survive deletions
+	for (unsigned int i = 0; i < IT_TESTSIZE; i += 3) {
+		tree.remove(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+	check_queries();
+
+	Tree empty_tree;
+	ASSERT_FALSE(empty_tree.any_overlap(Interval(0, 10)));
+	ASSERT_EQ(empty_tree.count_overlaps(Interval(0, 10)), 0u);
+}
+
+using MinLowerOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::ITREE_MIN_LOWER>;
+
+class MinLowerITNode
+    : public ITreeNodeBase<MinLowerITNode, MyNodeTraits<MinLowerITNode>,
+                           MinLowerOptions> {
+public:
+	int data;
+	unsigned int lower;
+	unsigned int upper;
+
+	MinLowerITNode() : data(0), lower(0), upper(0){};
+	explicit MinLowerITNode(unsigned int lower_in, unsigned int upper_in,
+	                        int data_in)
+	    : data(data_in), lower(lower_in), upper(upper_in){};
+};
+
+TEST(ITreeTest, MinLowerQueryTest)
+{
+	using Tree = IntervalTree<MinLowerITNode, MyNodeTraits<MinLowerITNode>,
+	                          MinLowerOptions>;
+	Tree tree;
+
+	MinLowerITNode nodes[IT_TESTSIZE];
+	std::vector<unsigned int> indices;
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<unsigned int> lower_distr(0, 10 * IT_TESTSIZE);
+	std::uniform_int_distribution<unsigned int> length_distr(0, 200);
+
+	for (unsigned int i = 0; i < IT_TESTSIZE; ++i) {
+		unsigned int lower = lower_distr(rng);
+		// Some long-lived, wide intervals
+		unsigned int length = (i % 20 == 0) ? 50 * length_distr(rng)
+		                                    : length_distr(rng);
+		nodes[i] = MinLowerITNode(lower, lower + length, (int)i);
+		indices.push_back(i);
+		tree.insert(nodes[i]);
+		ASSERT_TRUE(tree.verify_integrity());
+	}
+
+	auto check_queries = [&]() {
+		for (unsigned int i = 0; i < IT_TESTSIZE / 4; ++i) {
+			unsigned int lower = lower_distr(rng);
+			Interval q(lower, lower + length_distr(rng));
+
+			std::vector<const MinLowerITNode *> expected;
+			for (const auto & n : tree) {
+				if ((n.lower <= std::get<1>(q)) && (n.upper >= std::get<0>(q))) {
+					expected.push_back(&n);
+				}
+			}
+
+			std::vector<const MinLowerITNode *> found;
+			for (const auto & n : tree.query(q)) {
+				found.push_back(&n);
+			}
+			ASSERT_EQ(found, expected);
+			ASSERT_EQ(tree.any_overlap(q), !expected.empty());
+		}
+	};
+	check_queries();
+
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(4));
+	for (unsigned int i = 0; i < IT_TESTSIZE / 2; ++i) {
+		tree.remove(nodes[indices[i]]);
+		ASSERT_TRUE(tree.verify_integrity());
+	}
+	check_queries();
+}
+
 TEST(ITreeTest, RandomEqualInsertionRandomDeletionTest)
 {
 	auto tree = IntervalTree<ITNode, MyNodeTraits<ITNode>>();
@@ -0,0 +1,169 @@
+#ifndef TEST_NODE_POOL_HPP
+#define TEST_NODE_POOL_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "../src/list.hpp"
+#include "../src/node_pool.hpp"
+#include "../src/rbtree.hpp"
+#include "../src/ziptree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace node_pool {
+
+using namespace ygg;
+
+constexpr int POOL_TESTSIZE = 2000;
+
+int live_nodes = 0;
+
+using PoolZTreeOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                TreeFlags::ZTREE_RANK_TYPE<int>>;
+
+class PoolNode : public RBTreeNodeBase<PoolNode>,
+                 public ZTreeNodeBase<PoolNode, PoolZTreeOptions>,
+                 public ListNodeBase<PoolNode> {
+public:
+	int data;
+
+	explicit PoolNode(int data_in) : data(data_in) { live_nodes++; };
+	~PoolNode() { live_nodes--; };
+
+	bool
+	operator<(const PoolNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+using PoolRBTree = RBTree<PoolNode, RBDefaultNodeTraits>;
+using PoolZTree =
+    ZTree<PoolNode, ZTreeDefaultNodeTraits<PoolNode>, PoolZTreeOptions>;
+using PoolList = List<PoolNode>;
+
+TEST(NodePoolTest, RecyclingTest)
+{
+	{
+		NodePool<PoolNode> pool(100);
+
+		std::vector<PoolNode *> nodes;
+		for (int i = 0; i < POOL_TESTSIZE; ++i) {
+			nodes.push_back(pool.construct(i));
+		}
+		ASSERT_EQ(pool.size(), (size_t)POOL_TESTSIZE);
+		ASSERT_EQ(pool.capacity(), (size_t)POOL_TESTSIZE);
+		ASSERT_EQ(live_nodes, POOL_TESTSIZE);
+
+		// Addresses are stable and distinct
+		for (int i = 0; i < POOL_TESTSIZE; ++i) {
+			ASSERT_EQ(nodes[(size_t)i]->data, i);
+		}
+		std::set<PoolNode *> distinct(nodes.begin(), nodes.end());
+		ASSERT_EQ(distinct.size(), (size_t)POOL_TESTSIZE);
+
+		// Freed memory is reused before new slabs are allocated
+		std::set<PoolNode *> freed;
+		for (int i = 0; i < POOL_TESTSIZE; i += 2) {
+			freed.insert(nodes[(size_t)i]);
+			pool.destroy(nodes[(size_t)i]);
+		}
+		ASSERT_EQ(live_nodes, POOL_TESTSIZE / 2);
+		for (int i = 0; i < POOL_TESTSIZE / 2; ++i) {
+			PoolNode * n = pool.construct(i);
+			ASSERT_TRUE(freed.find(n) != freed.end());
+		}
+		ASSERT_EQ(pool.capacity(), (size_t)POOL_TESTSIZE);
+
+		pool.reserve(3 * POOL_TESTSIZE);
+		ASSERT_GE(pool.capacity(), (size_t)(3 * POOL_TESTSIZE));
+		size_t capacity = pool.capacity();
+		for (int i = 0; i < 2 * POOL_TESTSIZE; ++i) {
+			pool.construct(i);
+		}
+		ASSERT_EQ(pool.capacity(), capacity);
+		ASSERT_EQ(pool.size(), (size_t)(3 * POOL_TESTSIZE));
+	}
+
+	// Nodes still in the pool are destroyed with it
+	ASSERT_EQ(live_nodes, 0);
+}
+
+TEST(NodePoolTest, ContainerTest)
+{
+	NodePool<PoolNode> pool;
+	PoolRBTree rbtree;
+	PoolZTree ztree;
+	PoolList list;
+
+	std::vector<int> values;
+	for (int i = 0; i < POOL_TESTSIZE; ++i) {
+		values.push_back(i);
+	}
+	std::shuffle(values.begin(), values.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	std::vector<PoolNode *> nodes;
+	for (int val : values) {
+		PoolNode * n = pool.emplace_insert(rbtree, val);
+		ztree.insert(*n);
+		list.insert(nullptr, n);
+		nodes.push_back(n);
+	}
+	ASSERT_TRUE(rbtree.verify_integrity());
+	ztree.dbg_verify();
+
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		rbtree.remove(*nodes[i]);
+		ztree.remove(*nodes[i]);
+		pool.erase_and_free(list, *nodes[i]);
+	}
+	ASSERT_TRUE(rbtree.verify_integrity());
+	ztree.dbg_verify();
+	ASSERT_EQ(pool.size(), (size_t)POOL_TESTSIZE / 2);
+
+	int last = -1;
+	for (auto & n : rbtree) {
+		ASSERT_GT(n.data, last);
+		last = n.data;
+	}
+
+	size_t i = 1;
+	for (auto & n : list) {
+		ASSERT_EQ(&n, nodes[i]);
+		i += 2;
+	}
+
+	for (size_t j = 1; j < nodes.size(); j += 2) {
+		rbtree.remove(*nodes[j]);
+		list.remove(nodes[j]);
+		pool.erase_and_free(ztree, *nodes[j]);
+	}
+	ASSERT_TRUE(rbtree.empty());
+	ASSERT_TRUE(ztree.empty());
+	ASSERT_TRUE(list.empty());
+	ASSERT_EQ(pool.size(), 0u);
+	ASSERT_EQ(live_nodes, 0);
+}
+
+TEST(NodePoolTest, ThreadLocalPoolTest)
+{
+	auto & pool = NodePool<PoolNode>::thread_local_pool();
+	ASSERT_EQ(&pool, &NodePool<PoolNode>::thread_local_pool());
+
+	PoolNode * n = pool.construct(42);
+	ASSERT_EQ(n->data, 42);
+	pool.destroy(n);
+	ASSERT_EQ(pool.size(), 0u);
+}
+
+} // namespace node_pool
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_NODE_POOL_HPP
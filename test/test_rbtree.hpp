@@ -3,9 +3,12 @@
 
 #include <algorithm>
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <random>
+#include <string>
 #include <vector>
 
+#include "../src/list.hpp"
 #include "../src/rbtree.hpp"
 #include "randomizer.hpp"
 
@@ -67,6 +70,74 @@ public:
 	}
 };
 
+using OSOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                TreeFlags::ORDER_STATISTICS>;
+
+class OSNode : public RBTreeNodeBase<OSNode, OSOptions> {
+public:
+	int data;
+
+	OSNode() : data(0){};
+	explicit OSNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const OSNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+using OQOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                TreeFlags::ORDER_QUERIES>;
+
+class OQNode : public RBTreeNodeBase<OQNode, OQOptions> {
+public:
+	int data;
+
+	OQNode() : data(0){};
+	explicit OQNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const OQNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+class IndexNode;
+class IndexNodeArray {
+public:
+	static IndexNode * get_base();
+};
+
+using IndexOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                TreeFlags::INDEX_LINKS<IndexNodeArray>>;
+
+class IndexNode : public RBTreeNodeBase<IndexNode, IndexOptions> {
+public:
+	int data;
+
+	IndexNode() : data(0){};
+	explicit IndexNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const IndexNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+std::vector<IndexNode> index_nodes;
+
+IndexNode *
+IndexNodeArray::get_base()
+{
+	return index_nodes.data();
+}
+
 class NodeTraits : public RBDefaultNodeTraits {
 public:
 	static std::string
@@ -650,6 +721,851 @@ TEST(RBTreeTest, FindTest)
 	}
 }
 
+TEST(RBTreeTest, BuildFromSortedTest)
+{
+	for (unsigned int size = 0; size < 70; ++size) {
+		auto tree = RBTree<EqualityNode, EqualityNodeTraits>();
+
+		std::vector<EqualityNode> nodes;
+		for (unsigned int i = 0; i < size; ++i) {
+			nodes.push_back(EqualityNode((int)i));
+		}
+
+		tree.build_from_sorted(nodes.begin(), nodes.end());
+
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_EQ(tree.size(), size);
+
+		unsigned int i = 0;
+		for (auto & n : tree) {
+			ASSERT_EQ(&n, &(nodes[i]));
+			i++;
+		}
+		ASSERT_EQ(i, size);
+	}
+}
+
+TEST(RBTreeTest, BuildFromSortedPointersTest)
+{
+	auto tree =
+	    RBTree<Node, NodeTraits, TreeOptions<TreeFlags::COMPRESS_COLOR>>();
+
+	Node nodes[RBTREE_TESTSIZE];
+	std::vector<Node *> pointers;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		nodes[i] = Node((int)(2 * i));
+		pointers.push_back(&nodes[i]);
+	}
+
+	tree.build_from_sorted(pointers.begin(), pointers.end());
+	ASSERT_TRUE(tree.verify_integrity());
+
+	// The tree must remain usable afterwards
+	Node additional[RBTREE_TESTSIZE];
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		additional[i] = Node((int)(2 * i + 1));
+		tree.insert(additional[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; i += 2) {
+		tree.remove(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	unsigned int i = 0;
+	for (auto & n : tree) {
+		if ((i % 4) == 0) {
+			i++;
+		}
+		ASSERT_EQ(n.data, i);
+		i++;
+	}
+	ASSERT_EQ(i, 2 * RBTREE_TESTSIZE);
+}
+
+TEST(RBTreeTest, InsertBatchTest)
+{
+	// Small batches are inserted via the finger, large batches are merged.
+	for (unsigned int batch_size : {10u, (unsigned int)RBTREE_TESTSIZE}) {
+		auto tree = RBTree<EqualityNode, EqualityNodeTraits>();
+
+		std::vector<EqualityNode> nodes;
+		for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+			nodes.push_back(EqualityNode((int)(3 * i), 0));
+		}
+		std::vector<size_t> indices;
+		for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+			indices.push_back(i);
+		}
+		std::shuffle(indices.begin(), indices.end(),
+		             ygg::testing::utilities::Randomizer(4));
+		for (auto index : indices) {
+			tree.insert(nodes[index]);
+		}
+
+		// Batch interleaves with the tree and contains equal elements
+		std::vector<EqualityNode> batch;
+		for (unsigned int i = 0; i < batch_size; ++i) {
+			batch.push_back(EqualityNode((int)((3 * RBTREE_TESTSIZE * i) /
+			                                   batch_size + (i % 3)),
+			                             1));
+		}
+
+		tree.insert_batch(batch.begin(), batch.end());
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_EQ(tree.size(), RBTREE_TESTSIZE + batch_size);
+
+		int last = std::numeric_limits<int>::min();
+		int last_sub = 0;
+		size_t count = 0;
+		for (auto & n : tree) {
+			ASSERT_TRUE(n.data >= last);
+			if (n.data == last) {
+				// Batch nodes go after equal nodes from the tree
+				ASSERT_TRUE(n.sub_data >= last_sub);
+			}
+			last = n.data;
+			last_sub = n.sub_data;
+			count++;
+		}
+		ASSERT_EQ(count, RBTREE_TESTSIZE + batch_size);
+
+		for (auto & n : batch) {
+			tree.remove(n);
+		}
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_EQ(tree.size(), RBTREE_TESTSIZE);
+	}
+}
+
+TEST(RBTreeTest, InsertBatchNoMultipleTest)
+{
+	auto tree =
+	    RBTree<Node, NodeTraits, TreeOptions<TreeFlags::COMPRESS_COLOR>>();
+
+	Node nodes[RBTREE_TESTSIZE];
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		nodes[i] = Node((int)(2 * i));
+		tree.insert(nodes[i]);
+	}
+
+	// Every other node of the batch is already present
+	std::vector<Node *> batch;
+	Node batch_nodes[2 * RBTREE_TESTSIZE - 1];
+	for (unsigned int i = 0; i < 2 * RBTREE_TESTSIZE - 1; ++i) {
+		batch_nodes[i] = Node((int)i);
+		batch.push_back(&batch_nodes[i]);
+	}
+
+	tree.insert_batch(batch.begin(), batch.end());
+	ASSERT_TRUE(tree.verify_integrity());
+
+	unsigned int i = 0;
+	for (auto & n : tree) {
+		ASSERT_EQ(n.data, i);
+		if (i % 2 == 0) {
+			ASSERT_EQ(&n, &nodes[i / 2]);
+		} else {
+			ASSERT_EQ(&n, &batch_nodes[i]);
+		}
+		i++;
+	}
+	ASSERT_EQ(i, 2 * RBTREE_TESTSIZE - 1);
+}
+
+TEST(RBTreeTest, SplitJoinTest)
+{
+	using Tree = RBTree<EqualityNode, EqualityNodeTraits>;
+
+	std::vector<EqualityNode> nodes;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		// Every value occurs twice
+		nodes.push_back(EqualityNode((int)(i / 2), (int)i));
+	}
+
+	std::vector<size_t> indices;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	Tree tree;
+	for (auto index : indices) {
+		tree.insert(nodes[index]);
+	}
+
+	for (int split_at = -1; split_at <= RBTREE_TESTSIZE / 2;
+	     split_at += 1 + RBTREE_TESTSIZE / 50) {
+		Tree right;
+		tree.split(EqualityNode(split_at), right);
+
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_TRUE(right.verify_integrity());
+
+		size_t expected_left = (size_t)std::max(0, 2 * split_at);
+		ASSERT_EQ(tree.size(), expected_left);
+		ASSERT_EQ(right.size(), RBTREE_TESTSIZE - expected_left);
+
+		for (auto & n : tree) {
+			ASSERT_LT(n.data, split_at);
+		}
+		for (auto & n : right) {
+			ASSERT_GE(n.data, split_at);
+		}
+
+		tree.join(right);
+		ASSERT_TRUE(tree.verify_integrity());
+		ASSERT_TRUE(right.empty());
+		ASSERT_EQ(tree.size(), RBTREE_TESTSIZE);
+	}
+
+	// Order must be preserved
+	std::vector<EqualityNode *> order;
+	for (auto & n : tree) {
+		order.push_back(&n);
+	}
+	for (unsigned int i = 1; i < RBTREE_TESTSIZE; ++i) {
+		ASSERT_FALSE(*order[i] < *order[i - 1]);
+	}
+}
+
+TEST(RBTreeTest, JoinDifferentHeightsTest)
+{
+	using Tree = RBTree<EqualityNode, EqualityNodeTraits>;
+
+	for (unsigned int left_size : {0u, 1u, 7u, 100u}) {
+		for (unsigned int right_size : {0u, 1u, 3u, 1000u}) {
+			std::vector<EqualityNode> nodes;
+			for (unsigned int i = 0; i < left_size + right_size; ++i) {
+				nodes.push_back(EqualityNode((int)i));
+			}
+
+			Tree left;
+			Tree right;
+			for (unsigned int i = 0; i < left_size; ++i) {
+				left.insert(nodes[i]);
+			}
+			for (unsigned int i = left_size; i < left_size + right_size; ++i) {
+				right.insert(nodes[i]);
+			}
+
+			left.join(right);
+			ASSERT_TRUE(left.verify_integrity());
+			ASSERT_EQ(left.size(), left_size + right_size);
+
+			unsigned int i = 0;
+			for (auto & n : left) {
+				ASSERT_EQ(&n, &nodes[i]);
+				i++;
+			}
+			ASSERT_EQ(i, left_size + right_size);
+		}
+	}
+}
+
+TEST(RBTreeTest, OrderStatisticsTest)
+{
+	using Tree = RBTree<OSNode, RBDefaultNodeTraits, OSOptions>;
+
+	std::vector<OSNode> nodes;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		nodes.push_back(OSNode((int)(i / 2)));
+	}
+	std::vector<size_t> indices;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	Tree tree;
+	for (auto index : indices) {
+		tree.insert(nodes[index]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	// Remove every third node again
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; i += 3) {
+		tree.remove(nodes[indices[i]]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	std::vector<OSNode *> order;
+	for (auto & n : tree) {
+		order.push_back(&n);
+	}
+	ASSERT_EQ(order.size(), tree.size());
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		ASSERT_EQ(&*tree.select(i), order[i]);
+		ASSERT_EQ(tree.rank(*order[i]), i);
+	}
+	ASSERT_EQ(tree.select(order.size()), tree.end());
+
+	// Jumping iterators
+	for (size_t from = 0; from < order.size(); from += 7) {
+		for (size_t steps : {0ul, 1ul, 2ul, 13ul, 100ul, order.size()}) {
+			auto it = tree.iterator_to(*order[from]);
+			it += steps;
+			if (from + steps < order.size()) {
+				ASSERT_EQ(&*it, order[from + steps]);
+				ASSERT_EQ(it - tree.iterator_to(*order[from]), (ptrdiff_t)steps);
+			} else {
+				ASSERT_EQ(it, tree.end());
+			}
+
+			it = tree.iterator_to(*order[from]);
+			it -= steps;
+			if (steps <= from) {
+				ASSERT_EQ(&*it, order[from - steps]);
+			} else {
+				ASSERT_EQ(it, tree.end());
+			}
+
+			auto rit = tree.rbegin();
+			rit += from;
+			ASSERT_EQ(&*rit, order[order.size() - 1 - from]);
+			ASSERT_EQ(rit - tree.rbegin(), (ptrdiff_t)from);
+			ASSERT_EQ(tree.rend() - rit, (ptrdiff_t)(order.size() - from));
+		}
+	}
+	ASSERT_EQ(tree.end() - tree.begin(), (ptrdiff_t)order.size());
+	ASSERT_EQ(tree.begin() - tree.end(), -(ptrdiff_t)order.size());
+
+	// Sizes survive split, join, and bulk operations
+	Tree right;
+	tree.split(OSNode(RBTREE_TESTSIZE / 4), right);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_TRUE(right.verify_integrity());
+	ASSERT_EQ(right.rank(*right.begin()), 0u);
+	ASSERT_EQ(&*tree.select(tree.size() - 1), &*tree.rbegin());
+	tree.join(right);
+	ASSERT_TRUE(tree.verify_integrity());
+
+	tree.clear();
+	std::vector<OSNode *> sorted;
+	for (auto & n : nodes) {
+		sorted.push_back(&n);
+	}
+	tree.build_from_sorted(sorted.begin(), sorted.end());
+	ASSERT_TRUE(tree.verify_integrity());
+	for (size_t i = 0; i < sorted.size(); ++i) {
+		ASSERT_EQ(&*tree.select(i), sorted[i]);
+	}
+
+	std::vector<OSNode> batch;
+	for (unsigned int i = 0; i < 10; ++i) {
+		batch.push_back(OSNode((int)(i * 50)));
+	}
+	tree.insert_batch(batch.begin(), batch.end());
+	ASSERT_TRUE(tree.verify_integrity());
+	size_t i = 0;
+	for (auto & n : tree) {
+		ASSERT_EQ(tree.rank(n), i);
+		i++;
+	}
+}
+
+template <class Tree, class Node>
+void
+check_order_queries(const Tree & tree, std::vector<Node *> & order)
+{
+	order.clear();
+	for (auto & n : tree) {
+		order.push_back(const_cast<Node *>(&n));
+	}
+
+	for (size_t i = 0; i + 1 < order.size(); ++i) {
+		ASSERT_TRUE(tree.precedes(*order[i], *order[i + 1]));
+		ASSERT_FALSE(tree.precedes(*order[i + 1], *order[i]));
+		ASSERT_FALSE(tree.precedes(*order[i], *order[i]));
+	}
+	for (size_t i = 0; i < order.size(); i += 17) {
+		for (size_t j = 0; j < order.size(); j += 13) {
+			ASSERT_EQ(tree.precedes(*order[i], *order[j]), i < j);
+		}
+	}
+}
+
+TEST(RBTreeTest, OrderQueriesTest)
+{
+	using Tree = RBTree<OQNode, RBDefaultNodeTraits, OQOptions>;
+
+	// Few distinct keys. Always inserting at the very front or back of the
+	// equal range of a key exhausts the labels in between quickly.
+	std::vector<OQNode> nodes;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		nodes.push_back(OQNode((int)(i % 5)));
+	}
+
+	Tree tree;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		if (i % 3 == 0) {
+			tree.insert_right_leaning(nodes[i]);
+		} else {
+			tree.insert_left_leaning(nodes[i]);
+		}
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	std::vector<OQNode *> order;
+	check_order_queries(tree, order);
+
+	// Removing never invalidates the labels
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; i += 4) {
+		tree.remove(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+
+	// Re-insert in the middle of the equal elements, using hints
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; i += 4) {
+		auto lower = tree.lower_bound(nodes[i]);
+		auto upper = tree.upper_bound(nodes[i]);
+		size_t equal_count = (size_t)std::distance(lower, upper);
+		std::advance(lower, equal_count / 2);
+		tree.insert(nodes[i], *lower);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+
+	// Split and join
+	Tree right;
+	tree.split(OQNode(3), right);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_TRUE(right.verify_integrity());
+	check_order_queries(right, order);
+
+	// Labels in a fresh tree clash with the labels in the left tree, so the
+	// join must relabel.
+	Tree fresh;
+	for (auto * n : order) {
+		right.remove(*n);
+		fresh.insert(*n);
+	}
+	tree.join(fresh);
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+
+	// Rebuild everything
+	tree.clear();
+	tree.build_from_sorted(order.begin(), order.end());
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+
+	// If the left tree's largest label is the largest possible one, the
+	// appended nodes do not fit above it, and a range before the join point is
+	// relabeled together with them.
+	tree.split(OQNode(3), right);
+	std::vector<OQNode *> left_order;
+	check_order_queries(tree, left_order);
+	check_order_queries(right, order);
+	size_t appended_count = order.size();
+	tree.clear();
+	tree.build_from_sorted(left_order.begin(), left_order.end());
+	left_order.back()->_rbt_order_tag = (static_cast<uint64_t>(1) << 63) - 1;
+	ASSERT_TRUE(tree.verify_integrity());
+	fresh.clear();
+	for (auto * n : order) {
+		right.remove(*n);
+		fresh.insert(*n);
+	}
+	tree.join(fresh);
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+	ASSERT_EQ(order.size(), left_order.size() + appended_count);
+
+	// A large batch is merged, and its nodes are labeled afterwards
+	std::vector<OQNode> batch;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		batch.push_back(OQNode((int)((7 * i) / RBTREE_TESTSIZE)));
+	}
+	tree.insert_batch(batch.begin(), batch.end());
+	ASSERT_TRUE(tree.verify_integrity());
+	check_order_queries(tree, order);
+	ASSERT_EQ(order.size(), left_order.size() + appended_count + batch.size());
+}
+
+TEST(RBTreeTest, IndexLinksTest)
+{
+	// Two child indices plus the parent index with the color packed into it
+	ASSERT_EQ(sizeof(RBTreeNodeBase<IndexNode, IndexOptions>),
+	          3 * sizeof(uint32_t));
+
+	using Tree = RBTree<IndexNode, RBDefaultNodeTraits, IndexOptions>;
+
+	index_nodes.clear();
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		index_nodes.push_back(IndexNode((int)(i / 2)));
+	}
+	std::vector<size_t> indices;
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	Tree tree;
+	for (auto index : indices) {
+		tree.insert(index_nodes[index]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	for (unsigned int i = 0; i < RBTREE_TESTSIZE; i += 3) {
+		tree.remove(index_nodes[indices[i]]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	int last = -1;
+	size_t count = 0;
+	for (auto & n : tree) {
+		ASSERT_GE(n.data, last);
+		last = n.data;
+		count++;
+	}
+	ASSERT_EQ(count, tree.size());
+
+	for (unsigned int i = 1; i < RBTREE_TESTSIZE; i += 3) {
+		IndexNode & n = index_nodes[indices[i]];
+		auto it = tree.find(n);
+		ASSERT_NE(it, tree.end());
+		ASSERT_EQ(it->data, n.data);
+		ASSERT_FALSE(*tree.lower_bound(n) < n);
+	}
+
+	Tree right;
+	tree.split(IndexNode(RBTREE_TESTSIZE / 4), right);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_TRUE(right.verify_integrity());
+	tree.join(right);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), count);
+}
+
+TEST(RBTreeTest, BatchSearchTest)
+{
+	auto tree =
+	    RBTree<Node, NodeTraits, TreeOptions<TreeFlags::COMPRESS_COLOR>>();
+
+	// Only even values
+	std::vector<Node> nodes;
+	for (int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		nodes.push_back(Node(2 * i));
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+	for (auto & n : nodes) {
+		tree.insert(n);
+	}
+
+	// Not a multiple of the batch width, and hitting as well as missing
+	std::vector<Node> queries;
+	for (int i = -3; i < 2 * RBTREE_TESTSIZE + 3; i += 3) {
+		queries.push_back(Node(i));
+	}
+	ASSERT_NE(queries.size() % decltype(tree)::BATCH_WIDTH, 0u);
+
+	std::vector<decltype(tree.end())> found;
+	tree.find_batch(queries.begin(), queries.end(), std::back_inserter(found));
+	std::vector<decltype(tree.end())> lower;
+	tree.lower_bound_batch(queries.begin(), queries.end(),
+	                       std::back_inserter(lower));
+
+	ASSERT_EQ(found.size(), queries.size());
+	ASSERT_EQ(lower.size(), queries.size());
+	for (size_t i = 0; i < queries.size(); ++i) {
+		ASSERT_EQ(found[i], tree.find(queries[i]));
+		ASSERT_EQ(lower[i], tree.lower_bound(queries[i]));
+	}
+
+	// Empty tree and empty batch
+	found.clear();
+	tree.find_batch(queries.begin(), queries.begin(), std::back_inserter(found));
+	ASSERT_TRUE(found.empty());
+
+	auto empty_tree =
+	    RBTree<Node, NodeTraits, TreeOptions<TreeFlags::COMPRESS_COLOR>>();
+	empty_tree.find_batch(queries.begin(), queries.end(),
+	                      std::back_inserter(found));
+	for (auto & it : found) {
+		ASSERT_EQ(it, empty_tree.end());
+	}
+}
+
+// Packs the first eight characters into an integer, preserving their order
+class PrefixExtractor {
+public:
+	static uint64_t
+	get_cached_key(const std::string & s)
+	{
+		uint64_t prefix = 0;
+		for (size_t i = 0; i < 8; ++i) {
+			prefix <<= 8;
+			if (i < s.size()) {
+				prefix |= (uint8_t)s[i];
+			}
+		}
+		return prefix;
+	}
+
+	template <class StringNode>
+	static uint64_t
+	get_cached_key(const StringNode & n)
+	{
+		return get_cached_key(*n.key);
+	}
+};
+
+using CachedKeyOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                TreeFlags::CACHED_KEY<PrefixExtractor, uint64_t>>;
+
+// The key is stored out-of-line, like in a node holding a string payload
+class StringNode : public RBTreeNodeBase<StringNode, CachedKeyOptions> {
+public:
+	const std::string * key;
+	static size_t full_compares;
+
+	explicit StringNode(const std::string * key_in) : key(key_in){};
+
+	bool
+	operator<(const StringNode & other) const
+	{
+		full_compares++;
+		return *this->key < *other.key;
+	}
+};
+size_t StringNode::full_compares = 0;
+
+bool
+operator<(const StringNode & lhs, const std::string & rhs)
+{
+	StringNode::full_compares++;
+	return *lhs.key < rhs;
+}
+bool
+operator<(const std::string & lhs, const StringNode & rhs)
+{
+	StringNode::full_compares++;
+	return lhs < *rhs.key;
+}
+
+TEST(RBTreeTest, CachedKeyTest)
+{
+	using Tree = RBTree<StringNode, RBDefaultNodeTraits, CachedKeyOptions>;
+
+	// Half of the keys have distinct prefixes, the other half share a long
+	// prefix and must be compared fully.
+	std::vector<std::string> keys;
+	for (int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		if (i % 2 == 0) {
+			keys.push_back(std::to_string(1000000 + i));
+		} else {
+			keys.push_back(std::string("shared_prefix_") + std::to_string(i));
+		}
+	}
+	std::shuffle(keys.begin(), keys.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	std::vector<StringNode> nodes;
+	for (const auto & key : keys) {
+		nodes.push_back(StringNode(&key));
+	}
+
+	Tree tree;
+	for (auto & n : nodes) {
+		tree.insert(n);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	std::vector<std::string> sorted_keys(keys);
+	std::sort(sorted_keys.begin(), sorted_keys.end());
+	auto key_it = sorted_keys.begin();
+	for (auto & n : tree) {
+		ASSERT_EQ(*n.key, *key_it);
+		key_it++;
+	}
+
+	// Looking up keys with distinct prefixes only needs full comparisons against
+	// the node that is found.
+	StringNode::full_compares = 0;
+	size_t lookups = 0;
+	for (auto & n : nodes) {
+		if (n.key->compare(0, 6, "shared") == 0) {
+			continue;
+		}
+		auto it = tree.find(*n.key);
+		ASSERT_EQ(&*it, &n);
+		lookups++;
+	}
+	ASSERT_LE(StringNode::full_compares, 2 * lookups);
+
+	// All the other keys are still found correctly
+	for (auto & n : nodes) {
+		ASSERT_EQ(&*tree.find(*n.key), &n);
+		ASSERT_EQ(&*tree.lower_bound(*n.key), &n);
+	}
+	ASSERT_EQ(tree.find(std::string("shared_prefix_x")), tree.end());
+	ASSERT_EQ(tree.find(std::string("0")), tree.end());
+
+	// Nodes that are not in the tree work as queries, even if their stored
+	// cached key is uninitialized or stale
+	std::vector<StringNode> node_queries;
+	for (const auto & key : keys) {
+		StringNode stale(nodes[0]);
+		stale.key = &key;
+		node_queries.push_back(stale);
+
+		ASSERT_EQ(*tree.find(StringNode(&key))->key, key);
+		ASSERT_EQ(*tree.lower_bound(StringNode(&key))->key, key);
+		ASSERT_EQ(*tree.find(stale)->key, key);
+		ASSERT_EQ(*tree.lower_bound(stale)->key, key);
+		auto upper = tree.upper_bound(stale);
+		ASSERT_TRUE((upper == tree.end()) || (key < *upper->key));
+		ASSERT_EQ(std::next(tree.find(stale)), upper);
+	}
+	std::vector<decltype(tree.end())> batch_results;
+	tree.find_batch(node_queries.begin(), node_queries.end(),
+	                std::back_inserter(batch_results));
+	for (size_t i = 0; i < node_queries.size(); ++i) {
+		ASSERT_EQ(*batch_results[i]->key, *node_queries[i].key);
+	}
+	std::string missing("shared_prefix_x");
+	ASSERT_EQ(tree.find(StringNode(&missing)), tree.end());
+
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		tree.remove(nodes[i]);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+
+	// The bulk operations fill the cached keys as well
+	std::vector<StringNode *> sorted_nodes;
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		sorted_nodes.push_back(&nodes[i]);
+	}
+	std::sort(sorted_nodes.begin(), sorted_nodes.end(),
+	          [](const StringNode * lhs, const StringNode * rhs) {
+		          return *lhs->key < *rhs->key;
+	          });
+	tree.insert_batch(sorted_nodes.begin(), sorted_nodes.end());
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), nodes.size());
+
+	Tree rebuilt;
+	std::vector<StringNode *> all_nodes;
+	for (auto & n : tree) {
+		all_nodes.push_back(&n);
+	}
+	tree.clear();
+	rebuilt.build_from_sorted(all_nodes.begin(), all_nodes.end());
+	ASSERT_TRUE(rebuilt.verify_integrity());
+	for (auto & n : nodes) {
+		ASSERT_EQ(&*rebuilt.find(*n.key), &n);
+	}
+}
+
+using RangeOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE>;
+
+class RangeNode : public RBTreeNodeBase<RangeNode, RangeOptions>,
+                  public ListNodeBase<RangeNode> {
+public:
+	int data;
+
+	explicit RangeNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const RangeNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const RangeNode & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const RangeNode & rhs)
+{
+	return lhs < rhs.data;
+}
+
+TEST(RBTreeTest, RangeEraseTest)
+{
+	using Tree = RBTree<RangeNode, RBDefaultNodeTraits, RangeOptions>;
+
+	std::vector<RangeNode> nodes;
+	for (int i = 0; i < RBTREE_TESTSIZE; ++i) {
+		// Every value occurs twice
+		nodes.push_back(RangeNode(i / 2));
+	}
+	std::vector<RangeNode *> shuffled;
+	for (auto & n : nodes) {
+		shuffled.push_back(&n);
+	}
+	std::shuffle(shuffled.begin(), shuffled.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	Tree tree;
+	for (auto * n : shuffled) {
+		tree.insert(*n);
+	}
+
+	// Empty ranges change nothing
+	tree.erase_range(-5, -1);
+	tree.erase_range(17, 17);
+	tree.erase_range(RBTREE_TESTSIZE, RBTREE_TESTSIZE + 10);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), (size_t)RBTREE_TESTSIZE);
+
+	// Erase [100, 200)
+	tree.erase_range(100, 200);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), (size_t)RBTREE_TESTSIZE - 200);
+	for (auto & n : tree) {
+		ASSERT_TRUE(n.data < 100 || n.data >= 200);
+	}
+
+	// Extract [300, 350) into a list
+	List<RangeNode> extracted;
+	tree.extract_range(300, 350, extracted);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), (size_t)RBTREE_TESTSIZE - 300);
+	ASSERT_EQ(extracted.size(), 100u);
+	int expected = 300;
+	size_t seen = 0;
+	for (auto & n : extracted) {
+		ASSERT_EQ(n.data, expected);
+		seen++;
+		if (seen % 2 == 0) {
+			expected++;
+		}
+	}
+	ASSERT_EQ(tree.find(325), tree.end());
+	ASSERT_NE(tree.find(350), tree.end());
+
+	// Extracted nodes can be reinserted
+	for (auto & n : extracted) {
+		tree.insert(n);
+	}
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), (size_t)RBTREE_TESTSIZE - 200);
+
+	// Erase everything at the borders, then everything
+	tree.erase_range(-1, 10);
+	tree.erase_range(RBTREE_TESTSIZE / 2 - 10, RBTREE_TESTSIZE);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_EQ(tree.size(), (size_t)RBTREE_TESTSIZE - 240);
+	tree.erase_range(-1, RBTREE_TESTSIZE);
+	ASSERT_TRUE(tree.verify_integrity());
+	ASSERT_TRUE(tree.empty());
+	ASSERT_EQ(tree.size(), 0u);
+}
+
 TEST(RBTreeTest, ComprehensiveTest)
 {
 	auto tree =
@@ -0,0 +1,191 @@
+#ifndef TEST_SEARCH_SNAPSHOT_HPP
+#define TEST_SEARCH_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "../src/rbtree.hpp"
+#include "../src/search_snapshot.hpp"
+#include "../src/ziptree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace search_snapshot {
+
+using namespace ygg;
+
+constexpr int SNAPSHOT_TESTSIZE = 3000;
+
+using SnapshotZTreeOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::ZTREE_RANK_TYPE<int>>;
+
+class SnapshotNode
+    : public RBTreeNodeBase<SnapshotNode, TreeOptions<TreeFlags::MULTIPLE>>,
+      public ZTreeNodeBase<SnapshotNode, SnapshotZTreeOptions> {
+public:
+	int data;
+	int rank;
+
+	SnapshotNode() : data(0), rank(0){};
+	SnapshotNode(int data_in, int rank_in) : data(data_in), rank(rank_in){};
+
+	bool
+	operator<(const SnapshotNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const SnapshotNode & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const SnapshotNode & rhs)
+{
+	return lhs < rhs.data;
+}
+
+class SnapshotRankGetter {
+public:
+	static int
+	get_rank(const SnapshotNode & n)
+	{
+		return n.rank;
+	}
+};
+
+class SnapshotKeyOf {
+public:
+	static int
+	get_key(const SnapshotNode & n)
+	{
+		return n.data;
+	}
+};
+
+using SnapshotRBTree = RBTree<SnapshotNode, RBDefaultNodeTraits,
+                              TreeOptions<TreeFlags::MULTIPLE>>;
+using SnapshotZTree =
+    ZTree<SnapshotNode, ZTreeDefaultNodeTraits<SnapshotNode>,
+          SnapshotZTreeOptions, int, ygg::rbtree_internal::flexible_less,
+          SnapshotRankGetter>;
+
+template <class Snapshot, class Tree>
+void
+compare_to_tree(const Snapshot & snapshot, Tree & t, int max_val)
+{
+	for (int q = -2; q <= max_val + 2; ++q) {
+		auto tree_find = t.find(q);
+		SnapshotNode * snap_find = snapshot.find(q);
+		if (tree_find == t.end()) {
+			ASSERT_EQ(snap_find, nullptr);
+		} else {
+			ASSERT_NE(snap_find, nullptr);
+			ASSERT_EQ(snap_find->data, q);
+		}
+
+		auto tree_lb = t.lower_bound(q);
+		SnapshotNode * snap_lb = snapshot.lower_bound(q);
+		if (tree_lb == t.end()) {
+			ASSERT_EQ(snap_lb, nullptr);
+		} else {
+			// Must be the first of all equal elements
+			ASSERT_EQ(snap_lb, &*tree_lb);
+		}
+
+		auto tree_ub = t.upper_bound(q);
+		SnapshotNode * snap_ub = snapshot.upper_bound(q);
+		if (tree_ub == t.end()) {
+			ASSERT_EQ(snap_ub, nullptr);
+		} else {
+			ASSERT_EQ(snap_ub, &*tree_ub);
+		}
+	}
+}
+
+TEST(SearchSnapshotTest, EmptyTest)
+{
+	SearchSnapshot<SnapshotNode> snapshot;
+	ASSERT_TRUE(snapshot.empty());
+	ASSERT_EQ(snapshot.find(0), nullptr);
+	ASSERT_EQ(snapshot.lower_bound(0), nullptr);
+	ASSERT_EQ(snapshot.upper_bound(0), nullptr);
+
+	SnapshotRBTree t;
+	snapshot.rebuild(t);
+	ASSERT_TRUE(snapshot.empty());
+	ASSERT_EQ(snapshot.find(0), nullptr);
+	ASSERT_EQ(snapshot.lower_bound(0), nullptr);
+}
+
+TEST(SearchSnapshotTest, RBTreeTest)
+{
+	// Only even values, each one twice
+	std::vector<SnapshotNode> nodes;
+	for (int i = 0; i < SNAPSHOT_TESTSIZE; ++i) {
+		nodes.emplace_back(2 * (i / 2), 0);
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	SnapshotRBTree t;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		t.insert(nodes[i]);
+
+		// Odd sizes as well as perfect trees
+		if ((i < 70) || (i % 97 == 0)) {
+			SearchSnapshot<SnapshotNode> snapshot(t);
+			ASSERT_EQ(snapshot.size(), i + 1);
+			compare_to_tree(snapshot, t, SNAPSHOT_TESTSIZE);
+		}
+	}
+
+	SearchSnapshot<SnapshotNode, SnapshotKeyOf> key_snapshot(t);
+	ASSERT_EQ(key_snapshot.size(), (size_t)SNAPSHOT_TESTSIZE);
+	compare_to_tree(key_snapshot, t, SNAPSHOT_TESTSIZE);
+}
+
+TEST(SearchSnapshotTest, ZTreeTest)
+{
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<int> rank_distr(0, 1000);
+
+	std::vector<SnapshotNode> nodes;
+	for (int i = 0; i < SNAPSHOT_TESTSIZE; ++i) {
+		nodes.emplace_back(3 * (i / 3), rank_distr(rng));
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	SnapshotZTree t;
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+
+	SearchSnapshot<SnapshotNode> snapshot(t);
+	compare_to_tree(snapshot, t, SNAPSHOT_TESTSIZE);
+
+	SearchSnapshot<SnapshotNode, SnapshotKeyOf> key_snapshot;
+	key_snapshot.rebuild(t);
+	compare_to_tree(key_snapshot, t, SNAPSHOT_TESTSIZE);
+
+	// Building from a range of node pointers
+	std::vector<SnapshotNode *> sorted;
+	for (auto & n : t) {
+		sorted.push_back(&n);
+	}
+	SearchSnapshot<SnapshotNode> ptr_snapshot;
+	ptr_snapshot.build(sorted.begin(), sorted.end());
+	compare_to_tree(ptr_snapshot, t, SNAPSHOT_TESTSIZE);
+}
+
+} // namespace search_snapshot
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_SEARCH_SNAPSHOT_HPP
@@ -0,0 +1,220 @@
+#ifndef TEST_SEQLOCK_TREE_HPP
+#define TEST_SEQLOCK_TREE_HPP
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "../src/seqlock_tree.hpp"
+
+namespace ygg {
+namespace testing {
+namespace seqlock_tree {
+
+using namespace ygg;
+
+constexpr int SEQLOCK_TESTSIZE = 2000;
+constexpr int SEQLOCK_ROUNDS = 20;
+constexpr int SEQLOCK_READERS = 4;
+
+using SeqLockOptions = TreeOptions<TreeFlags::ATOMIC_LINKS>;
+
+class Node : public RBTreeNodeBase<Node, SeqLockOptions> {
+public:
+	int data;
+
+	Node() : data(0){};
+	explicit Node(int data_in) : data(data_in){};
+
+	bool
+	operator<(const Node & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const Node & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const Node & rhs)
+{
+	return lhs < rhs.data;
+}
+
+using Tree = SeqLockRBTree<Node, RBDefaultNodeTraits, SeqLockOptions>;
+
+TEST(SeqLockTreeTest, SequentialTest)
+{
+	std::vector<Node> nodes;
+	for (int i = 0; i < SEQLOCK_TESTSIZE; ++i) {
+		nodes.emplace_back(2 * i);
+	}
+
+	Tree t;
+	ASSERT_EQ(t.find(0), nullptr);
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+	ASSERT_TRUE(t.get_unsynchronized().verify_integrity());
+
+	for (int i = 0; i < SEQLOCK_TESTSIZE; ++i) {
+		ASSERT_EQ(t.find(2 * i), &nodes[(size_t)i]);
+		ASSERT_EQ(t.find(2 * i + 1), nullptr);
+		ASSERT_EQ(t.lower_bound(2 * i - 1), &nodes[(size_t)i]);
+		ASSERT_EQ(t.lower_bound(2 * i), &nodes[(size_t)i]);
+		if (i + 1 < SEQLOCK_TESTSIZE) {
+			ASSERT_EQ(t.upper_bound(2 * i), &nodes[(size_t)i + 1]);
+		} else {
+			ASSERT_EQ(t.upper_bound(2 * i), nullptr);
+		}
+	}
+
+	t.modify([&](Tree::Tree & tree) {
+		for (size_t i = 0; i < nodes.size(); i += 2) {
+			tree.remove(nodes[i]);
+		}
+	});
+	ASSERT_TRUE(t.get_unsynchronized().verify_integrity());
+	ASSERT_EQ(t.find(0), nullptr);
+	ASSERT_EQ(t.lower_bound(0), &nodes[1]);
+}
+
+TEST(SeqLockTreeTest, ConcurrentReadersTest)
+{
+	// Even keys stay in the tree, odd keys come and go
+	std::vector<Node> nodes;
+	for (int i = 0; i < SEQLOCK_TESTSIZE; ++i) {
+		nodes.emplace_back(i);
+	}
+
+	Tree t;
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+
+	std::atomic<bool> done(false);
+	std::atomic<size_t> errors(0);
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < SEQLOCK_READERS; ++r) {
+		readers.emplace_back([&, r]() {
+			int key = r;
+			while (!done.load()) {
+				key = (key + 7) % SEQLOCK_TESTSIZE;
+				int even = key - (key % 2);
+
+				Node * found = t.find(even);
+				if ((found == nullptr) || (found->data != even)) {
+					errors++;
+				}
+
+				// Either the odd key itself or the even key after it
+				Node * lower = t.lower_bound(even + 1);
+				if ((lower != nullptr) && (lower->data != even + 1) &&
+				    (lower->data != even + 2)) {
+					errors++;
+				}
+			}
+		});
+	}
+
+	for (int round = 0; round < SEQLOCK_ROUNDS; ++round) {
+		for (size_t i = 1; i < nodes.size(); i += 2) {
+			t.remove(nodes[i]);
+		}
+		for (size_t i = 1; i < nodes.size(); i += 2) {
+			t.insert(nodes[i]);
+		}
+	}
+
+	done.store(true);
+	for (auto & reader : readers) {
+		reader.join();
+	}
+
+	ASSERT_EQ(errors.load(), 0u);
+	ASSERT_TRUE(t.get_unsynchronized().verify_integrity());
+}
+
+TEST(SeqLockTreeTest, ConcurrentModifyTest)
+{
+	// Every third key stays in the tree. The writer removes and re-inserts the
+	// others in batches, restructuring large parts of the tree per write.
+	std::vector<Node> nodes;
+	for (int i = 0; i < SEQLOCK_TESTSIZE; ++i) {
+		nodes.emplace_back(i);
+	}
+
+	Tree t;
+	for (auto & n : nodes) {
+		t.insert(n);
+	}
+
+	std::atomic<bool> done(false);
+	std::atomic<size_t> errors(0);
+	std::atomic<size_t> reads(0);
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < SEQLOCK_READERS; ++r) {
+		readers.emplace_back([&, r]() {
+			int key = r;
+			while (!done.load()) {
+				key = (key + 13) % (SEQLOCK_TESTSIZE - 3);
+				int stable = key - (key % 3);
+				Node * stable_node = &nodes[(size_t)stable];
+				Node * next_stable = &nodes[(size_t)stable + 3];
+
+				if (t.find(stable) != stable_node) {
+					errors++;
+				}
+
+				// Whatever comes between two stable keys, the results must be
+				// nodes in that range.
+				Node * upper = t.upper_bound(stable);
+				if ((upper <= stable_node) || (upper > next_stable)) {
+					errors++;
+				}
+				Node * lower = t.lower_bound(stable + 1);
+				if ((lower <= stable_node) || (lower > next_stable)) {
+					errors++;
+				}
+				reads++;
+			}
+		});
+	}
+
+	for (int round = 0; round < SEQLOCK_ROUNDS; ++round) {
+		size_t first = 1 + (size_t)round % 2;
+		t.modify([&](Tree::Tree & tree) {
+			for (size_t i = first; i < nodes.size(); i += 3) {
+				tree.remove(nodes[i]);
+			}
+		});
+		t.modify([&](Tree::Tree & tree) {
+			for (size_t i = first; i < nodes.size(); i += 3) {
+				tree.insert(nodes[i]);
+			}
+		});
+	}
+
+	while (reads.load() < SEQLOCK_READERS) {
+		std::this_thread::yield();
+	}
+	done.store(true);
+	for (auto & reader : readers) {
+		reader.join();
+	}
+
+	ASSERT_EQ(errors.load(), 0u);
+	ASSERT_TRUE(t.get_unsynchronized().verify_integrity());
+}
+
+} // namespace seqlock_tree
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_SEQLOCK_TREE_HPP
@@ -0,0 +1,273 @@
+#ifndef TEST_SHARDED_TREE_HPP
+#define TEST_SHARDED_TREE_HPP
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/sharded_tree.hpp"
+#include "randomizer.hpp"
+
+namespace ygg {
+namespace testing {
+namespace sharded_tree {
+
+using namespace ygg;
+
+constexpr int SHARDED_TESTSIZE = 3000;
+constexpr int SHARDED_THREADS = 4;
+
+using ShardedZTreeOptions =
+    TreeOptions<TreeFlags::MULTIPLE, TreeFlags::ZTREE_RANK_TYPE<int>>;
+
+class Node : public RBTreeNodeBase<Node, TreeOptions<TreeFlags::MULTIPLE>>,
+             public ZTreeNodeBase<Node, ShardedZTreeOptions> {
+public:
+	int data;
+	int rank;
+
+	Node() : data(0), rank(0){};
+	Node(int data_in, int rank_in) : data(data_in), rank(rank_in){};
+
+	bool
+	operator<(const Node & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const Node & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const Node & rhs)
+{
+	return lhs < rhs.data;
+}
+
+class RankGetter {
+public:
+	static int
+	get_rank(const Node & n)
+	{
+		return n.rank;
+	}
+};
+
+class KeyOf {
+public:
+	static int
+	get_key(const Node & n)
+	{
+		return n.data;
+	}
+};
+
+using ShardRBTree =
+    RBTree<Node, RBDefaultNodeTraits, TreeOptions<TreeFlags::MULTIPLE>>;
+using ShardZTree =
+    ZTree<Node, ZTreeDefaultNodeTraits<Node>, ShardedZTreeOptions, int,
+          ygg::rbtree_internal::flexible_less, RankGetter>;
+
+template <class Sharded>
+void
+check_contents(Sharded & st, std::vector<Node> & nodes, bool present)
+{
+	for (auto & n : nodes) {
+		Node * found = st.find(n.data);
+		if (present) {
+			ASSERT_NE(found, nullptr);
+			ASSERT_EQ(found->data, n.data);
+		} else {
+			ASSERT_EQ(found, nullptr);
+		}
+	}
+
+	std::vector<int> visited;
+	st.for_each([&](Node & n) { visited.push_back(n.data); });
+	if (!present) {
+		ASSERT_TRUE(visited.empty());
+		return;
+	}
+
+	std::vector<int> expected;
+	for (auto & n : nodes) {
+		expected.push_back(n.data);
+	}
+	std::sort(expected.begin(), expected.end());
+	ASSERT_EQ(visited, expected);
+	ASSERT_EQ(st.size(), nodes.size());
+}
+
+template <class Tree>
+void
+run_sequential_test()
+{
+	std::mt19937 rng(4);
+	std::uniform_int_distribution<int> rank_distr(0, 1000);
+
+	// Only even values, each one twice. All values end up in the last shard.
+	std::vector<Node> nodes;
+	for (int i = 0; i < SHARDED_TESTSIZE; ++i) {
+		nodes.emplace_back(2 * (i / 2), rank_distr(rng));
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	using Sharded = ShardedTree<Tree, 4, KeyOf>;
+	Sharded st(typename Sharded::Splitters{{-3, -2, -1}});
+	ASSERT_EQ(st.lower_bound(0), nullptr);
+
+	for (auto & n : nodes) {
+		st.insert(n);
+	}
+	check_contents(st, nodes, true);
+	ASSERT_EQ(st.shard_size(3), (size_t)SHARDED_TESTSIZE);
+
+	// Lower bounds must cross the (empty) shards
+	ASSERT_EQ(st.lower_bound(-10)->data, 0);
+	ASSERT_EQ(st.lower_bound(1)->data, 2);
+	ASSERT_EQ(st.lower_bound(SHARDED_TESTSIZE), nullptr);
+
+	// Repeated rebalancing spreads the elements evenly
+	for (int round = 0; round < 4; ++round) {
+		st.rebalance();
+	}
+	auto splitters = st.get_splitters();
+	for (size_t i = 0; i < 4; ++i) {
+		ASSERT_GE(st.shard_size(i), (size_t)SHARDED_TESTSIZE / 4 - 50);
+		ASSERT_LE(st.shard_size(i), (size_t)SHARDED_TESTSIZE / 4 + 50);
+		if ((i > 0) && (i < 3)) {
+			ASSERT_LE(splitters[i - 1], splitters[i]);
+		}
+	}
+	check_contents(st, nodes, true);
+
+	for (int q = -1; q < SHARDED_TESTSIZE - 1; ++q) {
+		Node * lb = st.lower_bound(q);
+		ASSERT_NE(lb, nullptr);
+		ASSERT_EQ(lb->data, q + (q % 2 != 0 ? 1 : 0));
+		if (q % 2 != 0) {
+			ASSERT_EQ(st.find(q), nullptr);
+		}
+	}
+
+	// Empty the upper shards, so that elements have to move rightwards
+	for (auto & n : nodes) {
+		if (n.data >= SHARDED_TESTSIZE / 2) {
+			st.remove(n);
+		}
+	}
+	st.rebalance();
+	st.rebalance();
+	ASSERT_EQ(st.size(), (size_t)SHARDED_TESTSIZE / 2);
+	for (int q = -1; q < SHARDED_TESTSIZE / 2 - 1; ++q) {
+		ASSERT_EQ(st.lower_bound(q)->data, q + (q % 2 != 0 ? 1 : 0));
+	}
+	ASSERT_EQ(st.lower_bound(SHARDED_TESTSIZE / 2), nullptr);
+
+	for (auto & n : nodes) {
+		if (n.data < SHARDED_TESTSIZE / 2) {
+			st.remove(n);
+		}
+	}
+	check_contents(st, nodes, false);
+	ASSERT_EQ(st.size(), 0u);
+}
+
+TEST(ShardedTreeTest, RBTreeSequentialTest)
+{
+	run_sequential_test<ShardRBTree>();
+}
+
+TEST(ShardedTreeTest, ZTreeSequentialTest)
+{
+	run_sequential_test<ShardZTree>();
+}
+
+TEST(ShardedTreeTest, ConcurrentTest)
+{
+	std::vector<Node> nodes;
+	for (int i = 0; i < SHARDED_TESTSIZE; ++i) {
+		nodes.emplace_back(i, 0);
+	}
+	std::shuffle(nodes.begin(), nodes.end(),
+	             ygg::testing::utilities::Randomizer(4));
+
+	// Deliberately bad splitters, so that rebalancing has to move a lot
+	using Sharded = ShardedTree<ShardRBTree, 8, KeyOf>;
+	Sharded st(Sharded::Splitters{{1, 2, 3, 4, 5, 6, 7}});
+
+	std::vector<std::thread> writers;
+	for (int w = 0; w < SHARDED_THREADS; ++w) {
+		writers.emplace_back([&, w]() {
+			for (size_t i = (size_t)w; i < nodes.size(); i += SHARDED_THREADS) {
+				st.insert(nodes[i]);
+				if (i % 64 == 0) {
+					st.rebalance((i / 64) % 7);
+				}
+			}
+		});
+	}
+
+	// Concurrent ordered iteration must always see a sorted sequence
+	bool sorted = true;
+	std::thread reader([&]() {
+		for (int round = 0; round < 20; ++round) {
+			int last = -1;
+			st.for_each([&](Node & n) {
+				sorted = sorted && (n.data > last);
+				last = n.data;
+			});
+		}
+	});
+
+	for (auto & writer : writers) {
+		writer.join();
+	}
+	reader.join();
+	ASSERT_TRUE(sorted);
+
+	st.rebalance();
+	ASSERT_EQ(st.size(), (size_t)SHARDED_TESTSIZE);
+	for (int i = 0; i < SHARDED_TESTSIZE; ++i) {
+		Node * found = st.find(i);
+		ASSERT_NE(found, nullptr);
+		ASSERT_EQ(found->data, i);
+	}
+
+	// Remove half of the elements while others are being rebalanced
+	std::vector<std::thread> removers;
+	for (int w = 0; w < SHARDED_THREADS; ++w) {
+		removers.emplace_back([&, w]() {
+			for (size_t i = (size_t)w; i < nodes.size(); i += SHARDED_THREADS) {
+				if (nodes[i].data % 2 == 0) {
+					st.remove(nodes[i]);
+				}
+				if (i % 64 == 0) {
+					st.rebalance((i / 64) % 7);
+				}
+			}
+		});
+	}
+	for (auto & remover : removers) {
+		remover.join();
+	}
+
+	ASSERT_EQ(st.size(), (size_t)SHARDED_TESTSIZE / 2);
+	for (int i = 0; i < SHARDED_TESTSIZE; ++i) {
+		Node * lb = st.lower_bound(i);
+		ASSERT_NE(lb, nullptr);
+		ASSERT_EQ(lb->data, i | 1);
+	}
+}
+
+} // namespace sharded_tree
+} // namespace testing
+} // namespace ygg
+
+#endif // TEST_SHARDED_TREE_HPP
@@ -3,9 +3,12 @@
 
 #include <algorithm>
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <random>
+#include <string>
 #include <vector>
 
+#include "../src/list.hpp"
 #include "../src/ziptree.hpp"
 #include "randomizer.hpp"
 
@@ -54,6 +57,87 @@ public:
 	}
 };
 
+using OrderStatisticsOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                     TreeFlags::ORDER_STATISTICS,
+                     TreeFlags::ZTREE_RANK_TYPE<int>>;
+
+class OSNode : public ZTreeNodeBase<OSNode, OrderStatisticsOptions> {
+public:
+	int data;
+	int rank;
+
+	OSNode() : data(0), rank(0){};
+	OSNode(int data_in, int rank_in) : data(data_in), rank(rank_in){};
+
+	bool
+	operator<(const OSNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+class OSRankGetter {
+public:
+	static size_t
+	get_rank(const OSNode & n)
+	{
+		return (size_t)n.rank;
+	}
+};
+
+using FastRandomOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                     TreeFlags::ZTREE_RANK_TYPE<uint8_t>,
+                     TreeFlags::ZTREE_FAST_RANDOM>;
+
+class FastRandomNode : public ZTreeNodeBase<FastRandomNode, FastRandomOptions> {
+public:
+	int data;
+
+	FastRandomNode() : data(0){};
+	explicit FastRandomNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const FastRandomNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+class IndexNode;
+class IndexNodeArray {
+public:
+	static IndexNode * get_base();
+};
+
+using IndexLinkOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                     TreeFlags::ZTREE_RANK_TYPE<int>,
+                     TreeFlags::INDEX_LINKS<IndexNodeArray>>;
+
+class IndexNode : public ZTreeNodeBase<IndexNode, IndexLinkOptions> {
+public:
+	int data;
+
+	IndexNode() : data(0){};
+	explicit IndexNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const IndexNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+std::vector<IndexNode> index_nodes;
+
+IndexNode *
+IndexNodeArray::get_base()
+{
+	return index_nodes.data();
+}
+
 class NodeTraits : public ZTreeDefaultNodeTraits<Node> {
 public:
 	static std::string
@@ -440,6 +524,573 @@ TEST(ZipTreeTest, InsertionAndDeletionTest)
 	ASSERT_TRUE(iit == itree.end());
 }
 
+TEST(ZipTreeTest, BuildFromSortedTest)
+{
+	ExplicitRankTree tree;
+	ImplicitRankTree itree;
+
+	std::mt19937 rng(ZIPTREE_SEED);
+	std::uniform_int_distribution<int> rank_distr(0, 10);
+
+	Node nodes[ZIPTREE_TESTSIZE];
+	std::vector<HashRankNode *> inode_pointers;
+	HashRankNode inodes[ZIPTREE_TESTSIZE];
+
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		// Many rank ties
+		nodes[i] = Node((int)i, rank_distr(rng));
+		inodes[i].set_from(HashRankNode((int)i));
+		inode_pointers.push_back(&inodes[i]);
+	}
+
+	tree.build_from_sorted(nodes, nodes + ZIPTREE_TESTSIZE);
+	itree.build_from_sorted(inode_pointers.begin(), inode_pointers.end());
+
+	tree.dbg_verify();
+	itree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE);
+	ASSERT_EQ(itree.size(), ZIPTREE_TESTSIZE);
+
+	size_t i = 0;
+	for (auto & node : tree) {
+		ASSERT_EQ(&node, &nodes[i]);
+		i++;
+	}
+	ASSERT_EQ(i, ZIPTREE_TESTSIZE);
+
+	i = 0;
+	for (auto & node : itree) {
+		ASSERT_EQ(&node, &inodes[i]);
+		i++;
+	}
+	ASSERT_EQ(i, ZIPTREE_TESTSIZE);
+
+	// The trees must remain usable afterwards
+	for (size_t j = 0; j < ZIPTREE_TESTSIZE; j += 2) {
+		tree.remove(nodes[j]);
+		itree.remove(inodes[j]);
+	}
+	tree.dbg_verify();
+	itree.dbg_verify();
+
+	for (size_t j = 0; j < ZIPTREE_TESTSIZE; j += 2) {
+		tree.insert(nodes[j]);
+		itree.insert(inodes[j]);
+	}
+	tree.dbg_verify();
+	itree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE);
+}
+
+TEST(ZipTreeTest, BuildFromSortedEqualKeysTest)
+{
+	ExplicitRankTree tree;
+
+	Node nodes[ZIPTREE_TESTSIZE];
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		// Equal keys come with ascending ranks
+		nodes[i] = Node((int)(i / 10), (int)((i % 10) + ((i / 10) % 7)));
+	}
+
+	tree.build_from_sorted(nodes, nodes + ZIPTREE_TESTSIZE);
+	tree.dbg_verify();
+
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		ASSERT_TRUE(tree.find((int)(i / 10)) != tree.end());
+	}
+
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		tree.remove(nodes[i]);
+	}
+	tree.dbg_verify();
+	ASSERT_TRUE(tree.empty());
+}
+
+TEST(ZipTreeTest, SplitJoinTest)
+{
+	ExplicitRankTree tree;
+	ImplicitRankTree itree;
+
+	Node nodes[ZIPTREE_TESTSIZE];
+	HashRankNode inodes[ZIPTREE_TESTSIZE];
+
+	std::mt19937 rng(ZIPTREE_SEED);
+	std::uniform_int_distribution<int> rank_distr(0, 20);
+
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		// Every value occurs twice in the explicit tree
+		nodes[i] = Node((int)(i / 2), rank_distr(rng));
+		inodes[i].set_from(HashRankNode((int)i));
+		indices.push_back(i);
+	}
+
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+	for (auto index : indices) {
+		tree.insert(nodes[index]);
+		itree.insert(inodes[index]);
+	}
+
+	for (int split_at = -1; split_at <= (int)ZIPTREE_TESTSIZE;
+	     split_at += 1 + (int)ZIPTREE_TESTSIZE / 50) {
+		ExplicitRankTree right;
+		ImplicitRankTree iright;
+
+		tree.split(split_at, right);
+		itree.split(split_at, iright);
+
+		tree.dbg_verify();
+		right.dbg_verify();
+		itree.dbg_verify();
+		iright.dbg_verify();
+
+		size_t expected_left = (size_t)std::min(
+		    std::max(0, 2 * split_at), (int)ZIPTREE_TESTSIZE);
+		ASSERT_EQ(tree.size(), expected_left);
+		ASSERT_EQ(right.size(), ZIPTREE_TESTSIZE - expected_left);
+
+		for (auto & n : tree) {
+			ASSERT_LT(n.data, split_at);
+		}
+		for (auto & n : right) {
+			ASSERT_GE(n.data, split_at);
+		}
+		for (auto & n : itree) {
+			ASSERT_LT(n.data, split_at);
+		}
+		for (auto & n : iright) {
+			ASSERT_GE(n.data, split_at);
+		}
+
+		tree.join(right);
+		itree.join(iright);
+
+		tree.dbg_verify();
+		itree.dbg_verify();
+		ASSERT_TRUE(right.empty());
+		ASSERT_TRUE(iright.empty());
+		ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE);
+		ASSERT_EQ(itree.size(), ZIPTREE_TESTSIZE);
+	}
+
+	int i = 0;
+	for (auto & n : itree) {
+		ASSERT_EQ(n.data, i);
+		i++;
+	}
+}
+
+TEST(ZipTreeTest, OrderStatisticsTest)
+{
+	using Tree = ZTree<OSNode, ZTreeDefaultNodeTraits<OSNode>,
+	                   OrderStatisticsOptions, int,
+	                   ygg::rbtree_internal::flexible_less, OSRankGetter>;
+
+	std::mt19937 rng(ZIPTREE_SEED);
+	std::uniform_int_distribution<int> rank_distr(0, 20);
+
+	std::vector<OSNode> nodes;
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		nodes.push_back(OSNode((int)(i / 2), rank_distr(rng)));
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+
+	Tree tree;
+	for (auto index : indices) {
+		tree.insert(nodes[index]);
+	}
+	// Remove every third node again
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; i += 3) {
+		tree.remove(nodes[indices[i]]);
+	}
+	tree.dbg_verify();
+
+	std::vector<OSNode *> order;
+	for (auto & n : tree) {
+		order.push_back(&n);
+	}
+	ASSERT_EQ(order.size(), tree.size());
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		ASSERT_EQ(&*tree.select(i), order[i]);
+		ASSERT_EQ(tree.rank(*order[i]), i);
+	}
+	ASSERT_EQ(tree.select(order.size()), tree.end());
+
+	// Jumping iterators
+	for (size_t from = 0; from < order.size(); from += 11) {
+		for (size_t steps : {0ul, 1ul, 5ul, 100ul, order.size()}) {
+			auto it = tree.iterator_to(*order[from]);
+			it += steps;
+			if (from + steps < order.size()) {
+				ASSERT_EQ(&*it, order[from + steps]);
+			} else {
+				ASSERT_EQ(it, tree.end());
+			}
+
+			it = tree.iterator_to(*order[from]);
+			it -= steps;
+			if (steps <= from) {
+				ASSERT_EQ(&*it, order[from - steps]);
+				ASSERT_EQ(tree.iterator_to(*order[from]) - it, (ptrdiff_t)steps);
+			} else {
+				ASSERT_EQ(it, tree.end());
+			}
+		}
+	}
+	ASSERT_EQ(tree.end() - tree.begin(), (ptrdiff_t)order.size());
+
+	// The median of a sliding window
+	Tree right;
+	tree.split(OSNode((int)(ZIPTREE_TESTSIZE / 4), 0), right);
+	tree.dbg_verify();
+	right.dbg_verify();
+	ASSERT_EQ(&*right.select(right.size() / 2),
+	          &*(right.begin() + right.size() / 2));
+	tree.join(right);
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), order.size());
+
+	std::vector<OSNode> sorted;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		sorted.push_back(OSNode((int)i, rank_distr(rng)));
+	}
+	Tree built;
+	built.build_from_sorted(sorted.begin(), sorted.end());
+	built.dbg_verify();
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		ASSERT_EQ(&*built.select(i), &sorted[i]);
+	}
+}
+
+TEST(ZipTreeTest, IndexLinksTest)
+{
+	using Tree = ZTree<IndexNode, ZTreeDefaultNodeTraits<IndexNode>,
+	                   IndexLinkOptions>;
+
+	index_nodes.clear();
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		index_nodes.push_back(IndexNode((int)(i / 2)));
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+
+	Tree tree;
+	for (auto index : indices) {
+		tree.insert(index_nodes[index]);
+	}
+	tree.dbg_verify();
+
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; i += 3) {
+		tree.remove(index_nodes[indices[i]]);
+	}
+	tree.dbg_verify();
+
+	int last = -1;
+	for (auto & n : tree) {
+		ASSERT_GE(n.data, last);
+		last = n.data;
+	}
+
+	for (size_t i = 1; i < ZIPTREE_TESTSIZE; i += 3) {
+		IndexNode & n = index_nodes[indices[i]];
+		auto it = tree.find(n);
+		ASSERT_NE(it, tree.end());
+		ASSERT_EQ(it->data, n.data);
+	}
+}
+
+TEST(ZipTreeTest, FastRandomTest)
+{
+	using Tree = ZTree<FastRandomNode, ZTreeDefaultNodeTraits<FastRandomNode>,
+	                   FastRandomOptions>;
+
+	std::vector<FastRandomNode> nodes_a;
+	std::vector<FastRandomNode> nodes_b;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		nodes_a.push_back(FastRandomNode((int)(i / 2)));
+		nodes_b.push_back(FastRandomNode((int)(i / 2)));
+	}
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		indices.push_back(i);
+	}
+	std::shuffle(indices.begin(), indices.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+
+	// Equally seeded trees have equal shapes
+	Tree tree_a;
+	Tree tree_b;
+	tree_a.seed_ranks(ZIPTREE_SEED);
+	tree_b.seed_ranks(ZIPTREE_SEED);
+	for (auto index : indices) {
+		tree_a.insert(nodes_a[index]);
+		tree_b.insert(nodes_b[index]);
+	}
+	tree_a.dbg_verify();
+	tree_b.dbg_verify();
+
+	size_t max_depth = 0;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		ASSERT_EQ(nodes_a[i].get_depth(), nodes_b[i].get_depth());
+		max_depth = std::max(max_depth, nodes_a[i].get_depth());
+	}
+	// The expected depth is about 1.5 * log2(n)
+	ASSERT_LT(max_depth, 64u);
+
+	int last = -1;
+	for (auto & n : tree_a) {
+		ASSERT_GE(n.data, last);
+		last = n.data;
+	}
+
+	// Building from sorted nodes draws ranks as well, respecting equal keys
+	std::vector<FastRandomNode *> sorted;
+	for (auto & n : tree_b) {
+		sorted.push_back(&n);
+	}
+	tree_b.clear();
+	tree_b.build_from_sorted(sorted.begin(), sorted.end());
+	tree_b.dbg_verify();
+	for (auto * n : sorted) {
+		auto it = tree_b.find(*n);
+		ASSERT_NE(it, tree_b.end());
+		ASSERT_EQ(it->data, n->data);
+	}
+}
+
+// Packs the first eight characters into an integer, preserving their order
+class PrefixExtractor {
+public:
+	static uint64_t
+	get_cached_key(const std::string & s)
+	{
+		uint64_t prefix = 0;
+		for (size_t i = 0; i < 8; ++i) {
+			prefix <<= 8;
+			if (i < s.size()) {
+				prefix |= (uint8_t)s[i];
+			}
+		}
+		return prefix;
+	}
+
+	template <class StringNode>
+	static uint64_t
+	get_cached_key(const StringNode & n)
+	{
+		return get_cached_key(*n.key);
+	}
+};
+
+using CachedKeyOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                     TreeFlags::ZTREE_RANK_TYPE<uint8_t>,
+                     TreeFlags::ZTREE_FAST_RANDOM,
+                     TreeFlags::CACHED_KEY<PrefixExtractor, uint64_t>>;
+
+class StringNode : public ZTreeNodeBase<StringNode, CachedKeyOptions> {
+public:
+	const std::string * key;
+
+	explicit StringNode(const std::string * key_in) : key(key_in){};
+
+	bool
+	operator<(const StringNode & other) const
+	{
+		return *this->key < *other.key;
+	}
+};
+
+bool
+operator<(const StringNode & lhs, const std::string & rhs)
+{
+	return *lhs.key < rhs;
+}
+bool
+operator<(const std::string & lhs, const StringNode & rhs)
+{
+	return lhs < *rhs.key;
+}
+
+TEST(ZipTreeTest, CachedKeyTest)
+{
+	using Tree = ZTree<StringNode, ZTreeDefaultNodeTraits<StringNode>,
+	                   CachedKeyOptions>;
+
+	// Some keys share their prefixes, some don't
+	std::vector<std::string> keys;
+	for (size_t i = 0; i < ZIPTREE_TESTSIZE; ++i) {
+		if (i % 2 == 0) {
+			keys.push_back(std::to_string(1000000 + i));
+		} else {
+			keys.push_back(std::string("shared_prefix_") + std::to_string(i / 4));
+		}
+	}
+	std::shuffle(keys.begin(), keys.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+
+	std::vector<StringNode> nodes;
+	for (const auto & key : keys) {
+		nodes.push_back(StringNode(&key));
+	}
+
+	Tree tree;
+	tree.seed_ranks(ZIPTREE_SEED);
+	for (auto & n : nodes) {
+		tree.insert(n);
+	}
+	tree.dbg_verify();
+
+	std::vector<std::string> sorted_keys(keys);
+	std::sort(sorted_keys.begin(), sorted_keys.end());
+	auto key_it = sorted_keys.begin();
+	for (auto & n : tree) {
+		ASSERT_EQ(*n.key, *key_it);
+		key_it++;
+	}
+
+	for (auto & n : nodes) {
+		auto it = tree.find(*n.key);
+		ASSERT_NE(it, tree.end());
+		ASSERT_EQ(*it->key, *n.key);
+	}
+	ASSERT_EQ(tree.find(std::string("shared_prefix_x")), tree.end());
+
+	// Nodes that are not in the tree work as queries, even if their stored
+	// cached key is uninitialized or stale
+	for (const auto & key : keys) {
+		StringNode stale(nodes[0]);
+		stale.key = &key;
+
+		ASSERT_EQ(*tree.find(StringNode(&key))->key, key);
+		ASSERT_EQ(*tree.find(stale)->key, key);
+		ASSERT_EQ(*tree.lower_bound(stale)->key, key);
+		auto upper = tree.upper_bound(stale);
+		ASSERT_TRUE((upper == tree.end()) || (key < *upper->key));
+	}
+	std::string missing("shared_prefix_x");
+	ASSERT_EQ(tree.find(StringNode(&missing)), tree.end());
+
+	for (size_t i = 0; i < nodes.size(); i += 2) {
+		tree.remove(nodes[i]);
+	}
+	tree.dbg_verify();
+	for (size_t i = 1; i < nodes.size(); i += 2) {
+		ASSERT_NE(tree.find(*nodes[i].key), tree.end());
+	}
+}
+
+using RangeOptions =
+    ygg::TreeOptions<TreeFlags::MULTIPLE, TreeFlags::CONSTANT_TIME_SIZE,
+                     TreeFlags::ZTREE_RANK_TYPE<uint8_t>,
+                     TreeFlags::ZTREE_FAST_RANDOM>;
+
+class RangeNode : public ZTreeNodeBase<RangeNode, RangeOptions>,
+                  public ListNodeBase<RangeNode> {
+public:
+	int data;
+
+	explicit RangeNode(int data_in) : data(data_in){};
+
+	bool
+	operator<(const RangeNode & other) const
+	{
+		return this->data < other.data;
+	}
+};
+
+bool
+operator<(const RangeNode & lhs, int rhs)
+{
+	return lhs.data < rhs;
+}
+bool
+operator<(int lhs, const RangeNode & rhs)
+{
+	return lhs < rhs.data;
+}
+
+TEST(ZipTreeTest, RangeEraseTest)
+{
+	using Tree =
+	    ZTree<RangeNode, ZTreeDefaultNodeTraits<RangeNode>, RangeOptions>;
+
+	std::vector<RangeNode> nodes;
+	for (int i = 0; i < (int)ZIPTREE_TESTSIZE; ++i) {
+		// Every value occurs twice
+		nodes.push_back(RangeNode(i / 2));
+	}
+	std::vector<RangeNode *> shuffled;
+	for (auto & n : nodes) {
+		shuffled.push_back(&n);
+	}
+	std::shuffle(shuffled.begin(), shuffled.end(),
+	             ygg::testing::utilities::Randomizer(ZIPTREE_SEED));
+
+	Tree tree;
+	tree.seed_ranks(ZIPTREE_SEED);
+	for (auto * n : shuffled) {
+		tree.insert(*n);
+	}
+
+	// Empty ranges change nothing
+	tree.erase_range(-5, -1);
+	tree.erase_range(17, 17);
+	tree.erase_range((int)ZIPTREE_TESTSIZE, (int)ZIPTREE_TESTSIZE + 10);
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE);
+
+	// Erase [100, 200)
+	tree.erase_range(100, 200);
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE - 200);
+	for (auto & n : tree) {
+		ASSERT_TRUE(n.data < 100 || n.data >= 200);
+	}
+
+	// Extract [300, 350) into a list
+	List<RangeNode> extracted;
+	tree.extract_range(300, 350, extracted);
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE - 300);
+	ASSERT_EQ(extracted.size(), 100u);
+	int expected = 300;
+	size_t seen = 0;
+	for (auto & n : extracted) {
+		ASSERT_EQ(n.data, expected);
+		seen++;
+		if (seen % 2 == 0) {
+			expected++;
+		}
+	}
+	ASSERT_EQ(tree.find(325), tree.end());
+	ASSERT_NE(tree.find(350), tree.end());
+
+	// Extracted nodes can be reinserted
+	for (auto & n : extracted) {
+		tree.insert(n);
+	}
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE - 200);
+
+	// Erase everything at the borders, then everything
+	tree.erase_range(-1, 10);
+	tree.erase_range((int)ZIPTREE_TESTSIZE / 2 - 10, (int)ZIPTREE_TESTSIZE);
+	tree.dbg_verify();
+	ASSERT_EQ(tree.size(), ZIPTREE_TESTSIZE - 240);
+	tree.erase_range(-1, (int)ZIPTREE_TESTSIZE);
+	tree.dbg_verify();
+	ASSERT_TRUE(tree.empty());
+	ASSERT_EQ(tree.size(), 0u);
+}
+
 TEST(ZipTreeTest, ComprehensiveTest)
 {
 	ExplicitRankTree tree;